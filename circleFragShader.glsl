@@ -0,0 +1,47 @@
+#version 300 es
+
+// Distances of large circles are hundreds of pixels, so high precision is needed
+precision mediump int;
+precision highp float;
+
+const float PI = 3.14159265;
+
+in vec2 localPos;
+flat in float radius;
+flat in float halfWidth;
+flat in vec4 fillCol;
+flat in vec4 outlineCol;
+flat in vec3 lineStyle;
+out vec4 out_0;
+
+void main()
+{
+        float dashSize	= lineStyle.x;
+        float gapSize	= lineStyle.y;
+        float dotSize	= lineStyle.z;
+
+        // Signed distance from the circle in pixels, negative inside
+        float edge		= length(localPos) - radius;
+
+        float fillAlpha		= fillCol.a * (1.0 - smoothstep(-0.5, 0.5, edge));
+        float outlineAlpha	= outlineCol.a * (1.0 - smoothstep(halfWidth - 0.5, halfWidth + 0.5, abs(edge)));
+
+        // Dashes run clockwise from north along the arc, sized like those of lines
+        float angle		= atan(localPos.x, -localPos.y);
+        if (angle < 0.0)
+                angle += 2.0 * PI;
+        float phase		= fract(angle * radius / (dashSize + gapSize));
+
+        if (phase > dashSize/(dashSize + gapSize))
+                outlineAlpha = 0.0;
+        if ((dotSize!=0.0) && (phase > 0.05) && (phase < 0.15))
+                outlineAlpha = 0.0;
+
+        // Outline over the inline
+        float alpha		= outlineAlpha + fillAlpha * (1.0 - outlineAlpha);
+        if (alpha <= 0.0)
+                discard;
+
+        vec3 colour		= (outlineCol.rgb * outlineAlpha + fillCol.rgb * fillAlpha * (1.0 - outlineAlpha)) / alpha;
+        out_0			= vec4(colour, alpha);
+}
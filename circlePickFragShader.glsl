@@ -0,0 +1,20 @@
+#version 300 es
+
+// Distances of large circles are hundreds of pixels, so high precision is needed
+precision highp int;
+precision highp float;
+
+in vec2 localPos;
+flat in float radius;
+flat in float halfWidth;
+flat in highp uint pickId;
+out highp uint out_0;
+
+void main()
+{
+        // Inline and outline are pickable, the corners of the quad are not
+        if (length(localPos) - radius > halfWidth + 0.5)
+                discard;
+
+        out_0 = pickId;
+}
@@ -0,0 +1,54 @@
+#version 300 es
+
+// Centres are in world space, so high precision is needed
+precision mediump int;
+precision highp float;
+
+// Quad corner, -1..1 with Y down like the view pixels
+in vec2 entityCorner;
+
+// Per circle (instance) attributes
+in vec2 instanceCentre;		// world space
+in float instanceRadius;	// world units
+in float instanceLineWidth;	// pixels
+in vec4 instanceColours;	// palette index and opacity of the fill, then of the outline
+in vec4 instanceLineStyle;	// dash, gap and dot size in pixels
+in float instancePickId;	// drawn by the pick pass instead of the colour
+
+out vec2 localPos;			// pixels from the centre
+flat out float radius;		// pixels
+flat out float halfWidth;	// half the outline width in pixels
+flat out vec4 fillCol;
+flat out vec4 outlineCol;
+flat out vec3 lineStyle;
+flat out highp uint pickId;
+
+uniform mat4 entityMvp;			// view pixels to clip space
+uniform mat4 u_worldToPixel;	// world space to view pixels
+uniform float u_pixelsPerWorldUnit;
+uniform highp sampler2D u_palette;	// colour of every palette index
+
+// Must match CUserMapsPalette
+vec4 paletteColour(float index, float opacity)
+{
+   int i			= int(index + 0.5);
+   int width		= textureSize(u_palette, 0).x;
+   vec4 colour	= texelFetch(u_palette, ivec2(i % width, i / width), 0);
+   return vec4(colour.rgb, opacity);
+}
+
+void main()
+{
+   vec4 centre	= u_worldToPixel * vec4(instanceCentre, 0.0, 1.0);
+   radius		= instanceRadius * u_pixelsPerWorldUnit;
+   halfWidth	= 0.5 * max(instanceLineWidth, 1.0);
+
+   // Quad covers the outline and a pixel of antialiasing around it
+   localPos		= entityCorner * (radius + halfWidth + 1.0);
+
+   fillCol		= paletteColour(instanceColours.x, instanceColours.y);
+   outlineCol	= paletteColour(instanceColours.z, instanceColours.w);
+   lineStyle	= instanceLineStyle.xyz;
+   pickId		= uint(instancePickId + 0.5);
+   gl_Position	= entityMvp * vec4(centre.xy + localPos, 0.0, 1.0);
+}
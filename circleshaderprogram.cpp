@@ -0,0 +1,211 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	circleshaderprogram.cpp
+///
+///	\author	ELREG
+///
+///	\brief	shader used for drawing user map circles, one instanced quad each.
+///
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "circleshaderprogram.h"
+#include <cstddef>
+
+static const int INSTANCE_ATTRIBUTES = 6; ///< Per circle attributes of CircleInstanceData.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CCircleShaderProgram::CCircleShaderProgram(bool isPickPass)
+///
+/// \brief  Constructor
+///
+/// \param  isPickPass - true to draw pick ids instead of the circles.
+////////////////////////////////////////////////////////////////////////////////
+CCircleShaderProgram::CCircleShaderProgram(bool isPickPass)
+	: CShaderProgram (new QOpenGLShaderProgram())
+	, m_shMvpMatrixLoc( nullptr )
+	, m_shPixelsPerWorldUnitLoc( nullptr )
+{
+	circleShaderSetup(isPickPass);
+
+	m_shMvpMatrixLoc = QSharedPointer<CShaderProgramUniform>(new CShaderProgramUniform(CShaderProgram(m_pShaderProgram), "entityMvp"));
+	m_shPixelsPerWorldUnitLoc = QSharedPointer<CShaderProgramUniform>(new CShaderProgramUniform(CShaderProgram(m_pShaderProgram), "u_pixelsPerWorldUnit"));
+	m_shWorldToPixelLoc = m_pShaderProgram->uniformLocation("u_worldToPixel");
+	m_shPaletteLoc = m_pShaderProgram->uniformLocation("u_palette");
+	m_shCornerLocation = m_pShaderProgram->attributeLocation("entityCorner");
+	m_shCentreLocation = m_pShaderProgram->attributeLocation("instanceCentre");
+	m_shRadiusLocation = m_pShaderProgram->attributeLocation("instanceRadius");
+	m_shLineWidthLocation = m_pShaderProgram->attributeLocation("instanceLineWidth");
+	m_shColoursLocation = m_pShaderProgram->attributeLocation("instanceColours");
+	m_shLineStyleLocation = m_pShaderProgram->attributeLocation("instanceLineStyle");
+	m_shPickIdLocation = m_pShaderProgram->attributeLocation("instancePickId");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CCircleShaderProgram::~CCircleShaderProgram()
+///
+/// \brief  Destructor
+////////////////////////////////////////////////////////////////////////////////
+CCircleShaderProgram::~CCircleShaderProgram()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CCircleShaderProgram::circleShaderSetup(bool isPickPass)
+///
+/// \brief  shader setup.
+///
+/// \param  isPickPass - true to link the pick fragment shader.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::circleShaderSetup( bool isPickPass )
+{
+	// Compile vertex shader
+	if (!m_pShaderProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/circleVertexShader.glsl"))
+	{
+		qDebug() << m_pShaderProgram->log();
+		qDebug() << "m_pShaderProgram->addShaderFromSourceFile QOpenGLShader::Vertex failed!";
+	}
+
+	// Compile fragment shader
+	if (!m_pShaderProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, isPickPass ? ":/circlePickFragShader.glsl" : ":/circleFragShader.glsl"))
+		qDebug() << "m_pShaderProgram->addShaderFromSourceFile QOpenGLShader::Fragment failed!";
+
+	// Link shader pipeline
+	if (!m_pShaderProgram->link())
+		qDebug() << "m_pShaderProgram->link() failed!";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CCircleShaderProgram::bind()
+///
+/// \brief  shader binding.
+///
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::bind()
+{
+	m_pShaderProgram->bind();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CCircleShaderProgram::release()
+///
+/// \brief  shader releasing.
+///
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::release()
+{
+	m_pShaderProgram->release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CCircleShaderProgram::setMVPMatrix(QMatrix4x4 mvp)
+///
+/// \brief  set model view projection matrix.
+///
+/// \param  mvp - model view projection matrix.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::setMVPMatrix(QMatrix4x4 mvp)
+{
+	m_shMvpMatrixLoc->setValue(mvp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CCircleShaderProgram::setWorldToPixel(const QMatrix4x4 &worldToPixel)
+///
+/// \brief  set transformation of circle centres into view pixels.
+///
+/// \param  worldToPixel - world space to view pixels matrix.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::setWorldToPixel(const QMatrix4x4 &worldToPixel)
+{
+	m_pShaderProgram->setUniformValue(m_shWorldToPixelLoc, worldToPixel);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CCircleShaderProgram::setPixelsPerWorldUnit(float pixelsPerWorldUnit)
+///
+/// \brief  set view scale used to size the circles.
+///
+/// \param  pixelsPerWorldUnit - view pixels per world unit.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::setPixelsPerWorldUnit(float pixelsPerWorldUnit)
+{
+	m_shPixelsPerWorldUnitLoc->setValue(pixelsPerWorldUnit);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CCircleShaderProgram::setPaletteSampler(int unit)
+///
+/// \brief  set the texture unit the palette is bound to. Fill and outline
+///         colours are looked up in it by palette index.
+///
+/// \param  unit - texture unit.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::setPaletteSampler(int unit)
+{
+	m_pShaderProgram->setUniformValue(m_shPaletteLoc, unit);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CCircleShaderProgram::setupVertexState()
+///
+/// \brief  set quad corner data from the bound quad buffer.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::setupVertexState()
+{
+	// Tell OpenGL programmable pipeline how to locate quad corners
+	m_pShaderProgram->enableAttributeArray(m_shCornerLocation);
+	m_pShaderProgram->setAttributeBuffer(m_shCornerLocation, GL_FLOAT, 0, 2, sizeof(QVector2D));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CCircleShaderProgram::setupInstanceState(QOpenGLExtraFunctions *func)
+///
+/// \brief  set per circle data from the bound instance buffer (CircleInstanceData),
+///         advanced once per instance.
+///
+/// \param  func - OpenGL ES 3.0 functions.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::setupInstanceState(QOpenGLExtraFunctions *func)
+{
+	const int stride = sizeof(CircleInstanceData);
+	const GLint locations[INSTANCE_ATTRIBUTES] = { m_shCentreLocation, m_shRadiusLocation, m_shLineWidthLocation,
+												   m_shColoursLocation, m_shLineStyleLocation, m_shPickIdLocation };
+	const int offsets[INSTANCE_ATTRIBUTES] = { offsetof(CircleInstanceData, m_centre), offsetof(CircleInstanceData, m_radius),
+											   offsetof(CircleInstanceData, m_lineWidth), offsetof(CircleInstanceData, m_colours),
+											   offsetof(CircleInstanceData, m_lineStyle), offsetof(CircleInstanceData, m_pickId) };
+	const int sizes[INSTANCE_ATTRIBUTES] = { 2, 1, 1, 4, 4, 1 };
+
+	for (int i = 0; i < INSTANCE_ATTRIBUTES; ++i)
+	{
+		// Attributes a program does not use (pick id when drawing circles, colours when picking) have no location
+		if ( locations[i] < 0 )
+			continue;
+
+		m_pShaderProgram->enableAttributeArray(locations[i]);
+		m_pShaderProgram->setAttributeBuffer(locations[i], GL_FLOAT, offsets[i], sizes[i], stride);
+		func->glVertexAttribDivisor(static_cast<GLuint>(locations[i]), 1);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CCircleShaderProgram::cleanupVertexState(QOpenGLExtraFunctions *func)
+///
+/// \brief  clean quad corner and instance data.
+///
+/// \param  func - OpenGL ES 3.0 functions.
+////////////////////////////////////////////////////////////////////////////////
+void CCircleShaderProgram::cleanupVertexState(QOpenGLExtraFunctions *func)
+{
+	m_pShaderProgram->disableAttributeArray(m_shCornerLocation);
+
+	const GLint locations[INSTANCE_ATTRIBUTES] = { m_shCentreLocation, m_shRadiusLocation, m_shLineWidthLocation,
+												   m_shColoursLocation, m_shLineStyleLocation, m_shPickIdLocation };
+	for (int i = 0; i < INSTANCE_ATTRIBUTES; ++i)
+	{
+		if ( locations[i] < 0 )
+			continue;
+
+		func->glVertexAttribDivisor(static_cast<GLuint>(locations[i]), 0);
+		m_pShaderProgram->disableAttributeArray(locations[i]);
+	}
+}
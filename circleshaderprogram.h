@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	circleshaderprogram.h
+///
+///	\author	ELREG
+///
+///	\brief	shader used for drawing user map circles, one instanced quad each.
+///
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QVector2D>
+#include <QVector4D>
+
+#include "../OpenGLBaseLib/shaderprogram.h"
+#include "../OpenGLBaseLib/shaderprogramuniform.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///  \brief	Per instance data of one drawn circle.
+///
+////////////////////////////////////////////////////////////////////////////////
+struct CircleInstanceData
+{
+	QVector2D m_centre;			///< Centre in world space.
+	float m_radius;				///< Radius in world units.
+	float m_lineWidth;			///< Outline width in pixels.
+	QVector4D m_colours;		///< Palette index and opacity of the inline, then of the outline.
+	QVector4D m_lineStyle;		///< Dash, gap and dot size of the outline in pixels.
+	float m_pickId;				///< Pick id of the circle, drawn by the pick pass.
+};
+
+class CCircleShaderProgram : public CShaderProgram
+{
+public:
+	explicit CCircleShaderProgram(bool isPickPass = false);
+	virtual ~CCircleShaderProgram();
+
+	void circleShaderSetup( bool isPickPass );
+
+	void bind();
+	void release();
+
+	void setMVPMatrix(QMatrix4x4 mvp);
+	void setWorldToPixel(const QMatrix4x4 &worldToPixel);
+	void setPixelsPerWorldUnit(float pixelsPerWorldUnit);
+	void setPaletteSampler(int unit);
+	void setupVertexState();
+	void setupInstanceState(QOpenGLExtraFunctions *func);
+	void cleanupVertexState(QOpenGLExtraFunctions *func);
+
+private:
+	QSharedPointer<CShaderProgramUniform> m_shMvpMatrixLoc;
+	QSharedPointer<CShaderProgramUniform> m_shPixelsPerWorldUnitLoc;
+
+	int m_shWorldToPixelLoc;
+	int m_shPaletteLoc;
+
+	// Attributes
+	GLint m_shCornerLocation;
+	GLint m_shCentreLocation;
+	GLint m_shRadiusLocation;
+	GLint m_shLineWidthLocation;
+	GLint m_shColoursLocation;
+	GLint m_shLineStyleLocation;
+	GLint m_shPickIdLocation;
+
+};
@@ -0,0 +1,18 @@
+#version 300 es
+
+// Set default precision to medium
+precision mediump int;
+precision mediump float;
+
+in vec2 texCoord;
+in vec4 col;
+out vec4 out_0;
+
+uniform sampler2D	u_texture;
+
+void main()
+{
+        // Icons are stored untinted, the point colour is applied here
+        vec4 texel	= texture(u_texture, texCoord);
+        out_0		= vec4(texel.rgb * col.rgb, texel.a * col.a);
+}
@@ -0,0 +1,44 @@
+#version 300 es
+
+// Positions are in world space, so high precision is needed
+precision mediump int;
+precision highp float;
+
+// Quad corner, -1..1 with Y down like the view pixels and the atlas image
+in vec2 entityCorner;
+
+// Per point (instance) attributes
+in vec2 instancePos;		// world space
+in vec2 instanceCol;		// palette index and opacity of the tint colour
+in vec4 instanceTexRect;	// left, top, width, height in the atlas
+in vec2 instanceSize;		// icon size in mm
+in float instancePickId;	// drawn by the pick pass instead of the colour
+
+out vec2 texCoord;
+out vec4 col;
+flat out highp uint pickId;
+
+uniform mat4 entityMvp;			// view pixels to clip space
+uniform mat4 u_worldToPixel;	// world space to view pixels
+uniform float u_pixelsPerMm;
+uniform highp sampler2D u_palette;	// colour of every palette index
+
+// Must match CUserMapsPalette
+vec4 paletteColour(float index, float opacity)
+{
+   int i			= int(index + 0.5);
+   int width		= textureSize(u_palette, 0).x;
+   vec4 colour	= texelFetch(u_palette, ivec2(i % width, i / width), 0);
+   return vec4(colour.rgb, opacity);
+}
+
+void main()
+{
+   vec4 centre	= u_worldToPixel * vec4(instancePos, 0.0, 1.0);
+   vec2 offset	= entityCorner * instanceSize * (0.5 * u_pixelsPerMm);
+
+   col			= paletteColour(instanceCol.x, instanceCol.y);
+   pickId		= uint(instancePickId + 0.5);
+   texCoord		= instanceTexRect.xy + (entityCorner * 0.5 + 0.5) * instanceTexRect.zw;
+   gl_Position	= entityMvp * vec4(centre.xy + offset, 0.0, 1.0);
+}
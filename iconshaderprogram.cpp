@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	iconshaderprogram.cpp
+///
+///	\author	ELREG
+///
+///	\brief	shader used for drawing user map point icons from the icon atlas.
+///
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "iconshaderprogram.h"
+#include <cstddef>
+
+static const int INSTANCE_ATTRIBUTES = 5; ///< Per point attributes of IconInstanceData.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CIconShaderProgram::CIconShaderProgram(bool isPickPass)
+///
+/// \brief  Constructor
+///
+/// \param  isPickPass - true to draw pick ids instead of the icons.
+////////////////////////////////////////////////////////////////////////////////
+CIconShaderProgram::CIconShaderProgram(bool isPickPass)
+	: CShaderProgram (new QOpenGLShaderProgram())
+	, m_shMvpMatrixLoc( nullptr )
+	, m_shPixelsPerMmLoc( nullptr )
+{
+	iconShaderSetup(isPickPass);
+
+	m_shMvpMatrixLoc = QSharedPointer<CShaderProgramUniform>(new CShaderProgramUniform(CShaderProgram(m_pShaderProgram), "entityMvp"));
+	m_shPixelsPerMmLoc = QSharedPointer<CShaderProgramUniform>(new CShaderProgramUniform(CShaderProgram(m_pShaderProgram), "u_pixelsPerMm"));
+	m_shWorldToPixelLoc = m_pShaderProgram->uniformLocation("u_worldToPixel");
+	m_shTextureLoc = m_pShaderProgram->uniformLocation("u_texture");
+	m_shPaletteLoc = m_pShaderProgram->uniformLocation("u_palette");
+	m_shCornerLocation = m_pShaderProgram->attributeLocation("entityCorner");
+	m_shPositionLocation = m_pShaderProgram->attributeLocation("instancePos");
+	m_shColLocation = m_pShaderProgram->attributeLocation("instanceCol");
+	m_shTexRectLocation = m_pShaderProgram->attributeLocation("instanceTexRect");
+	m_shSizeLocation = m_pShaderProgram->attributeLocation("instanceSize");
+	m_shPickIdLocation = m_pShaderProgram->attributeLocation("instancePickId");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CIconShaderProgram::~CIconShaderProgram()
+///
+/// \brief  Destructor
+////////////////////////////////////////////////////////////////////////////////
+CIconShaderProgram::~CIconShaderProgram()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CIconShaderProgram::iconShaderSetup(bool isPickPass)
+///
+/// \brief  shader setup.
+///
+/// \param  isPickPass - true to link the pick fragment shader.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::iconShaderSetup( bool isPickPass )
+{
+	// Compile vertex shader
+	if (!m_pShaderProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/iconVertexShader.glsl"))
+	{
+		qDebug() << m_pShaderProgram->log();
+		qDebug() << "m_pShaderProgram->addShaderFromSourceFile QOpenGLShader::Vertex failed!";
+	}
+
+	// Compile fragment shader
+	if (!m_pShaderProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, isPickPass ? ":/pickFragShader.glsl" : ":/iconFragShader.glsl"))
+		qDebug() << "m_pShaderProgram->addShaderFromSourceFile QOpenGLShader::Fragment failed!";
+
+	// Link shader pipeline
+	if (!m_pShaderProgram->link())
+		qDebug() << "m_pShaderProgram->link() failed!";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CIconShaderProgram::bind()
+///
+/// \brief  shader binding.
+///
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::bind()
+{
+	m_pShaderProgram->bind();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CIconShaderProgram::release()
+///
+/// \brief  shader releasing.
+///
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::release()
+{
+	m_pShaderProgram->release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::setMVPMatrix(QMatrix4x4 mvp)
+///
+/// \brief  set model view projection matrix.
+///
+/// \param  mvp - model view projection matrix.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::setMVPMatrix(QMatrix4x4 mvp)
+{
+	m_shMvpMatrixLoc->setValue(mvp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::setWorldToPixel(const QMatrix4x4 &worldToPixel)
+///
+/// \brief  set transformation of icon positions into view pixels.
+///
+/// \param  worldToPixel - world space to view pixels matrix.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::setWorldToPixel(const QMatrix4x4 &worldToPixel)
+{
+	m_pShaderProgram->setUniformValue(m_shWorldToPixelLoc, worldToPixel);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::setPixelsPerMm(float pixelsPerMm)
+///
+/// \brief  set screen resolution used to size the icons.
+///
+/// \param  pixelsPerMm - screen pixels per millimetre.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::setPixelsPerMm(float pixelsPerMm)
+{
+	m_shPixelsPerMmLoc->setValue(pixelsPerMm);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::setTextureSampler(int unit)
+///
+/// \brief  set the texture unit the atlas is bound to.
+///
+/// \param  unit - texture unit.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::setTextureSampler(int unit)
+{
+	m_pShaderProgram->setUniformValue(m_shTextureLoc, unit);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::setPaletteSampler(int unit)
+///
+/// \brief  set the texture unit the palette is bound to. The tint colour
+///         of the icons is looked up in it by palette index.
+///
+/// \param  unit - texture unit.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::setPaletteSampler(int unit)
+{
+	m_pShaderProgram->setUniformValue(m_shPaletteLoc, unit);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::setupVertexState()
+///
+/// \brief  set quad corner data from the bound quad buffer.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::setupVertexState()
+{
+	// Tell OpenGL programmable pipeline how to locate quad corners
+	m_pShaderProgram->enableAttributeArray(m_shCornerLocation);
+	m_pShaderProgram->setAttributeBuffer(m_shCornerLocation, GL_FLOAT, 0, 2, sizeof(QVector2D));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::setupInstanceState(QOpenGLExtraFunctions *func)
+///
+/// \brief  set per icon data from the bound instance buffer (IconInstanceData),
+///         advanced once per instance.
+///
+/// \param  func - OpenGL ES 3.0 functions.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::setupInstanceState(QOpenGLExtraFunctions *func)
+{
+	const int stride = sizeof(IconInstanceData);
+	const GLint locations[INSTANCE_ATTRIBUTES] = { m_shPositionLocation, m_shColLocation, m_shTexRectLocation,
+												   m_shSizeLocation, m_shPickIdLocation };
+	const int offsets[INSTANCE_ATTRIBUTES] = { offsetof(IconInstanceData, m_position), offsetof(IconInstanceData, m_colour),
+											   offsetof(IconInstanceData, m_textureRect), offsetof(IconInstanceData, m_sizeMm),
+											   offsetof(IconInstanceData, m_pickId) };
+	const int sizes[INSTANCE_ATTRIBUTES] = { 2, 2, 4, 2, 1 };
+
+	for (int i = 0; i < INSTANCE_ATTRIBUTES; ++i)
+	{
+		// Attributes a program does not use (pick id when drawing icons) have no location
+		if ( locations[i] < 0 )
+			continue;
+
+		m_pShaderProgram->enableAttributeArray(locations[i]);
+		m_pShaderProgram->setAttributeBuffer(locations[i], GL_FLOAT, offsets[i], sizes[i], stride);
+		func->glVertexAttribDivisor(static_cast<GLuint>(locations[i]), 1);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn    CIconShaderProgram::cleanupVertexState(QOpenGLExtraFunctions *func)
+///
+/// \brief  clean quad corner and instance data.
+///
+/// \param  func - OpenGL ES 3.0 functions.
+////////////////////////////////////////////////////////////////////////////////
+void CIconShaderProgram::cleanupVertexState(QOpenGLExtraFunctions *func)
+{
+	m_pShaderProgram->disableAttributeArray(m_shCornerLocation);
+
+	const GLint locations[INSTANCE_ATTRIBUTES] = { m_shPositionLocation, m_shColLocation, m_shTexRectLocation,
+												   m_shSizeLocation, m_shPickIdLocation };
+	for (int i = 0; i < INSTANCE_ATTRIBUTES; ++i)
+	{
+		if ( locations[i] < 0 )
+			continue;
+
+		func->glVertexAttribDivisor(static_cast<GLuint>(locations[i]), 0);
+		m_pShaderProgram->disableAttributeArray(locations[i]);
+	}
+}
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	iconshaderprogram.h
+///
+///	\author	ELREG
+///
+///	\brief	shader used for drawing user map point icons from the icon atlas.
+///
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QVector2D>
+#include <QVector4D>
+
+#include "../OpenGLBaseLib/shaderprogram.h"
+#include "../OpenGLBaseLib/shaderprogramuniform.h"
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///  \brief	Per instance data of one drawn icon.
+///
+////////////////////////////////////////////////////////////////////////////////
+struct IconInstanceData
+{
+	QVector2D m_position;		///< Position in world space.
+	QVector2D m_colour;			///< Palette index and opacity of the tint colour.
+	QVector4D m_textureRect;	///< Left, top, width and height of the icon in the atlas.
+	QVector2D m_sizeMm;			///< Icon size in millimetres.
+	float m_pickId;				///< Pick id of the point, drawn by the pick pass.
+};
+
+class CIconShaderProgram : public CShaderProgram
+{
+public:
+	explicit CIconShaderProgram(bool isPickPass = false);
+	virtual ~CIconShaderProgram();
+
+	void iconShaderSetup( bool isPickPass );
+
+	void bind();
+	void release();
+
+	void setMVPMatrix(QMatrix4x4 mvp);
+	void setWorldToPixel(const QMatrix4x4 &worldToPixel);
+	void setPixelsPerMm(float pixelsPerMm);
+	void setTextureSampler(int unit);
+	void setPaletteSampler(int unit);
+	void setupVertexState();
+	void setupInstanceState(QOpenGLExtraFunctions *func);
+	void cleanupVertexState(QOpenGLExtraFunctions *func);
+
+private:
+	QSharedPointer<CShaderProgramUniform> m_shMvpMatrixLoc;
+	QSharedPointer<CShaderProgramUniform> m_shPixelsPerMmLoc;
+
+	int m_shWorldToPixelLoc;
+	int m_shTextureLoc;
+	int m_shPaletteLoc;
+
+	// Attributes
+	GLint m_shCornerLocation;
+	GLint m_shPositionLocation;
+	GLint m_shColLocation;
+	GLint m_shTexRectLocation;
+	GLint m_shSizeLocation;
+	GLint m_shPickIdLocation;
+
+};
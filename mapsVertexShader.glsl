@@ -1,25 +1,66 @@
 #version 300 es
 
-// Set default precision to medium
-precision mediump int;
-precision mediump float;
+// Positions are in world space and style table indices can be large,
+// so high precision is needed
+precision highp int;
+precision highp float;
 
-in vec4 entityPos;
-in vec4 entityCol;
+in vec2 entityPos;		// world space
+in uint entitySlot;		// style table slot of the object
 
 flat out vec4 startPos;
 out vec4 vertPos;
 
 out vec4 col;
+flat out vec3 lineStyle;	// dash, gap and dot size
+flat out uint pickId;		// drawn by the pick pass instead of the colour
 
 uniform mat4 entityMvp;
+uniform highp sampler2D u_styleTable;
+uniform highp sampler2D u_palette;	// colour of every palette index
+uniform bool u_isFill;		// true to draw triangles in the fill colour of the object
+
+// Must match CUserMapsStyleTable
+const int TEXELS_PER_SLOT	= 2;
+const int LINE_STYLE_TEXEL	= 0;	// dash, gap and dot size, pick id
+const int COLOUR_TEXEL		= 1;	// palette index and opacity of the fill, then of the outline
+
+vec4 styleTexel(int slot, int texel)
+{
+   int index		= slot * TEXELS_PER_SLOT + texel;
+   int width		= textureSize(u_styleTable, 0).x;
+   return texelFetch(u_styleTable, ivec2(index % width, index / width), 0);
+}
+
+// Must match CUserMapsPalette
+vec4 paletteColour(float index, float opacity)
+{
+   int i			= int(index + 0.5);
+   int width		= textureSize(u_palette, 0).x;
+   vec4 colour	= texelFetch(u_palette, ivec2(i % width, i / width), 0);
+   return vec4(colour.rgb, opacity);
+}
 
 void main()
 {
-   col 			= entityCol;
-   vec4 pos	 	= entityMvp * entityPos;
+   // Colour and line style of the object from the style table
+   int slot		= int(entitySlot);
+   vec4 colours	= styleTexel(slot, COLOUR_TEXEL);
+   vec4 style		= styleTexel(slot, LINE_STYLE_TEXEL);
+   pickId		= uint(style.w + 0.5);
+   if (u_isFill)
+   {
+      col		= paletteColour(colours.x, colours.y);
+      lineStyle	= vec3(1.0, 0.0, 0.0);	// solid
+   }
+   else
+   {
+      col		= paletteColour(colours.z, colours.w);
+      lineStyle	= style.xyz;
+   }
+
+   vec4 pos	 	= entityMvp * vec4(entityPos, 0.0, 1.0);
    gl_Position 	= pos;
    vertPos		= pos;
    startPos		= vertPos;
 }
-
@@ -0,0 +1,14 @@
+#version 300 es
+
+// Pick ids can be large, so high precision is needed
+precision highp int;
+precision mediump float;
+
+flat in highp uint pickId;
+out highp uint out_0;
+
+void main()
+{
+        // Whole primitive is pickable, dashes and transparent texels included
+        out_0 = pickId;
+}
@@ -1,211 +1,939 @@
-////////////////////////////////////////////////////////////////////////////////
-///	\file	triangulate.cpp
-///
-///	\author	ELREG, most of the code from
-///         https://www.flipcode.com/archives/Efficient_Polygon_Triangulation.shtml
-///
-///	\brief	Implementation of the Triangulate class
-///         which triangulates any polygon without hole.
-///
-///	(C) Kelvin Hughes, 2020.
-////////////////////////////////////////////////////////////////////////////////
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <assert.h>
-#include "triangulate.h"
-
-static const float EPSILON = 0.0000000001f; ///< Used to denote a small quantity, error offset.
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn float Triangulate::Area(const Vector2dVector &contour)
-///
-/// \brief  Computes an area of contour.
-///
-/// \param  contour - Contour area.
-///
-/// \return Returns calculated area of polygon.
-////////////////////////////////////////////////////////////////////////////////
-float Triangulate::Area(const Vector2dVector &contour)
-{
-	int n = contour.size();
-	float A = 0.0f;
-
-	for(int p = n-1, q = 0; q < n; p = q++)
-	{
-		A+= contour[p].position().x()*contour[q].position().y() -
-				contour[q].position().x()*contour[p].position().y();
-	}
-	return A*0.5f;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn bool Triangulate::InsideTriangle(float Ax, float Ay,
-///                                      float Bx, float By,
-///                                      float Cx, float Cy,
-///                                      float Px, float Py)
-///
-/// \brief  Checks if a point P is inside the triangle
-///         defined by points A, B, and C.
-///
-/// \param  Ax - Value on xAxis for point A.
-///         Ay - Value on yAxis for point A.
-///         Bx - Value on xAxis for point B.
-///         By - Value on yAxis for point B.
-///         Cx - Value on xAxis for point C.
-///         Cy - Value on yAxis for point C.
-///         Px - Value on xAxis for point P.
-///         Py - Value on yAxis for point P.
-///
-/// \return Returns true when the point lies inside triangle,
-///         otherwise false.
-////////////////////////////////////////////////////////////////////////////////
-bool Triangulate::InsideTriangle(float Ax, float Ay,
-								 float Bx, float By,
-								 float Cx, float Cy,
-								 float Px, float Py)
-
-{
-	float ax, ay, bx, by, cx, cy, apx, apy, bpx, bpy, cpx, cpy;
-	float cCROSSap, bCROSScp, aCROSSbp;
-
-	ax = Cx - Bx;  ay = Cy - By;
-	bx = Ax - Cx;  by = Ay - Cy;
-	cx = Bx - Ax;  cy = By - Ay;
-	apx= Px - Ax;  apy= Py - Ay;
-	bpx= Px - Bx;  bpy= Py - By;
-	cpx= Px - Cx;  cpy= Py - Cy;
-
-	aCROSSbp = ax*bpy - ay*bpx;
-	cCROSSap = cx*apy - cy*apx;
-	bCROSScp = bx*cpy - by*cpx;
-
-	return ((aCROSSbp >= 0.0f) && (bCROSScp >= 0.0f) && (cCROSSap >= 0.0f));
-};
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn bool Triangulate::Snip(const Vector2dVector &contour,int u,int v,int w,int n,int *V)
-///
-/// \brief  Checks if consecutive points can form closed polygon.
-///
-/// \param  contour - Contour area.
-///         u - Three consecutive vertices in polygon - previous
-///         v - Three consecutive vertices in polygon - current
-///         w - Three consecutive vertices in polygon - next
-///         n - Number of vertices in polygon
-///         V - Vector of polygon points as series of Triangles
-///
-/// \return Returns true if given consequtive points can be points of a polygon
-///         (polygon created successfully), otherwise false.
-////////////////////////////////////////////////////////////////////////////////
-bool Triangulate::Snip(const Vector2dVector &contour,int u,int v,int w,int n,int *V)
-{
-	int p;
-	float Ax, Ay, Bx, By, Cx, Cy, Px, Py;
-
-	Ax = contour[V[u]].position().x();
-	Ay = contour[V[u]].position().y();
-
-	Bx = contour[V[v]].position().x();
-	By = contour[V[v]].position().y();
-
-	Cx = contour[V[w]].position().x();
-	Cy = contour[V[w]].position().y();
-
-	if ( EPSILON > (((Bx-Ax)*(Cy-Ay)) - ((By-Ay)*(Cx-Ax))) )
-		return false;
-
-	for (p = 0; p < n; p++)
-	{
-		if( (p == u) || (p == v) || (p == w) )
-			continue;
-		Px = contour[V[p]].position().x();
-		Py = contour[V[p]].position().y();
-		if (InsideTriangle(Ax,Ay,Bx,By,Cx,Cy,Px,Py))
-			return false;
-	}
-	return true;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn bool Triangulate::Process(const Vector2dVector &contour, Vector2dVector &result)
-///
-/// \brief  Triangulate a contour/polygon and places results in a vector
-///         as series of triangles.
-///
-/// \param  contour - Contour area.
-///         result  - A vector containing a series of triangles.
-///
-/// \return Returns true if a polygon created successfully.
-////////////////////////////////////////////////////////////////////////////////
-bool Triangulate::Process(const Vector2dVector &contour, Vector2dVector &result)
-{
-	// allocate and initialize list of Vertices in polygon
-	int n = contour.size();
-	if ( n < 3 ) return false;
-
-	int *V = new int[n];
-
-	// a counter-clockwise polygon in V
-	if ( 0.0f < Area(contour) )
-	{
-		for (int v = 0; v < n; v++)
-			V[v] = v;
-	}
-	else
-	{
-		for(int v = 0; v < n; v++)
-			V[v] = (n-1)-v;
-	}
-
-	int nv = n;
-	int count = 2*nv;
-
-	// removes nv-2 Vertices, creating one triangle every time
-	for(int m = 0, v = nv-1; nv > 2; )
-	{
-		// check whether it is a non-simple polygon or not
-		if (0 >= (count--))
-		{
-			//Triangulate error - a non-simple polygon (probably bad polygon)
-			return false;
-		}
-
-		// three consecutive vertices in current polygon, <u,v,w>
-		int u = v;
-		if (nv <= u)
-			u = 0;
-		v = u+1;
-		if (nv <= v)
-			v = 0;
-		int w = v+1;
-		if (nv <= w)
-			w = 0;
-
-		if ( Snip(contour, u, v, w, nv, V) )
-		{
-			int a,b,c,s,t;
-
-			// true names of the vertices
-			a = V[u];
-			b = V[v];
-			c = V[w];
-
-			// output Triangle
-			result.push_back( contour[a] );
-			result.push_back( contour[b] );
-			result.push_back( contour[c] );
-			m++;
-
-			// remove v from remaining polygon
-			for(s = v, t = v+1; t < nv; s++, t++)
-				V[s] = V[t];
-			nv--;
-
-			// resest error detection counter
-			count = 2*nv;
-		}
-	}
-	delete[] V;
-	return true;
-}
+////////////////////////////////////////////////////////////////////////////////
+///	\file	triangulate.cpp
+///
+///	\author	ELREG, ear clipping from
+///         https://www.flipcode.com/archives/Efficient_Polygon_Triangulation.shtml
+///
+///	\brief	Implementation of the Triangulate class
+///         which triangulates polygons with holes and multiple rings.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <algorithm>
+#include <set>
+#include "triangulate.h"
+#include "usermapsframearena.h"
+
+static const float EPSILON = 0.0000000001f; ///< Used to denote a small quantity, error offset.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief SweepPoint - ring vertex in double precision.
+////////////////////////////////////////////////////////////////////////////////
+struct SweepPoint
+{
+	double x;	///< Value on xAxis.
+	double y;	///< Value on yAxis.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief ESweepVertexType - role of a vertex for the sweep line.
+////////////////////////////////////////////////////////////////////////////////
+enum class ESweepVertexType
+{
+	Start,		///< Both neighbours below, interior angle < 180 degrees.
+	Split,		///< Both neighbours below, interior angle > 180 degrees.
+	End,		///< Both neighbours above, interior angle < 180 degrees.
+	Merge,		///< Both neighbours above, interior angle > 180 degrees.
+	Regular		///< One neighbour above and one below.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief SweepNode - vertex of a ring. Diagonals split a ring in two, so a
+///        point can be used by several nodes.
+////////////////////////////////////////////////////////////////////////////////
+struct SweepNode
+{
+	int m_point;	///< Index of the point.
+	int m_prev;		///< Previous node in the ring (counter-clockwise around the interior).
+	int m_next;		///< Next node in the ring.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief SweepEdge - ring edge crossing the sweep line, interior on its right.
+////////////////////////////////////////////////////////////////////////////////
+struct SweepEdge
+{
+	bool operator<(const SweepEdge &other) const;
+
+	SweepPoint m_start;		///< Upper end of the edge.
+	SweepPoint m_end;		///< Lower end of the edge.
+	mutable int m_node;		///< Node the edge starts from, changes when the node is split.
+};
+
+// Sweep state lives in the frame arena of the caller, if it has one
+template <typename T>
+using SweepVector = UserMapsArenaVector<T>;
+typedef std::set<SweepEdge, std::less<SweepEdge>, UserMapsArenaAllocator<SweepEdge> > SweepEdgeSet;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn static bool isAbove(const SweepPoint &a, const SweepPoint &b)
+///
+/// \brief  Sweep order: higher points first, equal heights from right to left.
+////////////////////////////////////////////////////////////////////////////////
+static bool isAbove(const SweepPoint &a, const SweepPoint &b)
+{
+	return a.y > b.y || ( a.y == b.y && a.x > b.x );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn static double orientation(const SweepPoint &a, const SweepPoint &b, const SweepPoint &c)
+///
+/// \brief  Returns twice the signed area of triangle abc, positive if c lies
+///         left of the line from a to b.
+////////////////////////////////////////////////////////////////////////////////
+static double orientation(const SweepPoint &a, const SweepPoint &b, const SweepPoint &c)
+{
+	return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool SweepEdge::operator<(const SweepEdge &other) const
+///
+/// \brief  Orders edges crossing the sweep line from left to right. A point
+///         is passed as a zero length edge to find the edge left of it.
+////////////////////////////////////////////////////////////////////////////////
+bool SweepEdge::operator<(const SweepEdge &other) const
+{
+	bool isHorizontal = ( m_start.y == m_end.y );
+	bool isOtherHorizontal = ( other.m_start.y == other.m_end.y );
+
+	if ( isHorizontal && isOtherHorizontal )
+	{
+		if ( m_start.y != other.m_start.y )
+			return m_start.y < other.m_start.y;
+		return std::min(m_start.x, m_end.x) < std::min(other.m_start.x, other.m_end.x);
+	}
+
+	// Test the start of one edge against the other, non horizontal edge
+	if ( isOtherHorizontal )
+		return orientation(m_start, m_end, other.m_start) > 0.0;
+	if ( isHorizontal || m_start.y < other.m_start.y )
+		return orientation(other.m_start, other.m_end, m_start) <= 0.0;
+	return orientation(m_start, m_end, other.m_start) > 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn static void addDiagonal(SweepVector<SweepNode> &nodes, int first, int second,
+///                             SweepVector<ESweepVertexType> &types, SweepVector<int> &helpers,
+///                             SweepVector<SweepEdgeSet::iterator> &edges, SweepEdgeSet &edgeSet)
+///
+/// \brief  Splits a ring along the diagonal between two of its nodes. Both
+///         nodes keep their incoming edge; copies of them take the outgoing
+///         edges, together with their sweep line state.
+///
+/// \param  nodes - Ring nodes, two nodes are appended.
+///         first - Node being swept.
+///         second - Helper node the diagonal goes to.
+///         types, helpers, edges - Sweep state per node.
+///         edgeSet - Edges crossing the sweep line.
+////////////////////////////////////////////////////////////////////////////////
+static void addDiagonal(SweepVector<SweepNode> &nodes, int first, int second,
+						SweepVector<ESweepVertexType> &types, SweepVector<int> &helpers,
+						SweepVector<SweepEdgeSet::iterator> &edges, SweepEdgeSet &edgeSet)
+{
+	int firstCopy = static_cast<int>(nodes.size());
+	int secondCopy = firstCopy + 1;
+	nodes.push_back(nodes[static_cast<size_t>(first)]);
+	nodes.push_back(nodes[static_cast<size_t>(second)]);
+
+	nodes[static_cast<size_t>(nodes[static_cast<size_t>(first)].m_next)].m_prev = firstCopy;
+	nodes[static_cast<size_t>(nodes[static_cast<size_t>(second)].m_next)].m_prev = secondCopy;
+	nodes[static_cast<size_t>(first)].m_next = secondCopy;
+	nodes[static_cast<size_t>(secondCopy)].m_prev = first;
+	nodes[static_cast<size_t>(second)].m_next = firstCopy;
+	nodes[static_cast<size_t>(firstCopy)].m_prev = second;
+
+	for (int node : { first, second })
+	{
+		int copy = ( node == first ) ? firstCopy : secondCopy;
+		types.push_back(types[static_cast<size_t>(node)]);
+		helpers.push_back(helpers[static_cast<size_t>(node)]);
+		edges.push_back(edges[static_cast<size_t>(node)]);
+		if ( edges[static_cast<size_t>(copy)] != edgeSet.end() )
+			edges[static_cast<size_t>(copy)]->m_node = copy;
+		edges[static_cast<size_t>(node)] = edgeSet.end();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn static bool monotonePartition(const SweepVector<SweepPoint> &points, SweepVector<SweepNode> &nodes)
+///
+/// \brief  Adds diagonals which split the rings into y-monotone pieces.
+///
+/// \param  points - Ring points.
+///         nodes - Rings, interior on the left of every edge. Split nodes are appended.
+///
+/// \return False if the rings cannot be swept (e.g. they intersect).
+////////////////////////////////////////////////////////////////////////////////
+static bool monotonePartition(const SweepVector<SweepPoint> &points, SweepVector<SweepNode> &nodes)
+{
+	int count = static_cast<int>(nodes.size());
+	UserMapsArenaAllocator<SweepEdge> allocator(nodes.get_allocator());
+	SweepEdgeSet edgeSet(std::less<SweepEdge>(), allocator);
+	SweepVector<ESweepVertexType> types(allocator);
+	SweepVector<int> helpers(static_cast<size_t>(count), -1, allocator);
+	SweepVector<SweepEdgeSet::iterator> edges(static_cast<size_t>(count), edgeSet.end(), allocator);
+	types.reserve(static_cast<size_t>(count) * 3);
+	helpers.reserve(static_cast<size_t>(count) * 3);
+	edges.reserve(static_cast<size_t>(count) * 3);
+	nodes.reserve(static_cast<size_t>(count) * 3);
+
+	// point of a node
+	auto P = [&](int node) -> const SweepPoint & { return points[static_cast<size_t>(nodes[static_cast<size_t>(node)].m_point)]; };
+
+	for (int i = 0; i < count; ++i)
+	{
+		const SweepPoint &prev = P(nodes[static_cast<size_t>(i)].m_prev);
+		const SweepPoint &next = P(nodes[static_cast<size_t>(i)].m_next);
+		const SweepPoint &point = P(i);
+		bool isConvex = orientation(prev, point, next) > 0.0;
+
+		if ( isAbove(point, prev) && isAbove(point, next) )
+			types.push_back(isConvex ? ESweepVertexType::Start : ESweepVertexType::Split);
+		else if ( isAbove(prev, point) && isAbove(next, point) )
+			types.push_back(isConvex ? ESweepVertexType::End : ESweepVertexType::Merge);
+		else
+			types.push_back(ESweepVertexType::Regular);
+	}
+
+	SweepVector<int> order(static_cast<size_t>(count), 0, allocator);
+	for (int i = 0; i < count; ++i)
+		order[static_cast<size_t>(i)] = i;
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return isAbove(P(a), P(b)); });
+
+	// Edge starting at a node, entering the sweep line
+	auto insertEdge = [&](int node, int helper)
+	{
+		SweepEdge edge = { P(node), P(nodes[static_cast<size_t>(node)].m_next), node };
+		std::pair<SweepEdgeSet::iterator, bool> result = edgeSet.insert(edge);
+		edges[static_cast<size_t>(node)] = result.first;
+		helpers[static_cast<size_t>(node)] = helper;
+		return result.second;
+	};
+
+	// Edge directly left of a node
+	auto edgeLeftOf = [&](int node) -> SweepEdgeSet::iterator
+	{
+		SweepEdge query = { P(node), P(node), -1 };
+		SweepEdgeSet::iterator it = edgeSet.lower_bound(query);
+		if ( it == edgeSet.begin() )
+			return edgeSet.end();
+		return --it;
+	};
+
+	// Edge leaving the sweep line, the node holding it may have been split
+	auto removeEdge = [&](SweepEdgeSet::iterator edge)
+	{
+		edges[static_cast<size_t>(edge->m_node)] = edgeSet.end();
+		edgeSet.erase(edge);
+	};
+
+	auto isMergeHelper = [&](int edgeNode)
+	{
+		int helper = helpers[static_cast<size_t>(edgeNode)];
+		return helper >= 0 && types[static_cast<size_t>(helper)] == ESweepVertexType::Merge;
+	};
+
+	for (int v : order)
+	{
+		int prev = nodes[static_cast<size_t>(v)].m_prev;
+		int split = v;	// node holding the outgoing edge of v after diagonals
+
+		switch (types[static_cast<size_t>(v)])
+		{
+		case ESweepVertexType::Start:
+			if ( !insertEdge(v, v) )
+				return false;
+			break;
+
+		case ESweepVertexType::End:
+		{
+			SweepEdgeSet::iterator prevEdge = edges[static_cast<size_t>(prev)];
+			if ( prevEdge == edgeSet.end() )
+				return false;
+			if ( isMergeHelper(prev) )
+				addDiagonal(nodes, v, helpers[static_cast<size_t>(prev)], types, helpers, edges, edgeSet);
+			removeEdge(prevEdge);
+			break;
+		}
+
+		case ESweepVertexType::Split:
+		{
+			SweepEdgeSet::iterator left = edgeLeftOf(v);
+			if ( left == edgeSet.end() )
+				return false;
+			addDiagonal(nodes, v, helpers[static_cast<size_t>(left->m_node)], types, helpers, edges, edgeSet);
+			split = static_cast<int>(nodes.size()) - 2;
+			helpers[static_cast<size_t>(left->m_node)] = v;
+			if ( !insertEdge(split, split) )
+				return false;
+			break;
+		}
+
+		case ESweepVertexType::Merge:
+		{
+			SweepEdgeSet::iterator prevEdge = edges[static_cast<size_t>(prev)];
+			if ( prevEdge == edgeSet.end() )
+				return false;
+			if ( isMergeHelper(prev) )
+			{
+				addDiagonal(nodes, v, helpers[static_cast<size_t>(prev)], types, helpers, edges, edgeSet);
+				split = static_cast<int>(nodes.size()) - 2;
+			}
+			removeEdge(prevEdge);
+
+			SweepEdgeSet::iterator left = edgeLeftOf(v);
+			if ( left == edgeSet.end() )
+				return false;
+			if ( isMergeHelper(left->m_node) )
+				addDiagonal(nodes, split, helpers[static_cast<size_t>(left->m_node)], types, helpers, edges, edgeSet);
+			helpers[static_cast<size_t>(left->m_node)] = split;
+			break;
+		}
+
+		case ESweepVertexType::Regular:
+			if ( isAbove(P(prev), P(v)) )
+			{
+				// Interior to the right: v continues a left boundary
+				SweepEdgeSet::iterator prevEdge = edges[static_cast<size_t>(prev)];
+				if ( prevEdge == edgeSet.end() )
+					return false;
+				if ( isMergeHelper(prev) )
+				{
+					addDiagonal(nodes, v, helpers[static_cast<size_t>(prev)], types, helpers, edges, edgeSet);
+					split = static_cast<int>(nodes.size()) - 2;
+				}
+				removeEdge(prevEdge);
+
+				// The copy holding the outgoing edge borders the region below the diagonal
+				if ( !insertEdge(split, split) )
+					return false;
+			}
+			else
+			{
+				SweepEdgeSet::iterator left = edgeLeftOf(v);
+				if ( left == edgeSet.end() )
+					return false;
+				if ( isMergeHelper(left->m_node) )
+					addDiagonal(nodes, v, helpers[static_cast<size_t>(left->m_node)], types, helpers, edges, edgeSet);
+				helpers[static_cast<size_t>(left->m_node)] = v;
+			}
+			break;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn static bool triangulateMonotone(const SweepVector<SweepPoint> &points,
+///                                     const SweepVector<SweepNode> &nodes,
+///                                     const SweepVector<int> &ring, SweepVector<uint> &indices)
+///
+/// \brief  Triangulates a y-monotone ring in linear time.
+///
+/// \param  points - Ring points.
+///         nodes - Ring nodes.
+///         ring - Nodes of the ring, counter-clockwise.
+///         indices - Point indices of the triangles are appended.
+///
+/// \return False if the ring is not y-monotone.
+////////////////////////////////////////////////////////////////////////////////
+static bool triangulateMonotone(const SweepVector<SweepPoint> &points, const SweepVector<SweepNode> &nodes,
+								const SweepVector<int> &ring, SweepVector<uint> &indices)
+{
+	const int LEFT = 1;
+	const int RIGHT = 2;
+	int n = static_cast<int>(ring.size());
+	if ( n < 3 )
+		return true;
+
+	auto P = [&](int node) -> const SweepPoint & { return points[static_cast<size_t>(nodes[static_cast<size_t>(node)].m_point)]; };
+
+	// Counter-clockwise triangle
+	auto addTriangle = [&](int a, int b, int c)
+	{
+		if ( orientation(P(a), P(b), P(c)) < 0.0 )
+			std::swap(b, c);
+		indices.push_back(static_cast<uint>(nodes[static_cast<size_t>(a)].m_point));
+		indices.push_back(static_cast<uint>(nodes[static_cast<size_t>(b)].m_point));
+		indices.push_back(static_cast<uint>(nodes[static_cast<size_t>(c)].m_point));
+	};
+
+	int top = ring[0];
+	int bottom = ring[0];
+	for (int node : ring)
+	{
+		if ( isAbove(P(node), P(top)) )
+			top = node;
+		if ( isAbove(P(bottom), P(node)) )
+			bottom = node;
+	}
+
+	// Merge the left chain (next from the top) and the right chain (prev from the top)
+	SweepVector<int> sorted(ring.get_allocator());
+	SweepVector<int> side(ring.get_allocator());
+	sorted.reserve(static_cast<size_t>(n));
+	side.reserve(static_cast<size_t>(n));
+	sorted.push_back(top);
+	side.push_back(0);
+
+	int left = nodes[static_cast<size_t>(top)].m_next;
+	int right = nodes[static_cast<size_t>(top)].m_prev;
+	int lastLeft = top;
+	int lastRight = top;
+	while ( left != bottom || right != bottom )
+	{
+		bool isLeft = ( right == bottom ) || ( left != bottom && isAbove(P(left), P(right)) );
+		int node = isLeft ? left : right;
+		int &last = isLeft ? lastLeft : lastRight;
+		if ( !isAbove(P(last), P(node)) || static_cast<int>(sorted.size()) >= n )
+			return false;
+
+		sorted.push_back(node);
+		side.push_back(isLeft ? LEFT : RIGHT);
+		last = node;
+		if ( isLeft )
+			left = nodes[static_cast<size_t>(left)].m_next;
+		else
+			right = nodes[static_cast<size_t>(right)].m_prev;
+	}
+	sorted.push_back(bottom);
+	side.push_back(0);
+	if ( static_cast<int>(sorted.size()) != n )
+		return false;
+
+	SweepVector<int> stack(ring.get_allocator());
+	stack.reserve(static_cast<size_t>(n));
+	stack.push_back(0);
+	stack.push_back(1);
+
+	for (int j = 2; j < n - 1; ++j)
+	{
+		if ( side[static_cast<size_t>(j)] != side[static_cast<size_t>(stack.back())] )
+		{
+			// Opposite chain: fan to everything on the stack
+			for (size_t k = 0; k + 1 < stack.size(); ++k)
+				addTriangle(sorted[static_cast<size_t>(j)], sorted[static_cast<size_t>(stack[k])], sorted[static_cast<size_t>(stack[k + 1])]);
+			stack.clear();
+			stack.push_back(j - 1);
+			stack.push_back(j);
+		}
+		else
+		{
+			// Same chain: cut off triangles while the diagonal is inside
+			int last = stack.back();
+			stack.pop_back();
+			while ( !stack.empty() )
+			{
+				const SweepPoint &current = P(sorted[static_cast<size_t>(j)]);
+				const SweepPoint &middle = P(sorted[static_cast<size_t>(last)]);
+				const SweepPoint &upper = P(sorted[static_cast<size_t>(stack.back())]);
+				double turn = ( side[static_cast<size_t>(j)] == LEFT ) ? orientation(upper, middle, current)
+																	   : orientation(current, middle, upper);
+				if ( turn <= 0.0 )
+					break;
+
+				addTriangle(sorted[static_cast<size_t>(j)], sorted[static_cast<size_t>(last)], sorted[static_cast<size_t>(stack.back())]);
+				last = stack.back();
+				stack.pop_back();
+			}
+			stack.push_back(last);
+			stack.push_back(j);
+		}
+	}
+
+	// Bottom closes all remaining triangles
+	for (size_t k = 0; k + 1 < stack.size(); ++k)
+		addTriangle(sorted[static_cast<size_t>(n - 1)], sorted[static_cast<size_t>(stack[k])], sorted[static_cast<size_t>(stack[k + 1])]);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn static bool containsPoint(const SweepVector<SweepPoint> &points, int first, int count,
+///                               const SweepPoint &point)
+///
+/// \brief  Even-odd test of a point against a ring.
+///
+/// \param  points - Ring points.
+///         first - First point of the ring.
+///         count - Number of points of the ring.
+///         point - Tested point.
+////////////////////////////////////////////////////////////////////////////////
+static bool containsPoint(const SweepVector<SweepPoint> &points, int first, int count, const SweepPoint &point)
+{
+	bool isInside = false;
+	for (int i = 0, j = count - 1; i < count; j = i++)
+	{
+		const SweepPoint &a = points[static_cast<size_t>(first + i)];
+		const SweepPoint &b = points[static_cast<size_t>(first + j)];
+		if ( ( a.y > point.y ) != ( b.y > point.y ) &&
+			 point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x )
+			isInside = !isInside;
+	}
+	return isInside;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn float Triangulate::Area(const Vector2dVector &contour)
+///
+/// \brief  Computes an area of contour.
+///
+/// \param  contour - Contour area.
+///
+/// \return Returns calculated area of polygon.
+////////////////////////////////////////////////////////////////////////////////
+float Triangulate::Area(const Vector2dVector &contour)
+{
+	return Area(contour.data(), static_cast<int>(contour.size()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn float Triangulate::Area(const GenericVertexData *contour, int n)
+///
+/// \brief  Computes an area of contour.
+///
+/// \param  contour - Contour vertices.
+///         n - Number of vertices.
+///
+/// \return Returns calculated area of polygon.
+////////////////////////////////////////////////////////////////////////////////
+float Triangulate::Area(const GenericVertexData *contour, int n)
+{
+	float A = 0.0f;
+
+	for(int p = n-1, q = 0; q < n; p = q++)
+	{
+		A+= contour[p].position().x()*contour[q].position().y() -
+				contour[q].position().x()*contour[p].position().y();
+	}
+	return A*0.5f;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::InsideTriangle(float Ax, float Ay,
+///                                      float Bx, float By,
+///                                      float Cx, float Cy,
+///                                      float Px, float Py)
+///
+/// \brief  Checks if a point P is inside the triangle
+///         defined by points A, B, and C.
+///
+/// \param  Ax - Value on xAxis for point A.
+///         Ay - Value on yAxis for point A.
+///         Bx - Value on xAxis for point B.
+///         By - Value on yAxis for point B.
+///         Cx - Value on xAxis for point C.
+///         Cy - Value on yAxis for point C.
+///         Px - Value on xAxis for point P.
+///         Py - Value on yAxis for point P.
+///
+/// \return Returns true when the point lies inside triangle,
+///         otherwise false.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::InsideTriangle(float Ax, float Ay,
+								 float Bx, float By,
+								 float Cx, float Cy,
+								 float Px, float Py)
+
+{
+	float ax, ay, bx, by, cx, cy, apx, apy, bpx, bpy, cpx, cpy;
+	float cCROSSap, bCROSScp, aCROSSbp;
+
+	ax = Cx - Bx;  ay = Cy - By;
+	bx = Ax - Cx;  by = Ay - Cy;
+	cx = Bx - Ax;  cy = By - Ay;
+	apx= Px - Ax;  apy= Py - Ay;
+	bpx= Px - Bx;  bpy= Py - By;
+	cpx= Px - Cx;  cpy= Py - Cy;
+
+	aCROSSbp = ax*bpy - ay*bpx;
+	cCROSSap = cx*apy - cy*apx;
+	bCROSScp = bx*cpy - by*cpx;
+
+	return ((aCROSSbp >= 0.0f) && (bCROSScp >= 0.0f) && (cCROSSap >= 0.0f));
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::Snip(const GenericVertexData *contour,int u,int v,int w,int n,int *V)
+///
+/// \brief  Checks if consecutive points can form closed polygon.
+///
+/// \param  contour - Contour area.
+///         u - Three consecutive vertices in polygon - previous
+///         v - Three consecutive vertices in polygon - current
+///         w - Three consecutive vertices in polygon - next
+///         n - Number of vertices in polygon
+///         V - Vector of polygon points as series of Triangles
+///
+/// \return Returns true if given consequtive points can be points of a polygon
+///         (polygon created successfully), otherwise false.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::Snip(const GenericVertexData *contour,int u,int v,int w,int n,int *V)
+{
+	int p;
+	float Ax, Ay, Bx, By, Cx, Cy, Px, Py;
+
+	Ax = contour[V[u]].position().x();
+	Ay = contour[V[u]].position().y();
+
+	Bx = contour[V[v]].position().x();
+	By = contour[V[v]].position().y();
+
+	Cx = contour[V[w]].position().x();
+	Cy = contour[V[w]].position().y();
+
+	if ( EPSILON > (((Bx-Ax)*(Cy-Ay)) - ((By-Ay)*(Cx-Ax))) )
+		return false;
+
+	for (p = 0; p < n; p++)
+	{
+		if( (p == u) || (p == v) || (p == w) )
+			continue;
+		Px = contour[V[p]].position().x();
+		Py = contour[V[p]].position().y();
+		if (InsideTriangle(Ax,Ay,Bx,By,Cx,Cy,Px,Py))
+			return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::Process(const Vector2dVector &contour, Vector2dVector &result)
+///
+/// \brief  Triangulate a contour/polygon and places results in a vector
+///         as series of triangles.
+///
+/// \param  contour - Contour area.
+///         result  - A vector containing a series of triangles.
+///
+/// \return Returns true if a polygon created successfully.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::Process(const Vector2dVector &contour, Vector2dVector &result)
+{
+	std::vector<uint> indices;
+	bool isOk = Process(contour, indices);
+
+	for (uint index : indices)
+		result.push_back( contour[index] );
+
+	return isOk;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::Process(const Vector2dVector &contour, std::vector<uint> &indices,
+///                                CUserMapsFrameArena *pArena)
+///
+/// \brief  Triangulate a contour/polygon and places results in a vector
+///         as series of contour indices, three per triangle.
+///
+/// \param  contour - Contour area.
+///         indices - A vector containing indices of a series of triangles.
+///         pArena - Arena for the working state, nullptr to use the heap.
+///
+/// \return Returns true if a polygon created successfully.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::Process(const Vector2dVector &contour, std::vector<uint> &indices, CUserMapsFrameArena *pArena)
+{
+	return Process(contour.data(), static_cast<int>(contour.size()), indices, pArena);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::Process(const GenericVertexData *contour, int n, std::vector<uint> &indices,
+///                                CUserMapsFrameArena *pArena)
+///
+/// \brief  Triangulate a contour/polygon given as an array, e.g. one
+///         allocated from a frame arena, and places results in a vector as
+///         series of contour indices, three per triangle.
+///
+/// \param  contour - Contour vertices.
+///         n - Number of vertices.
+///         indices - A vector containing indices of a series of triangles.
+///         pArena - Arena for the working state, nullptr to use the heap.
+///
+/// \return Returns true if a polygon created successfully.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::Process(const GenericVertexData *contour, int n, std::vector<uint> &indices,
+						  CUserMapsFrameArena *pArena)
+{
+	Ring ring = { contour, n };
+	return ProcessRings(&ring, 1, indices, pArena);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::Process(const std::vector<Vector2dVector> &rings, std::vector<uint> &indices,
+///                                CUserMapsFrameArena *pArena)
+///
+/// \brief  Triangulate rings and places results in a vector as series of
+///         indices, three per triangle. Rings may be in any orientation;
+///         a ring inside an odd number of other rings is a hole.
+///
+/// \param  rings - Outlines, holes and islands, not intersecting each other.
+///         indices - A vector containing indices of a series of triangles,
+///                   counting the points of all rings one after another.
+///         pArena - Arena for the working state, nullptr to use the heap.
+///
+/// \return Returns true if the rings were triangulated completely.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::Process(const std::vector<Vector2dVector> &rings, std::vector<uint> &indices,
+						  CUserMapsFrameArena *pArena)
+{
+	CUserMapsFrameArena::Scope scope(pArena);
+	UserMapsArenaAllocator<Ring> allocator(pArena);
+	SweepVector<Ring> ringArray(allocator);
+	ringArray.reserve(rings.size());
+	for (const Vector2dVector &ring : rings)
+	{
+		Ring entry = { ring.data(), static_cast<int>(ring.size()) };
+		ringArray.push_back(entry);
+	}
+
+	return ProcessRings(ringArray.data(), ringArray.size(), indices, pArena);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::ProcessRings(const Ring *rings, size_t ringCount, std::vector<uint> &indices,
+///                                     CUserMapsFrameArena *pArena)
+///
+/// \brief  Triangulates rings, see Process(). All working state is taken from
+///         the arena, if given, and given back to it on return.
+///
+/// \param  rings - Outlines, holes and islands, not intersecting each other.
+///         ringCount - Number of rings.
+///         indices - A vector containing indices of a series of triangles,
+///                   counting the points of all rings one after another.
+///         pArena - Arena for the working state, nullptr to use the heap.
+///
+/// \return Returns true if the rings were triangulated completely.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::ProcessRings(const Ring *rings, size_t ringCount, std::vector<uint> &indices,
+							   CUserMapsFrameArena *pArena)
+{
+	CUserMapsFrameArena::Scope scope(pArena);
+	UserMapsArenaAllocator<SweepPoint> allocator(pArena);
+
+	// Points of all rings, repeated points removed
+	size_t pointCount = 0;
+	for (size_t r = 0; r < ringCount; ++r)
+		pointCount += static_cast<size_t>(rings[r].m_count);
+
+	SweepVector<SweepPoint> points(allocator);
+	SweepVector<uint> sourceIndices(allocator);
+	SweepVector<int> ringFirst(allocator);
+	SweepVector<int> ringSizes(allocator);
+	SweepVector<size_t> ringSource(allocator);
+	points.reserve(pointCount);
+	sourceIndices.reserve(pointCount);
+	uint offset = 0;
+
+	for (size_t r = 0; r < ringCount; ++r)
+	{
+		const Ring &ring = rings[r];
+		int first = static_cast<int>(points.size());
+		for (int i = 0; i < ring.m_count; ++i)
+		{
+			SweepPoint point = { ring.m_pVertices[i].position().x(), ring.m_pVertices[i].position().y() };
+			if ( static_cast<int>(points.size()) > first && point.x == points.back().x && point.y == points.back().y )
+				continue;
+			points.push_back(point);
+			sourceIndices.push_back(offset + static_cast<uint>(i));
+		}
+
+		// Closing point repeats the first one
+		while ( static_cast<int>(points.size()) > first + 1 &&
+				points.back().x == points[static_cast<size_t>(first)].x && points.back().y == points[static_cast<size_t>(first)].y )
+		{
+			points.pop_back();
+			sourceIndices.pop_back();
+		}
+
+		int count = static_cast<int>(points.size()) - first;
+		if ( count < 3 )
+		{
+			points.resize(static_cast<size_t>(first));
+			sourceIndices.resize(static_cast<size_t>(first));
+		}
+		else
+		{
+			ringFirst.push_back(first);
+			ringSizes.push_back(count);
+			ringSource.push_back(r);
+		}
+		offset += static_cast<uint>(ring.m_count);
+	}
+
+	if ( points.empty() )
+		return false;
+
+	// Outer rings (even nesting depth) counter-clockwise, holes clockwise
+	SweepVector<SweepNode> nodes(points.size(), SweepNode(), allocator);
+	SweepVector<bool> isOuter(ringFirst.size(), true, allocator);
+	int holeCount = 0;
+	for (size_t r = 0; r < ringFirst.size(); ++r)
+	{
+		int depth = 0;
+		for (size_t other = 0; other < ringFirst.size(); ++other)
+		{
+			if ( other != r && containsPoint(points, ringFirst[other], ringSizes[other], points[static_cast<size_t>(ringFirst[r])]) )
+				++depth;
+		}
+		isOuter[r] = ( depth % 2 == 0 );
+		holeCount += isOuter[r] ? 0 : 1;
+
+		double area = 0.0;
+		for (int i = 0, j = ringSizes[r] - 1; i < ringSizes[r]; j = i++)
+		{
+			const SweepPoint &a = points[static_cast<size_t>(ringFirst[r] + j)];
+			const SweepPoint &b = points[static_cast<size_t>(ringFirst[r] + i)];
+			area += a.x * b.y - b.x * a.y;
+		}
+		bool isReversed = ( area > 0.0 ) != isOuter[r];
+
+		for (int i = 0; i < ringSizes[r]; ++i)
+		{
+			int node = ringFirst[r] + i;
+			int prev = ringFirst[r] + (i + ringSizes[r] - 1) % ringSizes[r];
+			int next = ringFirst[r] + (i + 1) % ringSizes[r];
+			nodes[static_cast<size_t>(node)].m_point = node;
+			nodes[static_cast<size_t>(node)].m_prev = isReversed ? next : prev;
+			nodes[static_cast<size_t>(node)].m_next = isReversed ? prev : next;
+		}
+	}
+
+	// Sweep into monotone pieces and triangulate every piece
+	SweepVector<uint> result(allocator);
+	result.reserve((points.size() + 2 * static_cast<size_t>(holeCount)) * 3);
+	bool isOk = monotonePartition(points, nodes);
+
+	SweepVector<bool> isVisited(nodes.size(), false, allocator);
+	SweepVector<int> piece(allocator);
+	for (size_t start = 0; isOk && start < nodes.size(); ++start)
+	{
+		if ( isVisited[start] )
+			continue;
+
+		piece.clear();
+		int node = static_cast<int>(start);
+		while ( !isVisited[static_cast<size_t>(node)] )
+		{
+			isVisited[static_cast<size_t>(node)] = true;
+			piece.push_back(node);
+			node = nodes[static_cast<size_t>(node)].m_next;
+		}
+		isOk = ( node == static_cast<int>(start) ) && triangulateMonotone(points, nodes, piece, result);
+	}
+
+	// A proper triangulation of n points with h holes in k polygons has n + 2h - 2k triangles
+	size_t outerCount = ringFirst.size() - static_cast<size_t>(holeCount);
+	if ( isOk && result.size() == (points.size() + 2 * static_cast<size_t>(holeCount) - 2 * outerCount) * 3 )
+	{
+		for (uint index : result)
+			indices.push_back(sourceIndices[index]);
+		return true;
+	}
+
+	// Fall back to ear clipping of the outer rings, holes are ignored
+	for (size_t r = 0; r < ringFirst.size(); ++r)
+	{
+		if ( !isOuter[r] )
+			continue;
+
+		uint ringOffset = 0;
+		for (size_t i = 0; i < ringSource[r]; ++i)
+			ringOffset += static_cast<uint>(rings[i].m_count);
+
+		size_t firstIndex = indices.size();
+		const Ring &ring = rings[ringSource[r]];
+		EarClip(ring.m_pVertices, ring.m_count, indices, pArena);
+		for (size_t i = firstIndex; i < indices.size(); ++i)
+			indices[i] += ringOffset;
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn bool Triangulate::EarClip(const GenericVertexData *contour, int n, std::vector<uint> &indices,
+///                                CUserMapsFrameArena *pArena)
+///
+/// \brief  Triangulates a simple contour by ear clipping, O(n^2) or worse.
+///         Non-simple contours are triangulated as far as possible.
+///
+/// \param  contour - Contour vertices.
+///         n - Number of vertices.
+///         indices - Indices of a series of triangles are appended.
+///         pArena - Arena for the working state, nullptr to use the heap.
+///
+/// \return Returns true if a polygon created successfully.
+////////////////////////////////////////////////////////////////////////////////
+bool Triangulate::EarClip(const GenericVertexData *contour, int n, std::vector<uint> &indices,
+						  CUserMapsFrameArena *pArena)
+{
+	// allocate and initialize list of Vertices in polygon
+	if ( n < 3 ) return false;
+
+	CUserMapsFrameArena::Scope scope(pArena);
+	UserMapsArenaAllocator<int> allocator(pArena);
+	SweepVector<int> V(static_cast<size_t>(n), 0, allocator);
+
+	// a counter-clockwise polygon in V
+	if ( 0.0f < Area(contour, n) )
+	{
+		for (int v = 0; v < n; v++)
+			V[v] = v;
+	}
+	else
+	{
+		for(int v = 0; v < n; v++)
+			V[v] = (n-1)-v;
+	}
+
+	int nv = n;
+	int count = 2*nv;
+
+	// removes nv-2 Vertices, creating one triangle every time
+	for(int m = 0, v = nv-1; nv > 2; )
+	{
+		// check whether it is a non-simple polygon or not
+		if (0 >= (count--))
+		{
+			//Triangulate error - a non-simple polygon (probably bad polygon)
+			return false;
+		}
+
+		// three consecutive vertices in current polygon, <u,v,w>
+		int u = v;
+		if (nv <= u)
+			u = 0;
+		v = u+1;
+		if (nv <= v)
+			v = 0;
+		int w = v+1;
+		if (nv <= w)
+			w = 0;
+
+		if ( Snip(contour, u, v, w, nv, V.data()) )
+		{
+			int s,t;
+
+			// output Triangle, true names of the vertices
+			indices.push_back( static_cast<uint>(V[u]) );
+			indices.push_back( static_cast<uint>(V[v]) );
+			indices.push_back( static_cast<uint>(V[w]) );
+			m++;
+
+			// remove v from remaining polygon
+			for(s = v, t = v+1; t < nv; s++, t++)
+				V[s] = V[t];
+			nv--;
+
+			// resest error detection counter
+			count = 2*nv;
+		}
+	}
+	return true;
+}
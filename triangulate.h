@@ -1,48 +1,90 @@
-////////////////////////////////////////////////////////////////////////////////
-///	\file	triangulate.h
-///
-///	\author	ELREG, most of the code from
-///         https://www.flipcode.com/archives/Efficient_Polygon_Triangulation.shtml
-///
-///	\brief	Implementation of the Triangulate class
-///         which  triangulates any polygon without hole.
-///
-///	(C) Kelvin Hughes, 2020.
-////////////////////////////////////////////////////////////////////////////////
-#ifndef TRIANGULATE_H
-#define TRIANGULATE_H
-
-#include <vector>
-#include "../OpenGLBaseLib/imagetexture.h"
-#include "../OpenGLBaseLib/vertexbuffer.h"
-
-typedef std::vector<GenericVertexData> Vector2dVector;
-
-////////////////////////////////////////////////////////////////////////////////
-/// \brief Triangulate - Class representing polygon triangulation.
-////////////////////////////////////////////////////////////////////////////////
-class Triangulate
-{
-public:
-
-	// Triangulates a contour/polygon and places results in a vector
-	// as series of triangles
-	static bool Process(const Vector2dVector &contour,
-						Vector2dVector &result);
-
-	// Computes area of a contour/polygon
-	static float Area(const Vector2dVector &contour);
-
-	// Calculates whether point P is inside triangle defined by
-	// (Ax,Ay) (Bx,By) (Cx,Cy) or not
-	static bool InsideTriangle(float Ax, float Ay,
-							   float Bx, float By,
-							   float Cx, float Cy,
-							   float Px, float Py);
-
-private:
-	static bool Snip(const Vector2dVector &contour,int u,int v,int w,int n,int *V);
-};
-
-#endif // TRIANGULATE_H
-
+////////////////////////////////////////////////////////////////////////////////
+///	\file	triangulate.h
+///
+///	\author	ELREG, ear clipping from
+///         https://www.flipcode.com/archives/Efficient_Polygon_Triangulation.shtml
+///
+///	\brief	Implementation of the Triangulate class
+///         which triangulates polygons with holes and multiple rings.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef TRIANGULATE_H
+#define TRIANGULATE_H
+
+#include <cstddef>
+#include <vector>
+#include "../OpenGLBaseLib/imagetexture.h"
+#include "../OpenGLBaseLib/vertexbuffer.h"
+
+class CUserMapsFrameArena;
+
+typedef std::vector<GenericVertexData> Vector2dVector;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Triangulate - Class representing polygon triangulation.
+///
+/// Polygons are split into y-monotone pieces by a sweep line and the pieces
+/// are triangulated in linear time, O(n log n) overall. Rings nested an odd
+/// number of times are holes, whatever their orientation. Input the sweep
+/// cannot handle (e.g. self-intersecting rings) falls back to ear clipping
+/// of the outer rings. Working state is taken from a frame arena if one is
+/// passed, so repeated triangulations do not allocate.
+////////////////////////////////////////////////////////////////////////////////
+class Triangulate
+{
+public:
+
+	// Triangulates a contour/polygon and places results in a vector
+	// as series of triangles
+	static bool Process(const Vector2dVector &contour,
+						Vector2dVector &result);
+
+	// Triangulates a contour/polygon and places results in a vector
+	// as series of contour indices, three per triangle
+	static bool Process(const Vector2dVector &contour,
+						std::vector<uint> &indices,
+						CUserMapsFrameArena *pArena = nullptr);
+
+	// Triangulates a contour/polygon given as an array and places results
+	// in a vector as series of contour indices, three per triangle
+	static bool Process(const GenericVertexData *contour, int n,
+						std::vector<uint> &indices,
+						CUserMapsFrameArena *pArena = nullptr);
+
+	// Triangulates rings (outlines, holes, islands) and places results in a
+	// vector as series of indices into the concatenated rings
+	static bool Process(const std::vector<Vector2dVector> &rings,
+						std::vector<uint> &indices,
+						CUserMapsFrameArena *pArena = nullptr);
+
+	// Computes area of a contour/polygon
+	static float Area(const Vector2dVector &contour);
+
+	// Calculates whether point P is inside triangle defined by
+	// (Ax,Ay) (Bx,By) (Cx,Cy) or not
+	static bool InsideTriangle(float Ax, float Ay,
+							   float Bx, float By,
+							   float Cx, float Cy,
+							   float Px, float Py);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief Ring - vertices of one ring, not owned.
+	////////////////////////////////////////////////////////////////////////////
+	struct Ring
+	{
+		const GenericVertexData *m_pVertices;	///< First vertex.
+		int m_count;							///< Number of vertices.
+	};
+
+	static bool ProcessRings(const Ring *rings, size_t ringCount, std::vector<uint> &indices,
+							 CUserMapsFrameArena *pArena);
+	static bool EarClip(const GenericVertexData *contour, int n, std::vector<uint> &indices,
+						CUserMapsFrameArena *pArena);
+	static bool Snip(const GenericVertexData *contour,int u,int v,int w,int n,int *V);
+	static float Area(const GenericVertexData *contour, int n);
+};
+
+#endif // TRIANGULATE_H
+
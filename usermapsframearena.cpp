@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsframearena.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsFrameArena class, a bump allocator
+///			for the temporary geometry containers of a synchronisation.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsframearena.h"
+#include <algorithm>
+
+const size_t CUserMapsFrameArena::BLOCK_SIZE;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsFrameArena::Scope::Scope(CUserMapsFrameArena *pArena)
+///
+/// \brief  Constructor. Remembers the position of the arena.
+///
+/// \param  pArena - Arena, nullptr if the containers use the heap.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsFrameArena::Scope::Scope(CUserMapsFrameArena *pArena)
+	: m_pArena(pArena),
+	  m_block(0),
+	  m_offset(0)
+{
+	if ( m_pArena != nullptr )
+	{
+		m_block = m_pArena->m_current;
+		m_offset = m_pArena->m_offset;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsFrameArena::Scope::~Scope()
+///
+/// \brief  Destructor. Gives everything allocated within the scope back.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsFrameArena::Scope::~Scope()
+{
+	if ( m_pArena != nullptr )
+	{
+		m_pArena->m_current = m_block;
+		m_pArena->m_offset = m_offset;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsFrameArena::CUserMapsFrameArena()
+///
+/// \brief  Constructor. The first block is allocated on first use.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsFrameArena::CUserMapsFrameArena()
+	: m_current(0),
+	  m_offset(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsFrameArena::~CUserMapsFrameArena()
+///
+/// \brief  Destructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsFrameArena::~CUserMapsFrameArena()
+{
+	freeBlocks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void *CUserMapsFrameArena::allocate(size_t size, size_t alignment)
+///
+/// \brief  Returns memory valid until the enclosing scope is closed or the
+///         arena is reset.
+///
+/// \param  size - Size in bytes.
+///         alignment - Alignment in bytes, a power of two not larger than that
+///                     of operator new.
+///
+/// \return First byte of the memory.
+////////////////////////////////////////////////////////////////////////////////
+void *CUserMapsFrameArena::allocate(size_t size, size_t alignment)
+{
+	// Blocks left by a rewound scope are filled again before new ones are added
+	while ( m_current < m_blocks.size() )
+	{
+		const ArenaBlock &block = m_blocks[m_current];
+		size_t start = ( m_offset + alignment - 1 ) & ~( alignment - 1 );
+		if ( start + size <= block.m_size )
+		{
+			m_offset = start + size;
+			return block.m_pData + start;
+		}
+
+		++m_current;
+		m_offset = 0;
+	}
+
+	addBlock(std::max(size, BLOCK_SIZE));
+	m_offset = size;
+	return m_blocks.back().m_pData;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsFrameArena::reset()
+///
+/// \brief  Gives all memory back, at the start of a synchronisation. If the
+///         last one needed several blocks they are replaced by one block of
+///         their total size, so the next one fits without allocating.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsFrameArena::reset()
+{
+	if ( m_blocks.size() > 1 )
+	{
+		size_t size = capacity();
+		freeBlocks();
+		addBlock(size);
+	}
+
+	m_current = 0;
+	m_offset = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     size_t CUserMapsFrameArena::capacity() const
+///
+/// \brief  Returns total size of the blocks in bytes.
+////////////////////////////////////////////////////////////////////////////////
+size_t CUserMapsFrameArena::capacity() const
+{
+	size_t size = 0;
+	for (const ArenaBlock &block : m_blocks)
+		size += block.m_size;
+	return size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsFrameArena::addBlock(size_t size)
+///
+/// \brief  Appends a block and makes it the current one.
+///
+/// \param  size - Size of the block in bytes.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsFrameArena::addBlock(size_t size)
+{
+	ArenaBlock block = { static_cast<char *>(::operator new(size)), size };
+	m_blocks.push_back(block);
+	m_current = m_blocks.size() - 1;
+	m_offset = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsFrameArena::freeBlocks()
+///
+/// \brief  Gives all blocks back to the heap.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsFrameArena::freeBlocks()
+{
+	for (const ArenaBlock &block : m_blocks)
+		::operator delete(block.m_pData);
+	m_blocks.clear();
+	m_current = 0;
+	m_offset = 0;
+}
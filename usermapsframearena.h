@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsframearena.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsFrameArena class, a bump allocator for
+///			the temporary geometry containers of a synchronisation.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSFRAMEARENA_H
+#define USERMAPSFRAMEARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsFrameArena - memory for containers which live no longer
+///        than one synchronisation (triangulation state, simplified outlines,
+///        vertices on their way into a pool).
+///
+/// Allocation moves a pointer forward within a block; freeing does nothing.
+/// A Scope rewinds the arena to where it was when the scope was opened, so
+/// memory of one object is reused for the next. reset() merges the blocks
+/// into one of the total size, so once a scene has been built steady-state
+/// synchronisations allocate nothing from the heap. An arena is used by one
+/// thread at a time.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsFrameArena
+{
+public:
+	static const size_t BLOCK_SIZE = 64 * 1024;	///< Minimum size of a block in bytes.
+
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief Scope - rewinds an arena when it goes out of scope. Containers
+	///        allocated from the arena must be declared after it.
+	////////////////////////////////////////////////////////////////////////////
+	class Scope
+	{
+	public:
+		explicit Scope(CUserMapsFrameArena *pArena);
+		~Scope();
+
+	private:
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+		CUserMapsFrameArena *m_pArena;	///< Arena to rewind, may be nullptr.
+		size_t m_block;					///< Current block when the scope was opened.
+		size_t m_offset;				///< Offset into the block when the scope was opened.
+	};
+
+	CUserMapsFrameArena();
+	~CUserMapsFrameArena();
+
+	void *allocate(size_t size, size_t alignment);
+	void reset();
+	size_t capacity() const;
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief ArenaBlock - one heap allocation of the arena.
+	////////////////////////////////////////////////////////////////////////////
+	struct ArenaBlock
+	{
+		char *m_pData;		///< First byte of the block.
+		size_t m_size;		///< Size of the block in bytes.
+	};
+
+	CUserMapsFrameArena(const CUserMapsFrameArena &) = delete;
+	CUserMapsFrameArena &operator=(const CUserMapsFrameArena &) = delete;
+
+	void addBlock(size_t size);
+	void freeBlocks();
+
+	std::vector<ArenaBlock> m_blocks;	///< Blocks, filled one after another.
+	size_t m_current;					///< Block allocations are taken from.
+	size_t m_offset;					///< First free byte of the current block.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsArenaAllocator - standard allocator taking memory from a
+///        frame arena, or from the heap if it has none.
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class UserMapsArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef UserMapsArenaAllocator<U> other;
+	};
+
+	UserMapsArenaAllocator(CUserMapsFrameArena *pArena = nullptr)
+		: m_pArena(pArena)
+	{
+	}
+
+	template <typename U>
+	UserMapsArenaAllocator(const UserMapsArenaAllocator<U> &other)
+		: m_pArena(other.arena())
+	{
+	}
+
+	T *allocate(size_t count)
+	{
+		if ( m_pArena == nullptr )
+			return static_cast<T *>(::operator new(count * sizeof(T)));
+		return static_cast<T *>(m_pArena->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T *p, size_t)
+	{
+		// Arena memory is given back by a scope or reset()
+		if ( m_pArena == nullptr )
+			::operator delete(p);
+	}
+
+	CUserMapsFrameArena *arena() const
+	{
+		return m_pArena;
+	}
+
+private:
+	CUserMapsFrameArena *m_pArena;	///< Arena, nullptr for the heap.
+};
+
+template <typename T, typename U>
+bool operator==(const UserMapsArenaAllocator<T> &a, const UserMapsArenaAllocator<U> &b)
+{
+	return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const UserMapsArenaAllocator<T> &a, const UserMapsArenaAllocator<U> &b)
+{
+	return a.arena() != b.arena();
+}
+
+template <typename T>
+using UserMapsArenaVector = std::vector<T, UserMapsArenaAllocator<T> >;
+
+#endif // USERMAPSFRAMEARENA_H
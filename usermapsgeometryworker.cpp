@@ -0,0 +1,1214 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsgeometryworker.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsGeometryWorker class, a thread building
+///			the render-ready geometry of the user maps layer.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsgeometryworker.h"
+#include <QDebug>
+#include <algorithm>
+#include "usermapsprofiler.h"
+#include "../OpenGLBaseLib/genericvertexdata.h"
+
+static const int BUILD_CHUNK_VERTICES = 4096; ///< Geometry build tasks are cut after about this many input vertices.
+static const size_t RECYCLED_UPDATES = 4; ///< Updates kept for reuse, more are freed.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsSceneSnapshot::UserMapsSceneSnapshot()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsSceneSnapshot::UserMapsSceneSnapshot()
+	: m_lodLevel(0),
+	  m_isSceneChanged(true)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsGeometryWorker::CUserMapsGeometryWorker()
+///
+/// \brief  Constructor. Starts the worker thread.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsGeometryWorker::CUserMapsGeometryWorker()
+	: m_hasPendingSnapshot(false),
+	  m_isStopping(false),
+	  m_outlineBuf(sizeof(MapVertexData)),
+	  m_iconAtlasRevision(0),
+	  m_lodLevel(0)
+{
+	for (int i = 0; i < m_taskPool.threadCount(); ++i)
+		m_buildScratch.push_back(std::unique_ptr<UserMapsBuildScratch>(new UserMapsBuildScratch()));
+
+	m_thread = std::thread(&CUserMapsGeometryWorker::workerLoop, this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsGeometryWorker::~CUserMapsGeometryWorker()
+///
+/// \brief  Destructor. Waits for a running build and stops the worker thread.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsGeometryWorker::~CUserMapsGeometryWorker()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_wakeUp.notify_all();
+	m_thread.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::setPublishedCallback(const std::function<void()> &callback)
+///
+/// \brief  Sets the function called on the worker thread whenever an update has
+///         been published, e.g. to schedule a new frame.
+///
+/// \param  callback - Function to be called.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::setPublishedCallback(const std::function<void()> &callback)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_publishedCallback = callback;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::post(const UserMapsSceneSnapshot &snapshot)
+///
+/// \brief  Hands a snapshot to the worker. A snapshot which has not been built
+///         yet is replaced, keeping its scene change.
+///
+/// \param  snapshot - Loaded maps, world space and cull bounds.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::post(const UserMapsSceneSnapshot &snapshot)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		bool isSceneChanged = ( m_hasPendingSnapshot && m_pendingSnapshot.m_isSceneChanged );
+		m_pendingSnapshot = snapshot;
+		m_pendingSnapshot.m_isSceneChanged = m_pendingSnapshot.m_isSceneChanged || isSceneChanged;
+		m_hasPendingSnapshot = true;
+	}
+	m_wakeUp.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::takeUpdates(std::vector<QSharedPointer<UserMapsSceneUpdate> > &updates)
+///
+/// \brief  Takes the updates published since the last call by swapping the
+///         lists, so the caller is blocked only for the swap.
+///
+/// \param  updates - Empty list, receives the updates in publishing order.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::takeUpdates(std::vector<QSharedPointer<UserMapsSceneUpdate> > &updates)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	updates.swap(m_publishedUpdates);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::recycleUpdates(std::vector<QSharedPointer<UserMapsSceneUpdate> > &updates)
+///
+/// \brief  Hands applied updates back, so publish() reuses them and the lists
+///         in them keep their capacity.
+///
+/// \param  updates - Updates the renderer has applied, cleared.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::recycleUpdates(std::vector<QSharedPointer<UserMapsSceneUpdate> > &updates)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (const QSharedPointer<UserMapsSceneUpdate> &pUpdate : updates)
+		{
+			if ( m_recycledUpdates.size() < RECYCLED_UPDATES )
+				m_recycledUpdates.push_back(pUpdate);
+		}
+	}
+	updates.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsGeometryWorker::resolvePick(quint32 pickId, UserMapsPickTarget &target) const
+///
+/// \brief  Looks up the object of a pick id read back by the renderer. May be
+///         called from any thread, also while a snapshot is being built.
+///
+/// \param  pickId - Id read from the pick buffer, 0 for the background.
+///         target - Receives the object.
+///
+/// \return True if the id stands for an object that can be selected.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsGeometryWorker::resolvePick(quint32 pickId, UserMapsPickTarget &target) const
+{
+	return m_pickTable.resolve(pickId, target);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::recyclePickIds(std::vector<quint32> &pickIds)
+///
+/// \brief  Hands the pick ids of removed objects back to be reused. May be
+///         called from any thread.
+///
+/// \param  pickIds - Ids taken from applied updates, cleared.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::recyclePickIds(std::vector<quint32> &pickIds)
+{
+	m_pickTable.recycle(pickIds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::workerLoop()
+///
+/// \brief  Body of the worker thread: builds the latest snapshot whenever one
+///         has been posted.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::workerLoop()
+{
+	for (;;)
+	{
+		UserMapsSceneSnapshot snapshot;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [this] { return m_isStopping || m_hasPendingSnapshot; });
+			if ( m_isStopping )
+				return;
+
+			std::swap(snapshot, m_pendingSnapshot);
+			m_hasPendingSnapshot = false;
+		}
+
+		build(snapshot);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::build(const UserMapsSceneSnapshot &snapshot)
+///
+/// \brief  Brings the scene up to date with a snapshot and publishes the changes.
+///         Only objects added, removed or edited since the previous snapshot
+///         are rebuilt; if only the view (cull bounds or level of detail) has
+///         changed, only the draw lists are.
+///
+/// \param  snapshot - Loaded maps, world space and cull bounds.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::build(const UserMapsSceneSnapshot &snapshot)
+{
+	// Temporary containers of the previous build are given back at once
+	m_frameArena.reset();
+	for (const std::unique_ptr<UserMapsBuildScratch> &pScratch : m_buildScratch)
+		pScratch->m_arena.reset();
+
+	m_projection = snapshot.m_projection;
+
+	bool isViewChanged = ( !( snapshot.m_cullBounds == m_cullBounds ) || snapshot.m_lodLevel != m_lodLevel );
+	m_cullBounds = snapshot.m_cullBounds;
+	m_lodLevel = snapshot.m_lodLevel;
+
+	bool isSceneChanged = false;
+	if ( snapshot.m_isSceneChanged )
+	{
+		m_sceneCache.beginSync(m_projection.anchorRevision());
+
+		{
+			CUserMapsScopedTimer timer(EUserMapsPhase::MapIteration);
+
+			for (const UserMapsMapSnapshot &map : snapshot.m_maps)
+			{
+				for (size_t status = 0; status < map.m_points.size(); ++status)
+				{
+					updatePointsData(map.m_mapName, map.m_points[status]);
+					updateLines(map.m_mapName, map.m_lines[status]);
+					updateCircles(map.m_mapName, map.m_circles[status]);
+					updatePolygons(map.m_mapName, map.m_areas[status]);
+				}
+
+				// pick selected objects
+				updateSelectedObject(map.m_mapName, map.m_pSelectedObject);
+			}
+		}
+
+		// Changed objects are built in parallel and stored in visiting order
+		buildGeometry();
+		commitGeometry();
+
+		isSceneChanged = m_sceneCache.endSync();
+
+		// Give the vertex ranges of removed objects back to the buffers
+		for (const QSharedPointer<UserMapsCacheEntry> &pEntry : m_sceneCache.takeRemovedEntries())
+			releaseGeometry(*pEntry);
+
+		if ( isSceneChanged )
+			rebuildSpatialIndex();
+	}
+
+	bool isDrawListChanged = ( isSceneChanged || isViewChanged );
+	if ( isDrawListChanged )
+		rebuildDrawLists();
+
+	// Icon instances also refer to the atlas layout
+	bool isIconInstancesChanged = ( isDrawListChanged || m_iconAtlas.revision() != m_iconAtlasRevision );
+	if ( isIconInstancesChanged )
+		rebuildIconInstances();
+
+	publish(isDrawListChanged, isIconInstancesChanged);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsGeometryWorker::publish(bool isDrawListChanged, bool isIconInstancesChanged)
+///
+/// \brief  Collects the changes of the last build into an update and hands it
+///         to the renderer. Nothing is published if nothing has changed.
+///
+/// \param  isDrawListChanged - True if the draw lists have been rebuilt.
+///         isIconInstancesChanged - True if the icon instances have been rebuilt.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::publish(bool isDrawListChanged, bool isIconInstancesChanged)
+{
+	QSharedPointer<UserMapsSceneUpdate> pUpdate;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if ( !m_recycledUpdates.empty() )
+		{
+			pUpdate = m_recycledUpdates.back();
+			m_recycledUpdates.pop_back();
+		}
+	}
+	if ( pUpdate.isNull() )
+		pUpdate = QSharedPointer<UserMapsSceneUpdate>(new UserMapsSceneUpdate());
+
+	pUpdate->m_iconAtlas = QImage();
+	pUpdate->m_projection = m_projection;
+	pUpdate->m_isDrawListChanged = isDrawListChanged;
+	pUpdate->m_isIconInstancesChanged = isIconInstancesChanged;
+
+	bool isChanged = m_outlineBuf.takeChanges(pUpdate->m_outlineChanges);
+	isChanged = m_styleTable.takeChanges(pUpdate->m_styleChanges) || isChanged;
+	isChanged = m_palette.takeChanges(pUpdate->m_paletteChanges) || isChanged;
+	isChanged = m_iconAtlas.takeImage(pUpdate->m_iconAtlas) || isChanged;
+
+	// Released pick ids must reach the renderer, or they are never reused
+	pUpdate->m_releasedPickIds.clear();
+	m_pickTable.takeReleasedIds(pUpdate->m_releasedPickIds);
+	isChanged = !pUpdate->m_releasedPickIds.empty() || isChanged;
+
+	// Draw lists are rebuilt from scratch next time, so they can be handed over
+	if ( isDrawListChanged )
+	{
+		m_outlineIndices.swapIndices(pUpdate->m_outlineIndices);
+		m_filledPolygonIndices.swapIndices(pUpdate->m_filledPolygonIndices);
+		pUpdate->m_circleInstances.swap(m_circleInstances);
+	}
+	if ( isIconInstancesChanged )
+		pUpdate->m_iconInstances.swap(m_iconInstances);
+
+	std::function<void()> callback;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if ( !isChanged && !isDrawListChanged && !isIconInstancesChanged )
+		{
+			m_recycledUpdates.push_back(pUpdate);
+			return;
+		}
+
+		m_publishedUpdates.push_back(pUpdate);
+		callback = m_publishedCallback;
+	}
+
+	if ( callback )
+		callback();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updateLines(const QString &mapName, const UserMapsObjectList &loadedLines)
+///
+/// \brief	Collects the lines changed since the last snapshot, so their
+///			geometry is rebuilt.
+///
+/// \param	mapName - Name of the map holding the lines.
+///			loadedLines- lines that should be drawn.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updateLines(const QString &mapName, const UserMapsObjectList &loadedLines )
+{
+	if(loadedLines.empty()) return; //if there is not any line return
+
+	for (const UserMapsObjectDataPtr &pLine : loadedLines)
+	{
+		bool isDirty = false;
+		UserMapsCacheEntry *pEntry = m_sceneCache.touch(UserMapsObjectKey(pLine->m_pObject), pLine->m_revision, isDirty);
+		if ( !isDirty )
+			continue;
+
+		pEntry->m_type = EUserMapObjectType::Line;
+		pEntry->m_mapName = mapName;
+		pEntry->m_objectId = pLine->m_objectId;
+		addBuildItem(pEntry, pLine);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updateLine(const UserMapsObjectData &line, UserMapsCacheEntry &entry,
+///										UserMapsBuildScratch &scratch)
+///
+/// \brief	Add points so line could be drawn. Runs on a build thread.
+///
+/// \param	line - Copy of the line.
+///			entry - Cache entry where line points will be stored.
+///			scratch - Working arrays of the build task.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updateLine(const UserMapsObjectData &line, UserMapsCacheEntry &entry,
+								   UserMapsBuildScratch &scratch)
+{
+	UserMapsColour colour = convertColour(line.m_colour, line.m_transparency);
+
+	// Positions in world space
+	projectToWorld(line.m_positions, scratch);
+
+	// Built in place, colour is read from the style table, not from the vertices
+	CUserMapsVertexData &outline = entry.m_outline;
+	outline.clearVertexData();
+	outline.reserveVertexData(scratch.m_worldX.size());
+	entry.m_bounds = UserMapsBounds();
+	for (size_t i = 0; i < scratch.m_worldX.size(); ++i)
+	{
+		outline.emplaceVertexData(QVector4D( static_cast<float>(scratch.m_worldX[i]), static_cast<float>(scratch.m_worldY[i]), 0.0f, 1.0f), QVector4D());
+		entry.m_bounds.unite(scratch.m_worldX[i], scratch.m_worldY[i]);
+	}
+
+	scratch.m_simplifier.simplify(scratch.m_worldX.data(), scratch.m_worldY.data(), static_cast<int>(outline.vertexCount()), false,
+								  entry.m_vertexLevels, entry.m_levelSizes);
+
+	entry.m_outlineColour = colour;
+	setLineStyle(entry.m_outline, line.m_lineStyle, line.m_lineWidth);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updateCircles(const QString &mapName, const UserMapsObjectList &loadedCircles)
+///
+/// \brief	Collects the circles changed since the last snapshot, so their
+///			geometry is rebuilt.
+///
+/// \param	mapName - Name of the map holding the circles.
+///			loadedCircles - Circles that should be drawn.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updateCircles(const QString &mapName, const UserMapsObjectList &loadedCircles)
+{
+	if(loadedCircles.empty())
+		return;
+
+	for (const UserMapsObjectDataPtr &pCircle : loadedCircles)
+	{
+		bool isDirty = false;
+		UserMapsCacheEntry *pEntry = m_sceneCache.touch(UserMapsObjectKey(pCircle->m_pObject), pCircle->m_revision, isDirty);
+		if ( !isDirty )
+			continue;
+
+		pEntry->m_type = EUserMapObjectType::Circle;
+		pEntry->m_mapName = mapName;
+		pEntry->m_objectId = pCircle->m_objectId;
+		addBuildItem(pEntry, pCircle);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updateCircle(const UserMapsObjectData &circle, UserMapsCacheEntry &entry)
+///
+/// \brief	Sets centre, radius, colours and line style of a circle, which the circle
+///			shader draws from one instance record. Runs on a build thread.
+///
+/// \param	circle - Copy of the circle.
+///         entry - Cache entry where the circle will be stored.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updateCircle(const UserMapsObjectData &circle, UserMapsCacheEntry &entry)
+{
+	// Centre and radius in world space
+	const CPosition &centre = circle.m_positions.first();
+	UserMapsCircleGeometry &geometry = entry.m_circle;
+	geometry.m_centre = m_projection.toWorld(centre.Latitude(), centre.Longitude());
+	geometry.m_radius = m_projection.toWorldDistance(centre.Latitude(), circle.m_radius);
+	geometry.m_outlineColour = convertColour(circle.m_outlineColour);
+	geometry.m_fillColour = convertColour(circle.m_colour, circle.m_transparency);
+
+	double xCenter = geometry.m_centre.x();
+	double yCenter = geometry.m_centre.y();
+	entry.m_bounds = UserMapsBounds(xCenter - geometry.m_radius, yCenter - geometry.m_radius,
+									xCenter + geometry.m_radius, yCenter + geometry.m_radius);
+
+	setLineStyle(entry.m_outline, circle.m_lineStyle, circle.m_lineWidth);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updatePolygons(const QString &mapName, const UserMapsObjectList &loadedAreas)
+///
+/// \brief	Collects the areas changed since the last snapshot, so their
+///			geometry is rebuilt.
+///
+/// \param	mapName - Name of the map holding the areas.
+///			loadedAreas - Received areas that should be drawn.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updatePolygons(const QString &mapName, const UserMapsObjectList &loadedAreas)
+{
+	if(loadedAreas.empty())
+		return;
+
+	for (const UserMapsObjectDataPtr &pArea : loadedAreas)
+	{
+		bool isDirty = false;
+		UserMapsCacheEntry *pEntry = m_sceneCache.touch(UserMapsObjectKey(pArea->m_pObject), pArea->m_revision, isDirty);
+		if ( !isDirty )
+			continue;
+
+		pEntry->m_type = EUserMapObjectType::Area;
+		pEntry->m_mapName = mapName;
+		pEntry->m_objectId = pArea->m_objectId;
+		addBuildItem(pEntry, pArea);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updatePolygon(const UserMapsObjectData &area, UserMapsCacheEntry &entry,
+///										   bool isTriangulationDirty, UserMapsBuildScratch &scratch)
+///
+/// \brief	Add area points so polygon could be drawn. The inline is drawn from
+///			the outline vertices; it is triangulated again only when the
+///			point list of the area has changed. Runs on a build thread.
+///
+/// \param	area - Copy of the area.
+///         entry - Cache entry where outline and triangulated area will be stored.
+///			isTriangulationDirty - True if entry.m_pTriangulation is new and has to be filled.
+///			scratch - Working arrays of the build task.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updatePolygon(const UserMapsObjectData &area, UserMapsCacheEntry &entry,
+									  bool isTriangulationDirty, UserMapsBuildScratch &scratch)
+{
+	UserMapsColour outlineColour = convertColour(area.m_outlineColour);
+
+	// Positions in world space
+	projectToWorld(area.m_positions, scratch);
+
+	// Built in place
+	CUserMapsVertexData &polygon = entry.m_outline;
+	polygon.clearVertexData();
+	polygon.reserveVertexData(scratch.m_worldX.size());
+	entry.m_bounds = UserMapsBounds();
+	for (size_t i = 0; i < scratch.m_worldX.size(); ++i)
+	{
+		polygon.emplaceVertexData(QVector4D( static_cast<float>(scratch.m_worldX[i]), static_cast<float>(scratch.m_worldY[i]), 0.0f, 1.0f), QVector4D());
+		entry.m_bounds.unite(scratch.m_worldX[i], scratch.m_worldY[i]);
+	}
+
+	scratch.m_simplifier.simplify(scratch.m_worldX.data(), scratch.m_worldY.data(), static_cast<int>(polygon.vertexCount()), true,
+								  entry.m_vertexLevels, entry.m_levelSizes);
+
+	// Triangles are shared with the selected copy and survive colour or style edits.
+	// Areas off screen are triangulated when they come into view.
+	if ( isTriangulationDirty && entry.m_bounds.intersects(m_cullBounds) )
+	{
+		int level = CUserMapsSimplifier::effectiveLevel(entry.m_levelSizes, m_lodLevel);
+		triangulateLevel(polygon.getVertexData(), entry, level);
+		entry.m_pTriangulation->m_isTriangulated[static_cast<size_t>(level)] = true;
+	}
+
+	entry.m_fillColour = convertColour(area.m_colour, area.m_transparency);
+	entry.m_outlineColour = outlineColour;
+
+	setLineStyle(entry.m_outline, area.m_lineStyle, area.m_lineWidth);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updatePointsData(const QString &mapName, const UserMapsObjectList &pointData)
+///
+/// \brief	Collects the points changed since the last snapshot, so their
+///			data is rebuilt. Points of a build task are projected in one batch.
+///
+/// \param	mapName - Name of the map holding the points.
+///			pointData - Textures details.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updatePointsData(const QString &mapName, const UserMapsObjectList &pointData)
+{
+	for (const UserMapsObjectDataPtr &pPoint : pointData)
+	{
+		bool isDirty = false;
+		UserMapsCacheEntry *pEntry = m_sceneCache.touch(UserMapsObjectKey(pPoint->m_pObject), pPoint->m_revision, isDirty);
+		if ( !isDirty )
+			continue;
+
+		pEntry->m_type = EUserMapObjectType::Point;
+		pEntry->m_mapName = mapName;
+		pEntry->m_objectId = pPoint->m_objectId;
+		addBuildItem(pEntry, pPoint);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updatePointData(const UserMapsObjectData &uPoint,
+///											const QPointF &worldPos, UserMapsCacheEntry &entry)
+///
+/// \brief	Updates points so they could be drawn. Runs on a build thread; the icon
+///			is looked up in the atlas when the geometry is committed.
+///
+/// \param	uPoint - Copy of the UserMapPoint.
+///			worldPos - Position of the point in world space, projected into pixels when drawn.
+///			entry - Cache entry where point data and texture will be stored.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updatePointData(const UserMapsObjectData &uPoint, const QPointF &worldPos,
+										UserMapsCacheEntry &entry)
+{
+	MapPoint data;
+
+	double xPos = worldPos.x();
+	double yPos = worldPos.y();
+
+	// Set attributes
+
+	data.m_icon = uPoint.m_icon;
+	data.m_iconSize = uPoint.m_iconSize;
+	data.m_colour = convertColour(uPoint.m_colour,uPoint.m_transparency);
+	data.m_vertexData= GenericVertexData(QVector4D( static_cast<float>(xPos), static_cast<float>(yPos), 0.0f, 1.0f ),QVector4D());
+
+	entry.m_point = data;
+	entry.m_bounds = UserMapsBounds(xPos, yPos, xPos, yPos);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::updateSelectedObject(const QString &mapName,
+///													const UserMapsObjectDataPtr &pObject)
+///
+/// \brief	Adds the selected object of a map so it is drawn on top of the map contents.
+///
+/// \param	mapName - Name of the map.
+///			pObject - Copy of the selected object, null if none.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::updateSelectedObject(const QString &mapName, const UserMapsObjectDataPtr &pObject)
+{
+	if ( pObject.isNull() || pObject->m_type == EUserMapObjectType::Unkown_Object )
+		return;
+
+	bool isDirty = false;
+	UserMapsCacheEntry *pEntry = m_sceneCache.touch(UserMapsObjectKey(pObject->m_pObject, true), pObject->m_revision, isDirty);
+	if ( !isDirty && pEntry->m_type == pObject->m_type )
+		return;
+
+	pEntry->m_type = pObject->m_type;
+	pEntry->m_mapName = mapName;
+	pEntry->m_objectId = -1;
+	addBuildItem(pEntry, pObject);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::addBuildItem(UserMapsCacheEntry *pEntry, const UserMapsObjectDataPtr &pObject)
+///
+/// \brief	Queues an object for the geometry build. Shared state (the triangulation
+///			cache) is looked up here, on the worker thread, so build tasks only
+///			write to their own entries.
+///
+/// \param	pEntry - Cache entry of the object, its type must be set.
+///			pObject - Copy of the object to be rebuilt.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::addBuildItem(UserMapsCacheEntry *pEntry, const UserMapsObjectDataPtr &pObject)
+{
+	UserMapsBuildItem item;
+	item.m_pEntry = pEntry;
+	item.m_pObject = pObject;
+	item.m_isTriangulationDirty = false;
+
+	if ( pEntry->m_type == EUserMapObjectType::Area )
+	{
+		pEntry->m_pTriangulation = m_sceneCache.triangulation(pObject->m_pObject, pObject->m_geometryRevision,
+															  item.m_isTriangulationDirty);
+	}
+
+	m_buildItems.push_back(item);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::buildGeometry()
+///
+/// \brief	Builds the geometry of all queued objects on the task pool. Items are
+///			cut into tasks per map and about BUILD_CHUNK_VERTICES input vertices,
+///			so large areas get a task of their own and points are projected in
+///			batches.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::buildGeometry()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::GeometryBuild);
+
+	m_buildChunks.clear();
+
+	int chunkVertices = 0;
+	for (size_t i = 0; i < m_buildItems.size(); ++i)
+	{
+		const UserMapsBuildItem &item = m_buildItems[i];
+		int vertices = 1;
+		switch (item.m_pEntry->m_type)
+		{
+		case EUserMapObjectType::Line:
+		case EUserMapObjectType::Area:
+			vertices = item.m_pObject->m_positions.size();
+			break;
+		default:
+			break;
+		}
+
+		bool isNewMap = ( i > 0 && item.m_pEntry->m_mapName != m_buildItems[i - 1].m_pEntry->m_mapName );
+		if ( m_buildChunks.empty() || isNewMap || chunkVertices + vertices > BUILD_CHUNK_VERTICES )
+		{
+			m_buildChunks.push_back(static_cast<int>(i));
+			chunkVertices = 0;
+		}
+		chunkVertices += vertices;
+	}
+
+	int chunkCount = static_cast<int>(m_buildChunks.size());
+	m_buildChunks.push_back(static_cast<int>(m_buildItems.size()));
+
+	m_taskPool.run(chunkCount, [this](int chunk) { buildChunk(chunk); });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::buildChunk(int chunk)
+///
+/// \brief	Build task: builds the geometry of the items of one chunk into their
+///			cache entries. Runs on any thread of the task pool, with the working
+///			arrays of that thread.
+///
+/// \param	chunk - Index into m_buildChunks.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::buildChunk(int chunk)
+{
+	UserMapsBuildScratch &scratch = *m_buildScratch[static_cast<size_t>(CUserMapsTaskPool::currentThread())];
+	scratch.m_latitudes.clear();
+	scratch.m_longitudes.clear();
+
+	size_t first = static_cast<size_t>(m_buildChunks[static_cast<size_t>(chunk)]);
+	size_t end = static_cast<size_t>(m_buildChunks[static_cast<size_t>(chunk) + 1]);
+
+	// Points of the chunk in one batch
+	for (size_t i = first; i < end; ++i)
+	{
+		const UserMapsBuildItem &item = m_buildItems[i];
+		if ( item.m_pEntry->m_type != EUserMapObjectType::Point )
+			continue;
+
+		const CPosition &position = item.m_pObject->m_positions.first();
+		scratch.m_latitudes.push_back(position.Latitude());
+		scratch.m_longitudes.push_back(position.Longitude());
+	}
+
+	size_t pointCount = scratch.m_latitudes.size();
+	if ( pointCount > 0 )
+	{
+		scratch.m_worldX.resize(pointCount);
+		scratch.m_worldY.resize(pointCount);
+		m_projection.toWorld(scratch.m_latitudes.data(), scratch.m_longitudes.data(), static_cast<int>(pointCount),
+							 scratch.m_worldX.data(), scratch.m_worldY.data());
+	}
+
+	CUserMapsFrameArena::Scope scope(&scratch.m_arena);
+	UserMapsArenaAllocator<QPointF> allocator(&scratch.m_arena);
+	UserMapsArenaVector<QPointF> pointPositions(allocator);
+	pointPositions.reserve(pointCount);
+	for (size_t i = 0; i < pointCount; ++i)
+		pointPositions.push_back(QPointF(scratch.m_worldX[i], scratch.m_worldY[i]));
+
+	size_t point = 0;
+	for (size_t i = first; i < end; ++i)
+	{
+		const UserMapsBuildItem &item = m_buildItems[i];
+		switch (item.m_pEntry->m_type)
+		{
+		case EUserMapObjectType::Point:
+			updatePointData(*item.m_pObject, pointPositions[point++], *item.m_pEntry);
+			break;
+		case EUserMapObjectType::Circle:
+			updateCircle(*item.m_pObject, *item.m_pEntry);
+			break;
+		case EUserMapObjectType::Line:
+			updateLine(*item.m_pObject, *item.m_pEntry, scratch);
+			break;
+		case EUserMapObjectType::Area:
+			updatePolygon(*item.m_pObject, *item.m_pEntry, item.m_isTriangulationDirty, scratch);
+			break;
+		case EUserMapObjectType::Unkown_Object:
+			break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::commitGeometry()
+///
+/// \brief	Moves the built geometry into the vertex buffers and style table. Runs
+///			on the worker thread in the order the objects were visited, so the
+///			vertex ranges do not depend on how the build tasks were scheduled.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::commitGeometry()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::GeometryCommit);
+
+	for (const UserMapsBuildItem &item : m_buildItems)
+	{
+		UserMapsCacheEntry &entry = *item.m_pEntry;
+		if ( entry.m_pickId == 0 )
+		{
+			UserMapsPickTarget target;
+			target.m_mapName = entry.m_mapName;
+			target.m_type = entry.m_type;
+			target.m_objectId = entry.m_objectId;
+			entry.m_pickId = m_pickTable.allocate(target);
+		}
+
+		switch (entry.m_type)
+		{
+		case EUserMapObjectType::Point:
+			// Icon file is read only the first time the icon is used, colour is applied when drawn
+			entry.m_point.m_atlasIndex = m_iconAtlas.iconIndex(entry.m_point.m_icon);
+			break;
+		case EUserMapObjectType::Circle:
+			// Drawn from its instance record, a circle has no vertices
+			storeGeometry(entry, nullptr);
+			break;
+		case EUserMapObjectType::Line:
+		case EUserMapObjectType::Area:
+			storeGeometry(entry, &m_outlineBuf);
+			break;
+		case EUserMapObjectType::Unkown_Object:
+			break;
+		}
+	}
+
+	m_buildItems.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::projectToWorld(const QVector<CPosition> &positions,
+///											UserMapsBuildScratch &scratch) const
+///
+/// \brief	Projects the positions of a line or an area into world space in one
+///			batch, results are left in scratch.m_worldX and scratch.m_worldY.
+///			The path stays continuous across the antimeridian.
+///
+/// \param	positions - Geo positions.
+///			scratch - Working arrays of the build task.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::projectToWorld(const QVector<CPosition> &positions, UserMapsBuildScratch &scratch) const
+{
+	size_t count = static_cast<size_t>(positions.size());
+	scratch.m_latitudes.resize(count);
+	scratch.m_longitudes.resize(count);
+	scratch.m_worldX.resize(count);
+	scratch.m_worldY.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const CPosition &position = positions[static_cast<int>(i)];
+		scratch.m_latitudes[i] = position.Latitude();
+		scratch.m_longitudes[i] = position.Longitude();
+	}
+
+	m_projection.toWorldPath(scratch.m_latitudes.data(), scratch.m_longitudes.data(), static_cast<int>(count),
+							 scratch.m_worldX.data(), scratch.m_worldY.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::rebuildSpatialIndex()
+///
+/// \brief	Indexes the bounds of all cached objects, one index per map. Objects
+///			of a map are next to each other in the draw order. Called only when
+///			the scene has changed.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::rebuildSpatialIndex()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::SpatialIndex);
+
+	m_mapIndices.clear();
+
+	const UserMapsObjectTable &objects = m_sceneCache.objectTable();
+	for (size_t i = 0; i < objects.m_types.size(); ++i)
+	{
+		if ( static_cast<int>(m_mapIndices.size()) <= objects.m_maps[i] )
+		{
+			m_mapIndices.push_back(UserMapsMapIndex());
+			m_mapIndices.back().m_mapName = objects.m_entries[i]->m_mapName;
+		}
+
+		m_mapIndices.back().m_index.insert(objects.m_bounds[i], static_cast<int>(i));
+	}
+
+	for (UserMapsMapIndex &mapIndex : m_mapIndices)
+		mapIndex.m_index.build();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::rebuildDrawLists()
+///
+/// \brief	Collects the cached objects inside the cull bounds into the draw lists.
+///			Called when the scene or the cull bounds have changed; vertices
+///			already live in the vertex buffers.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::rebuildDrawLists()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::DrawLists);
+
+	m_visiblePoints.clear();
+	m_outlineIndices.clear();
+	m_filledPolygonIndices.clear();
+	m_circleInstances.clear();
+
+	// Maps entirely outside the view are skipped without looking at their objects
+	m_visibleObjects.clear();
+	for (const UserMapsMapIndex &mapIndex : m_mapIndices)
+	{
+		if ( mapIndex.m_index.bounds().intersects(m_cullBounds) )
+			mapIndex.m_index.query(m_cullBounds, m_visibleObjects);
+	}
+	std::sort(m_visibleObjects.begin(), m_visibleObjects.end());
+
+	triangulateDeferredAreas();
+
+	// Type, range and level come from the object table, entries are read only for what they alone hold
+	const UserMapsObjectTable &objects = m_sceneCache.objectTable();
+	for (int position : m_visibleObjects)
+	{
+		size_t object = static_cast<size_t>(position);
+		switch (objects.m_types[object])
+		{
+		case EUserMapObjectType::Point:
+			m_visiblePoints.push_back(position);
+			break;
+
+		case EUserMapObjectType::Line:
+			m_outlineIndices.addStrip(objects.m_outlineRanges[object], objects.m_entries[object]->m_vertexLevels,
+									  objects.levelOf(object, m_lodLevel), false);
+			break;
+
+		case EUserMapObjectType::Circle:
+		{
+			const UserMapsCacheEntry *pEntry = objects.m_entries[object];
+			const UserMapsCircleGeometry &circle = pEntry->m_circle;
+			CircleInstanceData instance;
+			instance.m_centre = QVector2D(static_cast<float>(circle.m_centre.x()), static_cast<float>(circle.m_centre.y()));
+			instance.m_radius = static_cast<float>(circle.m_radius);
+			instance.m_lineWidth = pEntry->m_outline.GetLineWidth();
+			instance.m_colours = QVector4D(m_palette.index(circle.m_fillColour.m_key), circle.m_fillColour.m_opacity,
+										   m_palette.index(circle.m_outlineColour.m_key), circle.m_outlineColour.m_opacity);
+			instance.m_lineStyle = QVector4D(pEntry->m_outline.getDashSize(), pEntry->m_outline.getGapSize(),
+											 pEntry->m_outline.getDotSize(), 0.0f);
+			instance.m_pickId = static_cast<float>(pEntry->m_pickId);
+			m_circleInstances.push_back(instance);
+			break;
+		}
+
+		case EUserMapObjectType::Area:
+		{
+			const UserMapsCacheEntry *pEntry = objects.m_entries[object];
+			const UserMapsVertexRange &range = objects.m_outlineRanges[object];
+			int level = objects.levelOf(object, m_lodLevel);
+			m_outlineIndices.addStrip(range, pEntry->m_vertexLevels, level, true);
+
+			const UserMapsTriangulation *pTriangulation = pEntry->m_pTriangulation.data();
+			if ( pTriangulation != nullptr && pTriangulation->m_levelCount[static_cast<size_t>(level)] > 0 )
+			{
+				m_filledPolygonIndices.addTriangles(range, &pTriangulation->m_indices[static_cast<size_t>(pTriangulation->m_levelFirst[static_cast<size_t>(level)])],
+													pTriangulation->m_levelCount[static_cast<size_t>(level)]);
+			}
+			break;
+		}
+
+		case EUserMapObjectType::Unkown_Object:
+			break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::triangulateDeferredAreas()
+///
+/// \brief	Triangulates the visible areas not triangulated at the current level
+///			of detail yet (they were off screen, or drawn at other levels), in
+///			parallel on the task pool.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::triangulateDeferredAreas()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::Triangulation);
+
+	m_deferredAreas.clear();
+
+	const UserMapsObjectTable &objects = m_sceneCache.objectTable();
+	for (int position : m_visibleObjects)
+	{
+		size_t object = static_cast<size_t>(position);
+		if ( objects.m_types[object] != EUserMapObjectType::Area )
+			continue;
+
+		UserMapsCacheEntry *pEntry = objects.m_entries[object];
+		if ( pEntry->m_pTriangulation.isNull() )
+			continue;
+
+		// Set here, so an area and its selected copy are triangulated once
+		size_t level = static_cast<size_t>(objects.levelOf(object, m_lodLevel));
+		if ( pEntry->m_pTriangulation->m_isTriangulated[level] )
+			continue;
+
+		pEntry->m_pTriangulation->m_isTriangulated[level] = true;
+		m_deferredAreas.push_back(pEntry);
+	}
+
+	m_taskPool.run(static_cast<int>(m_deferredAreas.size()), [this](int area)
+	{
+		const UserMapsCacheEntry &entry = *m_deferredAreas[static_cast<size_t>(area)];
+		triangulateLevel(entry.m_outline.getVertexData(), entry,
+						 CUserMapsSimplifier::effectiveLevel(entry.m_levelSizes, m_lodLevel));
+	});
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::triangulateLevel(const std::vector<GenericVertexData> &outline,
+///												const UserMapsCacheEntry &entry, int level)
+///
+/// \brief	Triangulates the outline of an area as simplified at a level of detail.
+///			Triangles index the full outline, so all levels draw from the same
+///			vertices, and are appended to the triangle list of the area. Runs on
+///			any thread of the task pool, one task per triangulation; working
+///			state is taken from the arena of that thread.
+///
+/// \param	outline - Outline vertices of the area.
+///			entry - Cache entry of the area, receives the triangles.
+///			level - Level of detail, from CUserMapsSimplifier::effectiveLevel().
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::triangulateLevel(const std::vector<GenericVertexData> &outline,
+											   const UserMapsCacheEntry &entry, int level)
+{
+	UserMapsTriangulation &triangulation = *entry.m_pTriangulation;
+	std::vector<uint> &indices = triangulation.m_indices;
+	size_t first = indices.size();
+	triangulation.m_levelFirst[static_cast<size_t>(level)] = static_cast<int>(first);
+
+	CUserMapsFrameArena *pArena = &m_buildScratch[static_cast<size_t>(CUserMapsTaskPool::currentThread())]->m_arena;
+	if ( level == 0 || entry.m_vertexLevels.size() != outline.size() )
+	{
+		Triangulate::Process(outline, indices, pArena); //triangulate received points
+		triangulation.m_levelCount[static_cast<size_t>(level)] = static_cast<int>(indices.size() - first);
+		return;
+	}
+
+	CUserMapsFrameArena::Scope scope(pArena);
+	UserMapsArenaAllocator<GenericVertexData> allocator(pArena);
+	UserMapsArenaVector<GenericVertexData> simplified(allocator);
+	UserMapsArenaVector<uint> outlineIndices(allocator);
+	simplified.reserve(outline.size());
+	outlineIndices.reserve(outline.size());
+	for (size_t i = 0; i < outline.size(); ++i)
+	{
+		if ( entry.m_vertexLevels[i] < level )
+			continue;
+
+		simplified.push_back(outline[i]);
+		outlineIndices.push_back(static_cast<uint>(i));
+	}
+
+	Triangulate::Process(simplified.data(), static_cast<int>(simplified.size()), indices, pArena);
+	for (size_t i = first; i < indices.size(); ++i)
+		indices[i] = outlineIndices[indices[i]];
+	triangulation.m_levelCount[static_cast<size_t>(level)] = static_cast<int>(indices.size() - first);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::rebuildIconInstances()
+///
+/// \brief	Collects position, colour, atlas rectangle and size of every point icon
+///			for the instanced draw. Called only when points or the atlas have changed.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::rebuildIconInstances()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::IconInstances);
+
+	m_iconInstances.clear();
+	m_iconInstances.reserve(m_visiblePoints.size());
+
+	const UserMapsObjectTable &objects = m_sceneCache.objectTable();
+	for (int position : m_visiblePoints)
+	{
+		const UserMapsCacheEntry *pEntry = objects.m_entries[static_cast<size_t>(position)];
+		const MapPoint &point = pEntry->m_point;
+		if ( point.m_atlasIndex < 0 )
+			continue;
+
+		// Images are designed to be 20 texels/mm
+		QSize iconSize = m_iconAtlas.iconSize(point.m_atlasIndex);
+		QVector2D sizeMm(iconSize.width() / 20.0f, iconSize.height() / 20.0f);
+
+		// Icon size of the point (mm) sets the longer side
+		float longerSide = qMax(sizeMm.x(), sizeMm.y());
+		if ( point.m_iconSize > 0.0f && longerSide > 0.0f )
+			sizeMm *= point.m_iconSize / longerSide;
+
+		IconInstanceData instance;
+		instance.m_position = point.m_vertexData.position().toVector2D();
+		instance.m_colour = QVector2D(m_palette.index(point.m_colour.m_key), point.m_colour.m_opacity);
+		instance.m_textureRect = m_iconAtlas.textureRect(point.m_atlasIndex);
+		instance.m_sizeMm = sizeMm;
+		instance.m_pickId = static_cast<float>(pEntry->m_pickId);
+		m_iconInstances.push_back(instance);
+	}
+
+	m_iconAtlasRevision = m_iconAtlas.revision();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::storeGeometry(UserMapsCacheEntry &entry, CUserMapsVertexPool *pOutlinePool)
+///
+/// \brief	Writes the geometry of an object into its vertex ranges. Ranges are kept
+///			if the number of vertices has not changed, so an edited object is
+///			updated in place. Line style, pick id and palette indices of the
+///			colours go into the style table; the vertex buffer gets only
+///			positions and the style table slot.
+///
+/// \param	entry - Cache entry holding the geometry.
+///			pOutlinePool - Buffer for the outline, nullptr if the object has none.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::storeGeometry(UserMapsCacheEntry &entry, CUserMapsVertexPool *pOutlinePool)
+{
+	CUserMapsFrameArena::Scope scope(&m_frameArena);
+	UserMapsArenaAllocator<MapVertexData> allocator(&m_frameArena);
+	UserMapsArenaVector<MapVertexData> outline(allocator);
+	if ( pOutlinePool != nullptr )
+	{
+		if ( entry.m_styleSlot < 0 )
+			entry.m_styleSlot = m_styleTable.allocate();
+
+		m_styleTable.setTexel(entry.m_styleSlot, CUserMapsStyleTable::LINE_STYLE_TEXEL,
+							  QVector4D(entry.m_outline.getDashSize(), entry.m_outline.getGapSize(),
+										entry.m_outline.getDotSize(), static_cast<float>(entry.m_pickId)));
+		m_styleTable.setTexel(entry.m_styleSlot, CUserMapsStyleTable::COLOUR_TEXEL,
+							  QVector4D(m_palette.index(entry.m_fillColour.m_key), entry.m_fillColour.m_opacity,
+										m_palette.index(entry.m_outlineColour.m_key), entry.m_outlineColour.m_opacity));
+
+		const std::vector<GenericVertexData> &vertices = entry.m_outline.getVertexData();
+		outline.reserve(vertices.size());
+		for (const GenericVertexData &vertex : vertices)
+		{
+			QVector4D position = vertex.position();
+			outline.push_back(MapVertexData(position.x(), position.y(), static_cast<quint32>(entry.m_styleSlot)));
+		}
+	}
+	else
+	{
+		m_styleTable.deallocate(entry.m_styleSlot);
+	}
+
+	storeVertices(entry.m_pOutlinePool, entry.m_outlineRange, pOutlinePool, outline);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::storeVertices(CUserMapsVertexPool *&pCurrentPool, UserMapsVertexRange &range,
+///							CUserMapsVertexPool *pPool, const UserMapsArenaVector<MapVertexData> &vertices)
+///
+/// \brief	Writes vertices into a range of a buffer, (re)allocating the range if needed.
+///
+/// \param	pCurrentPool - Buffer the range is currently allocated in.
+///			range - Range of the vertices.
+///			pPool - Buffer the vertices should be stored in, nullptr to only release the range.
+///			vertices - Vertices to be stored.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::storeVertices(CUserMapsVertexPool *&pCurrentPool, UserMapsVertexRange &range,
+									  CUserMapsVertexPool *pPool, const UserMapsArenaVector<MapVertexData> &vertices)
+{
+	int count = ( pPool != nullptr ) ? static_cast<int>(vertices.size()) : 0;
+	if ( pCurrentPool != pPool || range.m_count != count )
+	{
+		if ( pCurrentPool != nullptr )
+			pCurrentPool->deallocate(range);
+
+		pCurrentPool = pPool;
+		if ( pPool != nullptr )
+			range = pPool->allocate(count);
+	}
+
+	if ( pPool != nullptr )
+		pPool->write(range, vertices.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::releaseGeometry(UserMapsCacheEntry &entry)
+///
+/// \brief	Gives the vertex ranges, style slot and pick id of a removed object back.
+///
+/// \param	entry - Cache entry of the removed object.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::releaseGeometry(UserMapsCacheEntry &entry)
+{
+	if ( entry.m_pOutlinePool != nullptr )
+		entry.m_pOutlinePool->deallocate(entry.m_outlineRange);
+
+	entry.m_pOutlinePool = nullptr;
+	m_styleTable.deallocate(entry.m_styleSlot);
+	m_pickTable.deallocate(entry.m_pickId);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn UserMapsColour CUserMapsGeometryWorker::convertColour(int colourKey, float opacity)
+///
+/// \brief  This function is used for converting colour of an object. The key is
+///         resolved through the palette when drawn, so a palette switch does
+///         not touch the geometry.
+///
+/// \param	colourKey - Colour that should be converted.
+///			opacity - opacity.
+///
+/// \return	Colour key and opacity.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsColour CUserMapsGeometryWorker::convertColour(int colourKey, float opacity)
+{
+	return UserMapsColour(colourKey, opacity);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsGeometryWorker::setLineStyle(CUserMapsVertexData& tempData, EUserMapLineStyle lineStyle, float lineWidth)
+///
+/// \brief	This function is used for setting up linestyles.
+///
+/// \param	tempData - Data to be drawn.
+///			lineStyle - Enumerated lineStyle.
+///			lineWidth - Width of the line.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsGeometryWorker::setLineStyle(CUserMapsVertexData& tempData, EUserMapLineStyle lineStyle, float lineWidth)
+{
+	switch (lineStyle)
+	{
+	case EUserMapLineStyle::Solid :
+	{
+		tempData.setDashSize(30.0f);
+		tempData.setDotSize(0.0f);
+		tempData.setGapSize(0.0f);
+		break;
+	}
+	
+	case EUserMapLineStyle::Dashed :
+	{
+		tempData.setDashSize(15.0f);
+		tempData.setDotSize(0.0f);
+		tempData.setGapSize(15.0f);
+		break;
+	}
+	
+	case EUserMapLineStyle::Dotted :
+	{
+		tempData.setDashSize(2.0f);
+		tempData.setGapSize(10.0f);
+		tempData.setDotSize(0.0f);
+		break;
+	}
+	
+	case EUserMapLineStyle::Dot_Dash :
+	{
+		tempData.setDashSize(30.0f);
+		tempData.setGapSize(15.0f);
+		tempData.setDotSize(10.0f);
+		break;
+	}
+	}
+	tempData.setLineWidth(lineWidth);
+}
@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsgeometryworker.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsGeometryWorker class, a thread building
+///			the render-ready geometry of the user maps layer.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSGEOMETRYWORKER_H
+#define USERMAPSGEOMETRYWORKER_H
+
+#include <QImage>
+#include <QMap>
+#include <QPointF>
+#include <QSharedPointer>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "triangulate.h"
+#include "usermapsvertexdata.h"
+#include "usermapsframearena.h"
+#include "usermapsscenecache.h"
+#include "usermapsscenesource.h"
+#include "usermapsspatialindex.h"
+#include "usermapssimplifier.h"
+#include "usermapsvertexpool.h"
+#include "usermapsindexbuffer.h"
+#include "usermapsstyletable.h"
+#include "usermapspalette.h"
+#include "usermapspicktable.h"
+#include "usermapsprojection.h"
+#include "usermapsiconatlas.h"
+#include "usermapstaskpool.h"
+#include "iconshaderprogram.h"
+#include "circleshaderprogram.h"
+#include "../UserMapsDataLib/usermap.h"
+#include "../UserMapsDataLib/UserMapObjects/usermappoint.h"
+#include "../UserMapsDataLib/UserMapObjects/usermaparea.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapcircle.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapline.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapobject.h"
+#include "../UserMapsDataLib/usermaplinestyle.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsSceneSnapshot - everything the worker reads to build a scene.
+///        User map objects are read through their copies only.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsSceneSnapshot
+{
+	UserMapsSceneSnapshot();
+
+	std::vector<UserMapsMapSnapshot> m_maps;	///< Loaded maps.
+	CUserMapsProjection m_projection;			///< World space to build the geometry in.
+	UserMapsBounds m_cullBounds;				///< Objects outside this world space box are not drawn.
+	int m_lodLevel;								///< Level of detail lines and areas are drawn at.
+	bool m_isSceneChanged;						///< False if only the view (cull bounds, level of detail) has changed since the last snapshot.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsSceneUpdate - changes of the render-ready scene published by
+///        the worker. Updates are applied to the OpenGL objects in the order
+///        they were published.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsSceneUpdate
+{
+	CUserMapsProjection m_projection;				///< World space the geometry was built in.
+	UserMapsVertexChanges m_outlineChanges;			///< Changed outline vertices.
+	UserMapsStyleChanges m_styleChanges;			///< Changed style table rows.
+	UserMapsPaletteChanges m_paletteChanges;		///< Colour keys used for the first time.
+	bool m_isDrawListChanged;						///< True if the draw lists below are valid.
+	std::vector<GLuint> m_outlineIndices;			///< Strips of all lines and outlines.
+	std::vector<GLuint> m_filledPolygonIndices;		///< Triangles of all filled polygons.
+	std::vector<CircleInstanceData> m_circleInstances;	///< Per circle data of the visible circles.
+	bool m_isIconInstancesChanged;					///< True if m_iconInstances is valid.
+	std::vector<IconInstanceData> m_iconInstances;	///< Per point data of the icons.
+	QImage m_iconAtlas;								///< New atlas image, null if unchanged.
+	std::vector<quint32> m_releasedPickIds;			///< Pick ids of the objects removed by this update.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsBuildItem - object whose geometry is rebuilt in this synchronisation.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsBuildItem
+{
+	UserMapsCacheEntry *m_pEntry;				///< Cache entry the geometry is built into.
+	UserMapsObjectDataPtr m_pObject;			///< Copy of the object the geometry is built from.
+	bool m_isTriangulationDirty;				///< True if an area has to be triangulated again.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsBuildScratch - working arrays of one task pool thread, kept
+///        between snapshots so building does not allocate once they have grown.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsBuildScratch
+{
+	std::vector<double> m_latitudes;	///< Latitudes passed to the batch projection.
+	std::vector<double> m_longitudes;	///< Longitudes passed to the batch projection.
+	std::vector<double> m_worldX;		///< World X from the batch projection.
+	std::vector<double> m_worldY;		///< World Y from the batch projection.
+	CUserMapsSimplifier m_simplifier;	///< Ranks line and outline vertices into levels of detail.
+	CUserMapsFrameArena m_arena;		///< Temporary containers of the tasks, reset for every snapshot.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsMapIndex - spatial index of the objects of one map.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsMapIndex
+{
+	QString m_mapName;					///< Name of the map.
+	CUserMapsSpatialIndex m_index;		///< Bounds of the objects, valued with their position in the draw order.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsGeometryWorker - builds the user map geometry on a thread of
+///        its own, so the GUI thread is not blocked while a large scene is built.
+///
+/// The renderer posts a snapshot of the loaded maps from synchronize(). The
+/// worker keeps the scene cache and the CPU side of all buffers, builds the
+/// objects changed since the previous snapshot and publishes the changed
+/// vertex ranges, style rows and draw lists as a UserMapsSceneUpdate. Only
+/// the latest snapshot is built if several are posted meanwhile. The renderer
+/// swaps the published updates out in synchronize() and uploads them in
+/// render().
+///
+/// Circles have no vertices: each is drawn as one instanced quad, on which
+/// the circle shader evaluates fill and dashed outline for any range.
+///
+/// Colours are kept as colour keys and passed to the shaders as palette
+/// indices; the renderer resolves the palette, so a palette switch builds
+/// nothing here.
+///
+/// Draw lists hold only the objects intersecting the cull bounds of the
+/// snapshot, found through an R-tree per map, so the draw cost follows what
+/// is visible rather than what is loaded. Lines and outlines are drawn at
+/// the level of detail of the snapshot, skipping the vertices that would be
+/// closer than the pixel tolerance. Areas are triangulated for a level only
+/// when they are first drawn at it, on screen.
+///
+/// Every object gets a pick id, drawn by the pick pass of the renderer; the
+/// renderer resolves the id read back with resolvePick(), from any thread.
+/// Ids of removed objects travel to the renderer with the update and come
+/// back through recyclePickIds() once no pick result can still refer to them.
+///
+/// Temporary containers (triangulation state, vertices on their way into a
+/// pool) are taken from frame arenas, one per task pool thread and one for
+/// the worker thread, reset at the start of every build. Published updates
+/// are handed back by the renderer with recycleUpdates() and reused, so
+/// their lists keep their capacity.
+///
+/// The worker never reads the user map objects, which the GUI thread edits
+/// in place: the snapshot holds copies made by CUserMapsSceneSource while
+/// the GUI thread was blocked, and an object edited meanwhile is copied again
+/// into the next snapshot.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsGeometryWorker
+{
+public:
+	CUserMapsGeometryWorker();
+	~CUserMapsGeometryWorker();
+
+	void setPublishedCallback(const std::function<void()> &callback);
+	void post(const UserMapsSceneSnapshot &snapshot);
+	void takeUpdates(std::vector<QSharedPointer<UserMapsSceneUpdate> > &updates);
+	void recycleUpdates(std::vector<QSharedPointer<UserMapsSceneUpdate> > &updates);
+	bool resolvePick(quint32 pickId, UserMapsPickTarget &target) const;
+	void recyclePickIds(std::vector<quint32> &pickIds);
+
+private:
+	void workerLoop();
+	void build(const UserMapsSceneSnapshot &snapshot);
+	void publish(bool isDrawListChanged, bool isIconInstancesChanged);
+
+	// Updates
+	void updateLines( const QString &mapName, const UserMapsObjectList &loadedLines);
+	void updateLine( const UserMapsObjectData &line, UserMapsCacheEntry &entry, UserMapsBuildScratch &scratch);
+	void updateCircles( const QString &mapName, const UserMapsObjectList &loadedCircles);
+	void updateCircle( const UserMapsObjectData &circle, UserMapsCacheEntry &entry);
+	void updatePolygons( const QString &mapName, const UserMapsObjectList &loadedAreas);
+	void updatePolygon( const UserMapsObjectData &area, UserMapsCacheEntry &entry, bool isTriangulationDirty,
+						UserMapsBuildScratch &scratch);
+	void updatePointsData( const QString &mapName, const UserMapsObjectList &uPointData);
+	void updatePointData( const UserMapsObjectData &uPoint, const QPointF &worldPos, UserMapsCacheEntry &entry);
+	void updateSelectedObject( const QString &mapName, const UserMapsObjectDataPtr &pObject);
+
+	void addBuildItem( UserMapsCacheEntry *pEntry, const UserMapsObjectDataPtr &pObject);
+	void buildGeometry();
+	void buildChunk( int chunk);
+	void commitGeometry();
+	void projectToWorld( const QVector<CPosition> &positions, UserMapsBuildScratch &scratch) const;
+	void rebuildSpatialIndex();
+	void rebuildDrawLists();
+	void triangulateDeferredAreas();
+	void triangulateLevel( const std::vector<GenericVertexData> &outline, const UserMapsCacheEntry &entry, int level);
+	void rebuildIconInstances();
+
+	void storeGeometry( UserMapsCacheEntry &entry, CUserMapsVertexPool *pOutlinePool);
+	void storeVertices( CUserMapsVertexPool *&pCurrentPool, UserMapsVertexRange &range,
+						CUserMapsVertexPool *pPool, const UserMapsArenaVector<MapVertexData> &vertices);
+	void releaseGeometry( UserMapsCacheEntry &entry);
+
+	UserMapsColour convertColour( int colourKey, float opacity = 1.0f);
+	void setLineStyle( CUserMapsVertexData& tempData, EUserMapLineStyle lineStyle, float lineWidth);
+
+	// Worker thread state, guarded by m_mutex
+	std::thread m_thread;							///< Worker thread.
+	std::mutex m_mutex;								///< Guards the handoff state below.
+	std::condition_variable m_wakeUp;				///< Signals a posted snapshot or shutdown.
+	UserMapsSceneSnapshot m_pendingSnapshot;		///< Latest snapshot not built yet.
+	bool m_hasPendingSnapshot;						///< True if m_pendingSnapshot is valid.
+	std::vector<QSharedPointer<UserMapsSceneUpdate> > m_publishedUpdates;	///< Updates not taken by the renderer yet.
+	std::vector<QSharedPointer<UserMapsSceneUpdate> > m_recycledUpdates;	///< Updates applied by the renderer, reused by publish().
+	std::function<void()> m_publishedCallback;		///< Called on the worker thread after an update is published.
+	bool m_isStopping;								///< True when the worker should exit.
+
+	// Scene, only used on the worker thread
+	CUserMapsSceneCache m_sceneCache;		///< Geometry of every object kept between snapshots.
+	CUserMapsProjection m_projection;		///< World space of the snapshot being built.
+	CUserMapsTaskPool m_taskPool;			///< Threads building the geometry of changed objects.
+	std::vector<std::unique_ptr<UserMapsBuildScratch> > m_buildScratch;	///< Working arrays of every task pool thread.
+	CUserMapsFrameArena m_frameArena;		///< Temporary containers of the worker thread, reset for every snapshot.
+	std::vector<UserMapsBuildItem> m_buildItems;	///< Objects to be rebuilt, in the order they were visited.
+	std::vector<int> m_buildChunks;			///< First build item of every build task, followed by the item count.
+	CUserMapsVertexPool m_outlineBuf;		///< Vertices of lines and outlines of polygons.
+	CUserMapsStyleTable m_styleTable;		///< Line style and colours of every object.
+	CUserMapsPalette m_palette;				///< Palette index of every colour key in use.
+	CUserMapsPickTable m_pickTable;			///< Object of every pick id, also read by the renderer.
+	CUserMapsIndexBuffer m_outlineIndices;	///< Strips of all lines and outlines, in draw order.
+	CUserMapsIndexBuffer m_filledPolygonIndices;	///< Triangles of all filled polygons, indexing the outline vertices.
+	std::vector<CircleInstanceData> m_circleInstances;	///< Per circle data of the visible circles, in draw order.
+	CUserMapsIconAtlas m_iconAtlas;			///< Icons of all points in one image.
+	std::vector<int> m_visiblePoints;		///< Draw order positions of the visible points.
+	std::vector<IconInstanceData> m_iconInstances;	///< Per point data of the drawn icons.
+	uint m_iconAtlasRevision;				///< Atlas layout the icon instances were built with.
+	UserMapsBounds m_cullBounds;			///< Cull bounds the draw lists were built for.
+	int m_lodLevel;							///< Level of detail the draw lists were built for.
+	std::vector<UserMapsMapIndex> m_mapIndices;	///< Spatial index of every map, in draw order.
+	std::vector<int> m_visibleObjects;		///< Draw order positions of the objects inside the cull bounds.
+	std::vector<UserMapsCacheEntry *> m_deferredAreas;	///< Visible areas not triangulated at the current level yet.
+};
+
+#endif // USERMAPSGEOMETRYWORKER_H
@@ -0,0 +1,694 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapshittester.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsHitTester class, finding the loaded
+///			user map object nearest to a position of the view.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapshittester.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include "../UserMapsDataLib/usermap.h"
+#include "../UserMapsDataLib/usermapsmanager.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsHitTester::HitRecord::HitRecord()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsHitTester::HitRecord::HitRecord()
+	: m_isPacked(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsHitTester::HitContainers::HitContainers()
+///
+/// \brief  Constructor. Empty containers.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsHitTester::HitContainers::HitContainers()
+	: m_status(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsHitTester::CUserMapsHitTester()
+///
+/// \brief  Constructor. The objects are indexed by the first query.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsHitTester::CUserMapsHitTester()
+	: m_removedPacked(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::markEdited(const void *pObject)
+///
+/// \brief  Makes the next query index an object edited in place again, which
+///         the containers do not tell. Unknown objects are ignored.
+///
+/// \param  pObject - Address of the object.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::markEdited(const void *pObject)
+{
+	if ( pObject != nullptr )
+		m_editedObjects.insert(pObject);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsHitTester::size() const
+///
+/// \brief  Returns number of indexed objects.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsHitTester::size() const
+{
+	return m_recordOf.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsHitTester::hitTest(const QPointF &position, double tolerance,
+///                                          const CUserMapsProjection &projection,
+///                                          UserMapsPickTarget &target)
+///
+/// \brief  Finds the object nearest to a position of the current view.
+///
+/// \param  position - Position in view pixels, relative to the view origin.
+///         tolerance - Largest distance in pixels an object is hit from.
+///         projection - Projection calibrated for the current view, just
+///                      before the query; a view calibrated before a zoom
+///                      or rotation tests against stale pixel positions.
+///         target - Receives the object hit.
+///
+/// \return True if an object is within the tolerance.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsHitTester::hitTest(const QPointF &position, double tolerance, const CUserMapsProjection &projection,
+								 UserMapsPickTarget &target)
+{
+	std::vector<HitContainers> containers;
+	takeContainers(containers);
+	refresh(containers);
+	m_containers.swap(containers);
+
+	// Tolerance box around the position, through geo into Mercator space
+	const double pixelX[4] = { position.x() - tolerance, position.x() + tolerance,
+							   position.x() - tolerance, position.x() + tolerance };
+	const double pixelY[4] = { position.y() - tolerance, position.y() - tolerance,
+							   position.y() + tolerance, position.y() + tolerance };
+	double latitudes[4];
+	double longitudes[4];
+	projection.fromPixel(pixelX, pixelY, 4, latitudes, longitudes);
+
+	double mercatorX[4];
+	double mercatorY[4];
+	for (int i = 0; i < 4; ++i)
+		CUserMapsProjection::toMercator(latitudes[i], longitudes[i], mercatorX[i], mercatorY[i]);
+	CUserMapsProjection::unwrapPath(mercatorX, 4);
+
+	UserMapsBounds region;
+	for (int i = 0; i < 4; ++i)
+		region.unite(mercatorX[i], mercatorY[i]);
+
+	// Paths are indexed unwrapped and may reach beyond the antimeridian, so the
+	// box is looked up in the neighbouring worlds as well
+	const double world = CUserMapsProjection::worldWidth();
+	const UserMapsBounds regions[3] =
+	{
+		region,
+		UserMapsBounds(region.m_minX - world, region.m_minY, region.m_maxX - world, region.m_maxY),
+		UserMapsBounds(region.m_minX + world, region.m_minY, region.m_maxX + world, region.m_maxY)
+	};
+
+	// Items of the tree set again or removed since it was packed are skipped
+	m_candidates.clear();
+	for (const UserMapsBounds &shifted : regions)
+		m_index.query(shifted, m_candidates);
+	m_candidates.erase(std::remove_if(m_candidates.begin(), m_candidates.end(),
+									  [this](int record) { return !m_records[record].m_isPacked; }),
+					   m_candidates.end());
+	for (int record : m_unpacked)
+	{
+		for (const UserMapsBounds &shifted : regions)
+		{
+			if ( m_records[record].m_bounds.intersects(shifted) )
+			{
+				m_candidates.push_back(record);
+				break;
+			}
+		}
+	}
+	std::sort(m_candidates.begin(), m_candidates.end());
+	m_candidates.erase(std::unique(m_candidates.begin(), m_candidates.end()), m_candidates.end());
+
+	int nearest = -1;
+	double nearestDistance = tolerance;
+	for (int record : m_candidates)
+	{
+		double distance = distanceTo(m_records[record], projection, position, tolerance);
+		if ( distance < nearestDistance || ( nearest < 0 && distance <= nearestDistance ) )
+		{
+			nearest = record;
+			nearestDistance = distance;
+		}
+	}
+
+	if ( nearest < 0 )
+		return false;
+
+	target = m_records[nearest].m_target;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::takeContainers(std::vector<HitContainers> &containers) const
+///
+/// \brief  Takes the object containers of all loaded maps. They are implicitly
+///         shared, so this does not depend on the number of objects.
+///
+/// \param  containers - Receives the containers, one item per map and status,
+///                      ordered by map name and status.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::takeContainers(std::vector<HitContainers> &containers) const
+{
+	const QMap<QString, QSharedPointer<CUserMap> > &loadedMaps = CUserMapsManager::getLoadedMapsStat();
+	containers.reserve(static_cast<size_t>(loadedMaps.size()) * 3);
+
+	QMap<QString, QSharedPointer<CUserMap>>::const_iterator iter = loadedMaps.constBegin();
+	while (iter != loadedMaps.constEnd())
+	{
+		auto &pMap = iter.value();
+		int status = 0;
+		for (auto item : {EUserMapObjectStatus::Loaded, EUserMapObjectStatus::Edited, EUserMapObjectStatus::Created})
+		{
+			HitContainers map;
+			map.m_mapName = iter.key();
+			map.m_status = status++;
+			map.m_points = pMap->getPoints().map(item);
+			map.m_lines = pMap->getLines().map(item);
+			map.m_circles = pMap->getCircles().map(item);
+			map.m_areas = pMap->getAreas().map(item);
+			containers.push_back(map);
+		}
+		iter++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::refresh(const std::vector<HitContainers> &containers)
+///
+/// \brief  Brings the index up to date with the current containers and the
+///         objects marked edited. Containers shared with those of the last
+///         refresh are skipped; the others are compared object by object with
+///         their previous state. Objects gone are removed before new ones are
+///         indexed, so an object moving between containers is kept.
+///
+/// \param  containers - Current containers, from takeContainers().
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::refresh(const std::vector<HitContainers> &containers)
+{
+	static const HitContainers EMPTY_CONTAINERS;
+
+	// Pair the containers of the last refresh with the current ones, both in order
+	std::vector<std::pair<const HitContainers *, const HitContainers *> > changed;
+	size_t previous = 0;
+	size_t current = 0;
+	while ( previous < m_containers.size() || current < containers.size() )
+	{
+		int order = 0;
+		if ( previous == m_containers.size() )
+			order = 1;
+		else if ( current == containers.size() )
+			order = -1;
+		else
+			order = compare(m_containers[previous], containers[current]);
+
+		const HitContainers *pPrevious = ( order <= 0 ) ? &m_containers[previous++] : &EMPTY_CONTAINERS;
+		const HitContainers *pCurrent = ( order >= 0 ) ? &containers[current++] : &EMPTY_CONTAINERS;
+		if ( !isSharedWith(*pPrevious, *pCurrent) )
+			changed.push_back(std::make_pair(pPrevious, pCurrent));
+	}
+
+	for (const auto &pair : changed)
+	{
+		removeObjects(pair.first->m_points, pair.second->m_points);
+		removeObjects(pair.first->m_lines, pair.second->m_lines);
+		removeObjects(pair.first->m_circles, pair.second->m_circles);
+		removeObjects(pair.first->m_areas, pair.second->m_areas);
+	}
+
+	for (const auto &pair : changed)
+	{
+		const QString &mapName = pair.second->m_mapName;
+		addObjects(mapName, EUserMapObjectType::Point, pair.first->m_points, pair.second->m_points);
+		addObjects(mapName, EUserMapObjectType::Line, pair.first->m_lines, pair.second->m_lines);
+		addObjects(mapName, EUserMapObjectType::Circle, pair.first->m_circles, pair.second->m_circles);
+		addObjects(mapName, EUserMapObjectType::Area, pair.first->m_areas, pair.second->m_areas);
+	}
+
+	for (const void *pObject : m_editedObjects)
+	{
+		QHash<const void *, int>::const_iterator found = m_recordOf.constFind(pObject);
+		if ( found != m_recordOf.constEnd() )
+			reindex(found.value());
+	}
+	m_editedObjects.clear();
+
+	const int limit = std::max(4 * CUserMapsSpatialIndex::NODE_CAPACITY, m_recordOf.size() / 8);
+	if ( static_cast<int>(m_unpacked.size()) > limit || m_removedPacked > limit )
+		pack();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     template <typename T> void CUserMapsHitTester::removeObjects(
+///             const QMap<int, QSharedPointer<T> > &previousObjects,
+///             const QMap<int, QSharedPointer<T> > &objects)
+///
+/// \brief  Removes the objects of a container which are no longer in it.
+///
+/// \param  previousObjects - Container at the last refresh.
+///         objects - Container now.
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void CUserMapsHitTester::removeObjects(const QMap<int, QSharedPointer<T> > &previousObjects,
+									   const QMap<int, QSharedPointer<T> > &objects)
+{
+	for (auto it = previousObjects.constBegin(); it != previousObjects.constEnd(); ++it)
+	{
+		if ( it.value().isNull() || objects.value(it.key()) == it.value() )
+			continue;
+
+		QHash<const void *, int>::const_iterator found = m_recordOf.constFind(it.value().data());
+		if ( found != m_recordOf.constEnd() )
+			removeRecord(found.value());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     template <typename T> void CUserMapsHitTester::addObjects(const QString &mapName,
+///             EUserMapObjectType type, const QMap<int, QSharedPointer<T> > &previousObjects,
+///             const QMap<int, QSharedPointer<T> > &objects)
+///
+/// \brief  Indexes the objects of a container which were not in it.
+///
+/// \param  mapName - Name of the map holding the objects.
+///         type - Type of the objects.
+///         previousObjects - Container at the last refresh.
+///         objects - Container now.
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void CUserMapsHitTester::addObjects(const QString &mapName, EUserMapObjectType type,
+									const QMap<int, QSharedPointer<T> > &previousObjects,
+									const QMap<int, QSharedPointer<T> > &objects)
+{
+	for (auto it = objects.constBegin(); it != objects.constEnd(); ++it)
+	{
+		if ( it.value().isNull() || previousObjects.value(it.key()) == it.value() )
+			continue;
+
+		UserMapsPickTarget target;
+		target.m_mapName = mapName;
+		target.m_type = type;
+		target.m_objectId = it.key();
+		setRecord(recordFor(it.value()), it.value(), target, boundsOf(*it.value()));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::reindex(int record)
+///
+/// \brief  Takes the bounds of an indexed object again.
+///
+/// \param  record - Record index.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::reindex(int record)
+{
+	const QSharedPointer<CUserMapObject> pObject = m_records[record].m_pObject;
+	const UserMapsPickTarget target = m_records[record].m_target;
+
+	UserMapsBounds bounds;
+	switch ( target.m_type )
+	{
+	case EUserMapObjectType::Point:
+		bounds = boundsOf(*pObject.staticCast<CUserMapPoint>());
+		break;
+	case EUserMapObjectType::Line:
+		bounds = boundsOf(*pObject.staticCast<CUserMapLine>());
+		break;
+	case EUserMapObjectType::Area:
+		bounds = boundsOf(*pObject.staticCast<CUserMapArea>());
+		break;
+	case EUserMapObjectType::Circle:
+		bounds = boundsOf(*pObject.staticCast<CUserMapCircle>());
+		break;
+	default:
+		return;
+	}
+	setRecord(record, pObject, target, bounds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsHitTester::recordFor(const QSharedPointer<CUserMapObject> &pObject)
+///
+/// \brief  Returns record of an object, taking a free one if it is not
+///         indexed yet. A new record is set by setRecord().
+///
+/// \param  pObject - Object.
+///
+/// \return Record index.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsHitTester::recordFor(const QSharedPointer<CUserMapObject> &pObject)
+{
+	QHash<const void *, int>::const_iterator found = m_recordOf.constFind(pObject.data());
+	if ( found != m_recordOf.constEnd() )
+		return found.value();
+
+	int record = 0;
+	if ( !m_freeRecords.empty() )
+	{
+		record = m_freeRecords.back();
+		m_freeRecords.pop_back();
+	}
+	else
+	{
+		record = static_cast<int>(m_records.size());
+		m_records.push_back(HitRecord());
+	}
+
+	m_recordOf.insert(pObject.data(), record);
+	return record;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::setRecord(int record, const QSharedPointer<CUserMapObject> &pObject,
+///             const UserMapsPickTarget &target, const UserMapsBounds &bounds)
+///
+/// \brief  Stores an object into a record and lists the record as unpacked.
+///         Its old item in the tree, if any, is skipped from now on.
+///
+/// \param  record - Record index.
+///         pObject - Object.
+///         target - Map, type and id of the object.
+///         bounds - Box around the object in Mercator space.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::setRecord(int record, const QSharedPointer<CUserMapObject> &pObject,
+								   const UserMapsPickTarget &target, const UserMapsBounds &bounds)
+{
+	HitRecord &item = m_records[record];
+
+	if ( item.m_isPacked )
+	{
+		item.m_isPacked = false;
+		++m_removedPacked;
+		m_unpacked.push_back(record);
+	}
+	else if ( item.m_pObject.isNull() )
+	{
+		m_unpacked.push_back(record);
+	}
+
+	item.m_pObject = pObject;
+	item.m_target = target;
+	item.m_bounds = bounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::removeRecord(int record)
+///
+/// \brief  Removes an object from the index and frees its record.
+///
+/// \param  record - Record index.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::removeRecord(int record)
+{
+	HitRecord &item = m_records[record];
+
+	if ( item.m_isPacked )
+		++m_removedPacked;
+	else
+		m_unpacked.erase(std::remove(m_unpacked.begin(), m_unpacked.end(), record), m_unpacked.end());
+
+	m_recordOf.remove(item.m_pObject.data());
+	item = HitRecord();
+	m_freeRecords.push_back(record);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::pack()
+///
+/// \brief  Packs the tree again over all indexed objects, emptying the
+///         unpacked list.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::pack()
+{
+	m_index.clear();
+	for (size_t record = 0; record < m_records.size(); ++record)
+	{
+		HitRecord &item = m_records[record];
+		if ( item.m_pObject.isNull() )
+			continue;
+
+		m_index.insert(item.m_bounds, static_cast<int>(record));
+		item.m_isPacked = true;
+	}
+	m_index.build();
+
+	m_unpacked.clear();
+	m_removedPacked = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double CUserMapsHitTester::distanceTo(const HitRecord &record, const CUserMapsProjection &projection,
+///                                               const QPointF &position, double tolerance)
+///
+/// \brief  Measures the distance in view pixels between a position and an
+///         object.
+///
+/// \param  record - Indexed object.
+///         projection - Projection calibrated for the current view.
+///         position - Position in view pixels.
+///         tolerance - Distance given to a position inside an area or circle,
+///                     so that anything nearer within the tolerance wins.
+///
+/// \return Distance in pixels.
+////////////////////////////////////////////////////////////////////////////////
+double CUserMapsHitTester::distanceTo(const HitRecord &record, const CUserMapsProjection &projection,
+									  const QPointF &position, double tolerance)
+{
+	switch ( record.m_target.m_type )
+	{
+	case EUserMapObjectType::Point:
+	{
+		const CPosition &point = record.m_pObject.staticCast<CUserMapPoint>()->getPosition();
+		double latitude = point.Latitude();
+		double longitude = point.Longitude();
+		double x = 0.0;
+		double y = 0.0;
+		projection.toPixel(&latitude, &longitude, 1, &x, &y);
+		return std::hypot(x - position.x(), y - position.y());
+	}
+	case EUserMapObjectType::Line:
+	{
+		toPixel(projection, record.m_pObject.staticCast<CUserMapLine>()->getPoints());
+		if ( m_pixelX.size() == 1 )
+			return std::hypot(m_pixelX[0] - position.x(), m_pixelY[0] - position.y());
+
+		double distance = std::numeric_limits<double>::max();
+		for (size_t i = 1; i < m_pixelX.size(); ++i)
+			distance = std::min(distance, segmentDistance(position, m_pixelX[i - 1], m_pixelY[i - 1], m_pixelX[i], m_pixelY[i]));
+		return distance;
+	}
+	case EUserMapObjectType::Area:
+	{
+		toPixel(projection, record.m_pObject.staticCast<CUserMapArea>()->getPoints());
+		if ( m_pixelX.empty() )
+			return std::numeric_limits<double>::max();
+
+		// Outline, closing edge included, and even-odd rule for the inside
+		double distance = std::numeric_limits<double>::max();
+		bool isInside = false;
+		for (size_t i = 0, j = m_pixelX.size() - 1; i < m_pixelX.size(); j = i++)
+		{
+			distance = std::min(distance, segmentDistance(position, m_pixelX[j], m_pixelY[j], m_pixelX[i], m_pixelY[i]));
+			if ( ( m_pixelY[i] > position.y() ) != ( m_pixelY[j] > position.y() ) &&
+				 position.x() < ( m_pixelX[j] - m_pixelX[i] ) * ( position.y() - m_pixelY[i] ) / ( m_pixelY[j] - m_pixelY[i] ) + m_pixelX[i] )
+				isInside = !isInside;
+		}
+		return isInside ? std::min(distance, tolerance) : distance;
+	}
+	case EUserMapObjectType::Circle:
+	{
+		const CUserMapCircle &circle = *record.m_pObject.staticCast<CUserMapCircle>();
+		double latitude = circle.getCenter().Latitude();
+		double longitude = circle.getCenter().Longitude();
+		double x = 0.0;
+		double y = 0.0;
+		projection.toPixel(&latitude, &longitude, 1, &x, &y);
+
+		double radius = projection.pixelsPerWorldUnit() * CUserMapsProjection::toWorldDistance(latitude, circle.getRadius());
+		double distance = std::hypot(x - position.x(), y - position.y());
+		return distance < radius ? std::min(radius - distance, tolerance) : distance - radius;
+	}
+	default:
+		return std::numeric_limits<double>::max();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsHitTester::toPixel(const CUserMapsProjection &projection,
+///                                       const QVector<CPosition> &positions)
+///
+/// \brief  Projects the positions of an object into m_pixelX and m_pixelY.
+///
+/// \param  projection - Projection calibrated for the current view.
+///         positions - Positions of the object.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsHitTester::toPixel(const CUserMapsProjection &projection, const QVector<CPosition> &positions)
+{
+	size_t count = static_cast<size_t>(positions.size());
+	m_latitudes.resize(count);
+	m_longitudes.resize(count);
+	m_pixelX.resize(count);
+	m_pixelY.resize(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_latitudes[i] = positions[static_cast<int>(i)].Latitude();
+		m_longitudes[i] = positions[static_cast<int>(i)].Longitude();
+	}
+	projection.toPixel(m_latitudes.data(), m_longitudes.data(), static_cast<int>(count), m_pixelX.data(), m_pixelY.data());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapPoint &point)
+///
+/// \brief  Returns box around a point in Mercator space.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapPoint &point)
+{
+	double x = 0.0;
+	double y = 0.0;
+	CUserMapsProjection::toMercator(point.getPosition().Latitude(), point.getPosition().Longitude(), x, y);
+
+	UserMapsBounds bounds;
+	bounds.unite(x, y);
+	return bounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapLine &line)
+///
+/// \brief  Returns box around the points of a line in Mercator space.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapLine &line)
+{
+	return boundsOf(line.getPoints());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapArea &area)
+///
+/// \brief  Returns box around the points of an area in Mercator space.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapArea &area)
+{
+	return boundsOf(area.getPoints());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapCircle &circle)
+///
+/// \brief  Returns box around a circle in Mercator space, the radius scaled
+///         at the latitude of the centre as the renderer draws it.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds CUserMapsHitTester::boundsOf(const CUserMapCircle &circle)
+{
+	double x = 0.0;
+	double y = 0.0;
+	CUserMapsProjection::toMercator(circle.getCenter().Latitude(), circle.getCenter().Longitude(), x, y);
+
+	UserMapsBounds bounds;
+	bounds.unite(x, y);
+	return bounds.adjusted(CUserMapsProjection::toWorldDistance(circle.getCenter().Latitude(), circle.getRadius()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds CUserMapsHitTester::boundsOf(const QVector<CPosition> &positions)
+///
+/// \brief  Returns box around the positions of a path in Mercator space. The
+///         path is unwrapped from its first position, so one crossing the
+///         antimeridian gets a tight box reaching beyond it, not one spanning
+///         the world.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds CUserMapsHitTester::boundsOf(const QVector<CPosition> &positions)
+{
+	const double world = CUserMapsProjection::worldWidth();
+
+	UserMapsBounds bounds;
+	double previousX = 0.0;
+	for (int i = 0; i < positions.size(); ++i)
+	{
+		double x = 0.0;
+		double y = 0.0;
+		CUserMapsProjection::toMercator(positions[i].Latitude(), positions[i].Longitude(), x, y);
+		if ( i > 0 )
+			x = previousX + std::remainder(x - previousX, world);
+
+		bounds.unite(x, y);
+		previousX = x;
+	}
+	return bounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsHitTester::compare(const HitContainers &containers,
+///                                         const HitContainers &otherContainers)
+///
+/// \brief  Orders containers by map name and status, as takeContainers() does.
+///
+/// \return Negative, zero or positive if the containers come before, at the
+///         place of or after the other containers.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsHitTester::compare(const HitContainers &containers, const HitContainers &otherContainers)
+{
+	if ( containers.m_mapName != otherContainers.m_mapName )
+		return ( containers.m_mapName < otherContainers.m_mapName ) ? -1 : 1;
+	return containers.m_status - otherContainers.m_status;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsHitTester::isSharedWith(const HitContainers &containers,
+///                                              const HitContainers &otherContainers)
+///
+/// \brief  Checks whether containers are shared, so no object was added to or
+///         removed from them in between.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsHitTester::isSharedWith(const HitContainers &containers, const HitContainers &otherContainers)
+{
+	return containers.m_points.isSharedWith(otherContainers.m_points) &&
+		   containers.m_lines.isSharedWith(otherContainers.m_lines) &&
+		   containers.m_circles.isSharedWith(otherContainers.m_circles) &&
+		   containers.m_areas.isSharedWith(otherContainers.m_areas);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double CUserMapsHitTester::segmentDistance(const QPointF &position, double x0, double y0,
+///                                                    double x1, double y1)
+///
+/// \brief  Returns distance between a position and a segment.
+////////////////////////////////////////////////////////////////////////////////
+double CUserMapsHitTester::segmentDistance(const QPointF &position, double x0, double y0, double x1, double y1)
+{
+	double dx = x1 - x0;
+	double dy = y1 - y0;
+	double lengthSquared = dx * dx + dy * dy;
+
+	double t = 0.0;
+	if ( lengthSquared > 0.0 )
+		t = qBound(0.0, ( ( position.x() - x0 ) * dx + ( position.y() - y0 ) * dy ) / lengthSquared, 1.0);
+
+	return std::hypot(x0 + t * dx - position.x(), y0 + t * dy - position.y());
+}
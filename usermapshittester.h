@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapshittester.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsHitTester class, finding the loaded
+///			user map object nearest to a position of the view.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSHITTESTER_H
+#define USERMAPSHITTESTER_H
+
+#include <QHash>
+#include <QMap>
+#include <QPointF>
+#include <QSet>
+#include <QSharedPointer>
+#include <vector>
+#include "usermapspicktable.h"
+#include "usermapsprojection.h"
+#include "usermapsspatialindex.h"
+#include "../UserMapsDataLib/UserMapObjects/usermappoint.h"
+#include "../UserMapsDataLib/UserMapObjects/usermaparea.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapcircle.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapline.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsHitTester - nearest object within a pixel tolerance, over
+///        the objects of all loaded maps.
+///
+/// Objects are indexed by their bounds in Mercator space (nautical miles at
+/// the equator, no anchor), so the index does not depend on the view. A
+/// query looks the tolerance box up in the R-tree and measures only the
+/// objects found there, in view pixels: points by their position, lines by
+/// their segments, areas and circles by their outline or as hit anywhere
+/// inside, behind anything else within the tolerance.
+///
+/// The index follows the maps lazily: a query first compares the containers
+/// of the loaded maps with those seen last (cheap, they are implicitly
+/// shared) and walks only the containers which differ, indexing the objects
+/// added and removing those gone. Objects edited in place are not seen in
+/// the containers; the layer reports them by markEdited() and only these are
+/// indexed again. Changed objects go into a short list searched linearly;
+/// the tree is packed again only when that list or the removed items in the
+/// tree grow large. Queries are measured in the projection of the layer,
+/// which calibrates it when the view changes. Used on the GUI thread only.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsHitTester
+{
+public:
+	CUserMapsHitTester();
+
+	void markEdited(const void *pObject);
+	bool hitTest(const QPointF &position, double tolerance, const CUserMapsProjection &projection,
+				 UserMapsPickTarget &target);
+	int size() const;
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief HitRecord - one indexed object.
+	////////////////////////////////////////////////////////////////////////////
+	struct HitRecord
+	{
+		HitRecord();
+
+		QSharedPointer<CUserMapObject> m_pObject;	///< Object, nullptr if the record is free.
+		UserMapsPickTarget m_target;				///< Map, type and id of the object.
+		UserMapsBounds m_bounds;					///< Box around the object in Mercator space.
+		bool m_isPacked;							///< True if the record is in the packed tree.
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief HitContainers - object containers of one map and status, kept
+	///        to tell what has changed.
+	////////////////////////////////////////////////////////////////////////////
+	struct HitContainers
+	{
+		HitContainers();
+
+		QString m_mapName;										///< Name of the map.
+		int m_status;											///< Index of the object status, in takeContainers() order.
+		QMap<int, QSharedPointer<CUserMapPoint> > m_points;		///< Points.
+		QMap<int, QSharedPointer<CUserMapLine> > m_lines;		///< Lines.
+		QMap<int, QSharedPointer<CUserMapCircle> > m_circles;	///< Circles.
+		QMap<int, QSharedPointer<CUserMapArea> > m_areas;		///< Areas.
+	};
+
+	void takeContainers(std::vector<HitContainers> &containers) const;
+	void refresh(const std::vector<HitContainers> &containers);
+	template <typename T>
+	void removeObjects(const QMap<int, QSharedPointer<T> > &previousObjects, const QMap<int, QSharedPointer<T> > &objects);
+	template <typename T>
+	void addObjects(const QString &mapName, EUserMapObjectType type, const QMap<int, QSharedPointer<T> > &previousObjects,
+					const QMap<int, QSharedPointer<T> > &objects);
+	void reindex(int record);
+	int recordFor(const QSharedPointer<CUserMapObject> &pObject);
+	void setRecord(int record, const QSharedPointer<CUserMapObject> &pObject, const UserMapsPickTarget &target,
+				   const UserMapsBounds &bounds);
+	void removeRecord(int record);
+	void pack();
+
+	double distanceTo(const HitRecord &record, const CUserMapsProjection &projection, const QPointF &position,
+					  double tolerance);
+	void toPixel(const CUserMapsProjection &projection, const QVector<CPosition> &positions);
+
+	static UserMapsBounds boundsOf(const CUserMapPoint &point);
+	static UserMapsBounds boundsOf(const CUserMapLine &line);
+	static UserMapsBounds boundsOf(const CUserMapArea &area);
+	static UserMapsBounds boundsOf(const CUserMapCircle &circle);
+	static UserMapsBounds boundsOf(const QVector<CPosition> &positions);
+	static int compare(const HitContainers &containers, const HitContainers &otherContainers);
+	static bool isSharedWith(const HitContainers &containers, const HitContainers &otherContainers);
+	static double segmentDistance(const QPointF &position, double x0, double y0, double x1, double y1);
+
+	std::vector<HitRecord> m_records;				///< Indexed objects, value of the index items.
+	QHash<const void *, int> m_recordOf;			///< Record of every indexed object, by address.
+	std::vector<int> m_freeRecords;					///< Records of removed objects.
+	CUserMapsSpatialIndex m_index;					///< Packed tree over the records of the last pack().
+	std::vector<int> m_unpacked;					///< Records set since the last pack(), searched linearly.
+	int m_removedPacked;							///< Records in the tree removed or set again since the last pack().
+	std::vector<HitContainers> m_containers;		///< Containers of the last refresh, by map name and status.
+	QSet<const void *> m_editedObjects;				///< Objects edited in place since the last refresh.
+	std::vector<int> m_candidates;					///< Records found by the last query.
+	std::vector<double> m_latitudes;				///< Latitudes of the object being measured.
+	std::vector<double> m_longitudes;				///< Longitudes of the object being measured.
+	std::vector<double> m_pixelX;					///< Pixel X of the object being measured.
+	std::vector<double> m_pixelY;					///< Pixel Y of the object being measured.
+};
+
+#endif // USERMAPSHITTESTER_H
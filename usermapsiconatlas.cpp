@@ -0,0 +1,277 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsiconatlas.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsIconAtlas class, one texture holding
+///			every icon used by user map points.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsiconatlas.h"
+#include <QDebug>
+#include <cstring>
+#include "../UserMapsDataLib/usermapiconmanager.h"
+
+static const int INITIAL_ATLAS_SIZE = 256;	///< Width and height of a new atlas (texels).
+static const int MAX_ATLAS_SIZE = 4096;		///< Atlas does not grow beyond this size (texels).
+static const int ICON_PADDING = 1;			///< Empty texels around every icon, so filtering does not bleed.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsIconAtlas::CUserMapsIconAtlas()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsIconAtlas::CUserMapsIconAtlas()
+	: m_atlas(INITIAL_ATLAS_SIZE, INITIAL_ATLAS_SIZE, QImage::Format_RGBA8888),
+	  m_shelfX(0),
+	  m_shelfY(0),
+	  m_shelfHeight(0),
+	  m_isDirty(true),
+	  m_revision(0)
+{
+	m_atlas.fill(Qt::transparent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsIconAtlas::~CUserMapsIconAtlas()
+///
+/// \brief  Destructor. Requires current OpenGL context if the texture was created.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsIconAtlas::~CUserMapsIconAtlas()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsIconAtlas::iconIndex(int iconId)
+///
+/// \brief  Returns atlas index of an icon. The icon file is read only the first
+///         time the icon id is requested.
+///
+/// \param  iconId - Icon id known to CUserMapIconManager.
+///
+/// \return Atlas index, -1 if the icon could not be loaded.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsIconAtlas::iconIndex(int iconId)
+{
+	QHash<int, int>::const_iterator it = m_iconIndices.constFind(iconId);
+	if ( it != m_iconIndices.constEnd() )
+		return it.value();
+
+	QString strIconPath = CUserMapIconManager::instance()->getIconPath(iconId);
+	QImage icon(strIconPath);
+	if ( icon.isNull() )
+	{
+		qDebug() << "CUserMapsIconAtlas::iconIndex() failed! Icon could not be loaded:" << strIconPath;
+		m_iconIndices.insert(iconId, -1);
+		return -1;
+	}
+	icon = icon.convertToFormat(QImage::Format_RGBA8888);
+
+	QPoint position;
+	while ( !place(icon.size(), position) )
+	{
+		if ( m_atlas.width() >= MAX_ATLAS_SIZE && m_atlas.height() >= MAX_ATLAS_SIZE )
+		{
+			qDebug() << "CUserMapsIconAtlas::iconIndex() failed! Atlas is full";
+			m_iconIndices.insert(iconId, -1);
+			return -1;
+		}
+
+		// Grow the shorter side and pack all icons again
+		QSize size = m_atlas.size();
+		if ( size.height() < size.width() )
+			size.setHeight(size.height() * 2);
+		else
+			size.setWidth(size.width() * 2);
+		m_atlas = QImage(size, QImage::Format_RGBA8888);
+		repack();
+	}
+
+	int index = static_cast<int>(m_icons.size());
+	m_icons.push_back(icon);
+	m_iconRects.push_back(QRect(position, icon.size()));
+	for (int y = 0; y < icon.height(); ++y)
+		memcpy(m_atlas.scanLine(position.y() + y) + position.x() * 4, icon.constScanLine(y), static_cast<size_t>(icon.width()) * 4);
+
+	m_iconIndices.insert(iconId, index);
+	m_isDirty = true;
+	++m_revision;
+	return index;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     QVector4D CUserMapsIconAtlas::textureRect(int index) const
+///
+/// \brief  Returns texture coordinates of an icon.
+///
+/// \param  index - Atlas index.
+///
+/// \return Left, top, width and height in normalised texture coordinates.
+////////////////////////////////////////////////////////////////////////////////
+QVector4D CUserMapsIconAtlas::textureRect(int index) const
+{
+	const QRect &rect = m_iconRects[static_cast<size_t>(index)];
+	float width = static_cast<float>(m_atlas.width());
+	float height = static_cast<float>(m_atlas.height());
+	return QVector4D(rect.x() / width, rect.y() / height, rect.width() / width, rect.height() / height);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     QSize CUserMapsIconAtlas::iconSize(int index) const
+///
+/// \brief  Returns size of an icon image in texels.
+///
+/// \param  index - Atlas index.
+////////////////////////////////////////////////////////////////////////////////
+QSize CUserMapsIconAtlas::iconSize(int index) const
+{
+	return m_iconRects[static_cast<size_t>(index)].size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     uint CUserMapsIconAtlas::revision() const
+///
+/// \brief  Returns stamp of the atlas layout. Texture rectangles taken with
+///         another stamp are out of date.
+////////////////////////////////////////////////////////////////////////////////
+uint CUserMapsIconAtlas::revision() const
+{
+	return m_revision;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsIconAtlas::takeImage(QImage &image)
+///
+/// \brief  Returns the atlas image if icons were added since the last call,
+///         instead of uploading it. The image is implicitly shared, not copied.
+///
+/// \param  image - Receives the atlas image.
+///
+/// \return True if the image has changed.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsIconAtlas::takeImage(QImage &image)
+{
+	if ( !m_isDirty )
+		return false;
+
+	image = m_atlas;
+	m_isDirty = false;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIconAtlas::setImage(const QImage &image)
+///
+/// \brief  Replaces the atlas image by one taken from another atlas. It is
+///         uploaded on next bind().
+///
+/// \param  image - Atlas image from takeImage().
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIconAtlas::setImage(const QImage &image)
+{
+	m_atlas = image;
+	m_isDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsIconAtlas::bind(uint unit)
+///
+/// \brief  Uploads the atlas if icons were added and binds it. Requires current
+///         OpenGL context.
+///
+/// \param  unit - Texture unit.
+///
+/// \return True if the atlas texture is bound.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsIconAtlas::bind(uint unit)
+{
+	if ( m_isDirty )
+	{
+		m_pTexture.reset(new QOpenGLTexture(m_atlas, QOpenGLTexture::DontGenerateMipMaps));
+		m_pTexture->setMinificationFilter(QOpenGLTexture::Linear);
+		m_pTexture->setMagnificationFilter(QOpenGLTexture::Linear);
+		m_pTexture->setWrapMode(QOpenGLTexture::ClampToEdge);
+		m_isDirty = false;
+	}
+
+	if ( m_pTexture.isNull() || !m_pTexture->isCreated() )
+		return false;
+
+	m_pTexture->bind(unit);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIconAtlas::release()
+///
+/// \brief  Releases the atlas texture.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIconAtlas::release()
+{
+	if ( !m_pTexture.isNull() )
+		m_pTexture->release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsIconAtlas::place(const QSize &size, QPoint &position)
+///
+/// \brief  Finds room for an icon on the current or a new shelf.
+///
+/// \param  size - Icon size in texels.
+///         position - Top left corner of the icon in the atlas.
+///
+/// \return False if the atlas is full.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsIconAtlas::place(const QSize &size, QPoint &position)
+{
+	int width = size.width() + ICON_PADDING;
+	int height = size.height() + ICON_PADDING;
+
+	// Start a new shelf if the icon does not fit on the current one
+	if ( m_shelfX + width > m_atlas.width() )
+	{
+		m_shelfY += m_shelfHeight;
+		m_shelfX = 0;
+		m_shelfHeight = 0;
+	}
+
+	if ( width > m_atlas.width() || m_shelfY + height > m_atlas.height() )
+		return false;
+
+	position = QPoint(m_shelfX, m_shelfY);
+	m_shelfX += width;
+	m_shelfHeight = qMax(m_shelfHeight, height);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIconAtlas::repack()
+///
+/// \brief  Packs all loaded icons into the (resized) atlas image again.
+///         Icons which do not fit are dropped.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIconAtlas::repack()
+{
+	m_atlas.fill(Qt::transparent);
+	m_shelfX = 0;
+	m_shelfY = 0;
+	m_shelfHeight = 0;
+
+	for (size_t i = 0; i < m_icons.size(); ++i)
+	{
+		const QImage &icon = m_icons[i];
+		QPoint position;
+		if ( !place(icon.size(), position) )
+		{
+			m_iconRects[i] = QRect();
+			continue;
+		}
+
+		m_iconRects[i] = QRect(position, icon.size());
+		for (int y = 0; y < icon.height(); ++y)
+			memcpy(m_atlas.scanLine(position.y() + y) + position.x() * 4, icon.constScanLine(y), static_cast<size_t>(icon.width()) * 4);
+	}
+
+	m_isDirty = true;
+}
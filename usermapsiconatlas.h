@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsiconatlas.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsIconAtlas class, one texture holding
+///			every icon used by user map points.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSICONATLAS_H
+#define USERMAPSICONATLAS_H
+
+#include <QHash>
+#include <QImage>
+#include <QOpenGLTexture>
+#include <QRect>
+#include <QScopedPointer>
+#include <QVector4D>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsIconAtlas - shared texture of user map point icons.
+///
+/// Every icon (CUserMapIconManager icon id) is read from disk once, the first
+/// time a point uses it, and packed into a single atlas image (shelf packing).
+/// Icons are stored untinted; the point colour is applied in the shader, so
+/// points of any colour share the same texels. The OpenGL texture is only
+/// re-created when a new icon has been added. An atlas filled on another
+/// thread hands its image to the atlas of the renderer with takeImage().
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsIconAtlas
+{
+public:
+	CUserMapsIconAtlas();
+	~CUserMapsIconAtlas();
+
+	int iconIndex(int iconId);
+
+	QVector4D textureRect(int index) const;
+	QSize iconSize(int index) const;
+	uint revision() const;
+
+	bool takeImage(QImage &image);
+	void setImage(const QImage &image);
+
+	bool bind(uint unit = 0);
+	void release();
+
+private:
+	bool place(const QSize &size, QPoint &position);
+	void repack();
+
+	QHash<int, int> m_iconIndices;		///< Atlas index of every icon id loaded so far, -1 if loading failed.
+	std::vector<QImage> m_icons;		///< Icon images in atlas index order.
+	std::vector<QRect> m_iconRects;		///< Icon rectangles in the atlas image (texels).
+	QImage m_atlas;						///< Atlas image.
+	QScopedPointer<QOpenGLTexture> m_pTexture;	///< Atlas texture.
+	int m_shelfX;			///< Next free column on the current shelf.
+	int m_shelfY;			///< Top of the current shelf.
+	int m_shelfHeight;		///< Height of the current shelf.
+	bool m_isDirty;			///< True if the texture has to be uploaded again.
+	uint m_revision;		///< Incremented whenever icons are added or moved.
+};
+
+#endif // USERMAPSICONATLAS_H
@@ -0,0 +1,207 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsindexbuffer.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsIndexBuffer class which batches the
+///			strips of many user map objects into one indexed draw call.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsindexbuffer.h"
+#include <QDebug>
+
+const GLuint CUserMapsIndexBuffer::RESTART_INDEX;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsIndexBuffer::CUserMapsIndexBuffer()
+///
+/// \brief  Constructor. The OpenGL buffer is created on first bind.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsIndexBuffer::CUserMapsIndexBuffer()
+	: m_buffer(QOpenGLBuffer::IndexBuffer),
+	  m_isDirty(true)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsIndexBuffer::~CUserMapsIndexBuffer()
+///
+/// \brief  Destructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsIndexBuffer::~CUserMapsIndexBuffer()
+{
+	if ( m_buffer.isCreated() )
+		m_buffer.destroy();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIndexBuffer::clear()
+///
+/// \brief  Removes all strips.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIndexBuffer::clear()
+{
+	m_indices.clear();
+	m_isDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIndexBuffer::addStrip(const UserMapsVertexRange &range, bool isClosed)
+///
+/// \brief  Appends a strip.
+///
+/// \param  range - Vertices of the strip in the vertex pool.
+///         isClosed - True to close the strip by repeating its first vertex
+///                    (replaces GL_LINE_LOOP, which cannot be batched as strips).
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIndexBuffer::addStrip(const UserMapsVertexRange &range, bool isClosed)
+{
+	if ( range.isEmpty() )
+		return;
+
+	if ( !m_indices.empty() )
+		m_indices.push_back(RESTART_INDEX);
+
+	for (int i = 0; i < range.m_count; ++i)
+		m_indices.push_back(static_cast<GLuint>(range.m_first + i));
+	if ( isClosed )
+		m_indices.push_back(static_cast<GLuint>(range.m_first));
+
+	m_isDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIndexBuffer::addStrip(const UserMapsVertexRange &range,
+///                                            const std::vector<quint8> &vertexLevels,
+///                                            int level, bool isClosed)
+///
+/// \brief  Appends a strip simplified to a level of detail. Vertices dropped at
+///         the level are skipped; the vertices themselves stay in the pool.
+///
+/// \param  range - Vertices of the strip in the vertex pool.
+///         vertexLevels - Coarsest level keeping each vertex of the range.
+///         level - Level of detail to be drawn.
+///         isClosed - True to close the strip by repeating its first vertex.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIndexBuffer::addStrip(const UserMapsVertexRange &range, const std::vector<quint8> &vertexLevels,
+									int level, bool isClosed)
+{
+	if ( range.isEmpty() )
+		return;
+
+	if ( level <= 0 || vertexLevels.size() != static_cast<size_t>(range.m_count) )
+	{
+		addStrip(range, isClosed);
+		return;
+	}
+
+	if ( !m_indices.empty() )
+		m_indices.push_back(RESTART_INDEX);
+
+	GLuint first = RESTART_INDEX;
+	for (int i = 0; i < range.m_count; ++i)
+	{
+		if ( vertexLevels[static_cast<size_t>(i)] < level )
+			continue;
+
+		GLuint index = static_cast<GLuint>(range.m_first + i);
+		if ( first == RESTART_INDEX )
+			first = index;
+		m_indices.push_back(index);
+	}
+	if ( isClosed && first != RESTART_INDEX )
+		m_indices.push_back(first);
+
+	m_isDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIndexBuffer::addTriangles(const UserMapsVertexRange &range,
+///                                                const uint *pIndices, int count)
+///
+/// \brief  Appends triangles. Triangle lists need no restart index.
+///
+/// \param  range - Vertices the triangles refer to in the vertex pool.
+///         pIndices - Three indices per triangle, relative to the range.
+///         count - Number of indices.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIndexBuffer::addTriangles(const UserMapsVertexRange &range, const uint *pIndices, int count)
+{
+	if ( range.isEmpty() || count <= 0 )
+		return;
+
+	GLuint first = static_cast<GLuint>(range.m_first);
+	size_t end = m_indices.size();
+	m_indices.resize(end + static_cast<size_t>(count));
+	for (int i = 0; i < count; ++i)
+		m_indices[end + static_cast<size_t>(i)] = first + pIndices[i];
+
+	m_isDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIndexBuffer::swapIndices(std::vector<GLuint> &indices)
+///
+/// \brief  Exchanges the indices with a list, e.g. to hand draw lists built on
+///         another thread to the renderer without copying them.
+///
+/// \param  indices - New indices, receives the previous ones.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIndexBuffer::swapIndices(std::vector<GLuint> &indices)
+{
+	m_indices.swap(indices);
+	m_isDirty = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsIndexBuffer::bind()
+///
+/// \brief  Uploads changed indices and binds the index buffer. Requires current
+///         OpenGL context.
+///
+/// \return True if the buffer is bound.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsIndexBuffer::bind()
+{
+	if ( !m_buffer.isCreated() )
+	{
+		if ( !m_buffer.create() )
+		{
+			qDebug() << "CUserMapsIndexBuffer::bind() failed! Buffer could not be created";
+			return false;
+		}
+		m_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	}
+
+	if ( !m_buffer.bind() )
+		return false;
+
+	if ( m_isDirty )
+	{
+		m_buffer.allocate(m_indices.data(), static_cast<int>(m_indices.size() * sizeof(GLuint)));
+		m_isDirty = false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsIndexBuffer::release()
+///
+/// \brief  Releases the index buffer.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsIndexBuffer::release()
+{
+	m_buffer.release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsIndexBuffer::indexCount() const
+///
+/// \brief  Returns number of indices, including restart indices.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsIndexBuffer::indexCount() const
+{
+	return static_cast<int>(m_indices.size());
+}
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsindexbuffer.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsIndexBuffer class which batches the
+///			strips of many user map objects into one indexed draw call.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSINDEXBUFFER_H
+#define USERMAPSINDEXBUFFER_H
+
+#include <QOpenGLBuffer>
+#include <vector>
+#include "usermapsvertexpool.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsIndexBuffer - index buffer over a vertex pool.
+///
+/// Strips (line strips, closed outlines or triangle fans) are separated by
+/// the fixed primitive restart index, so all strips are drawn with a single
+/// glDrawElements call. Line styles come from the style table, not from
+/// uniforms, so strips of any style share the call.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsIndexBuffer
+{
+public:
+	static const GLuint RESTART_INDEX = 0xFFFFFFFFu;	///< Fixed restart index for GL_UNSIGNED_INT.
+
+	CUserMapsIndexBuffer();
+	~CUserMapsIndexBuffer();
+
+	void clear();
+	void addStrip(const UserMapsVertexRange &range, bool isClosed);
+	void addStrip(const UserMapsVertexRange &range, const std::vector<quint8> &vertexLevels, int level, bool isClosed);
+	void addTriangles(const UserMapsVertexRange &range, const uint *pIndices, int count);
+	void swapIndices(std::vector<GLuint> &indices);
+
+	bool bind();
+	void release();
+
+	int indexCount() const;
+
+private:
+	QOpenGLBuffer m_buffer;				///< OpenGL index buffer.
+	std::vector<GLuint> m_indices;		///< Indices of all strips.
+	bool m_isDirty;						///< True if the indices have to be uploaded.
+};
+
+#endif // USERMAPSINDEXBUFFER_H
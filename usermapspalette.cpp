@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapspalette.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsPalette class, a small texture
+///			resolving the colour keys of user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapspalette.h"
+#include <QColor>
+#include <QOpenGLContext>
+#include "../UserMapsDataLib/usermapcolourmanager.h"
+
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814 ///<taken from opengl specifications
+#endif
+
+const int CUserMapsPalette::TABLE_WIDTH;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsColour::UserMapsColour(int key, float opacity)
+///
+/// \brief  Constructor.
+///
+/// \param  key - Colour key of CUserMapColourManager.
+///         opacity - Opacity, 0 .. 1.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsColour::UserMapsColour(int key, float opacity)
+	: m_key(key),
+	  m_opacity(opacity)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsPalette::CUserMapsPalette()
+///
+/// \brief  Constructor. The texture is created on first bind.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsPalette::CUserMapsPalette()
+	: m_texture(0),
+	  m_takenKeys(0),
+	  m_isDirty(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsPalette::~CUserMapsPalette()
+///
+/// \brief  Destructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsPalette::~CUserMapsPalette()
+{
+	QOpenGLContext *pContext = QOpenGLContext::currentContext();
+	if ( m_texture != 0 && pContext != nullptr )
+		pContext->functions()->glDeleteTextures(1, &m_texture);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     float CUserMapsPalette::index(int colourKey)
+///
+/// \brief  Returns the palette index of a colour key, registering the key the
+///         first time it is used. Keys are never removed, so indices stay valid.
+///
+/// \param  colourKey - Colour key of CUserMapColourManager.
+///
+/// \return Palette index, as passed to the shaders.
+////////////////////////////////////////////////////////////////////////////////
+float CUserMapsPalette::index(int colourKey)
+{
+	QHash<int, int>::const_iterator it = m_indices.constFind(colourKey);
+	if ( it != m_indices.constEnd() )
+		return static_cast<float>(it.value());
+
+	int index = static_cast<int>(m_keys.size());
+	m_indices.insert(colourKey, index);
+	m_keys.push_back(colourKey);
+	return static_cast<float>(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPalette::takeChanges(UserMapsPaletteChanges &changes)
+///
+/// \brief  Copies the keys registered since the last call.
+///
+/// \param  changes - Receives the new keys.
+///
+/// \return True if keys have been registered.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPalette::takeChanges(UserMapsPaletteChanges &changes)
+{
+	changes.m_keys.assign(m_keys.begin() + static_cast<long>(m_takenKeys), m_keys.end());
+	m_takenKeys = m_keys.size();
+	return !changes.m_keys.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPalette::applyChanges(const UserMapsPaletteChanges &changes)
+///
+/// \brief  Registers the keys taken from another palette, in the same order so
+///         they get the same indices. Their colours are set by refresh().
+///
+/// \param  changes - Keys taken with takeChanges().
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPalette::applyChanges(const UserMapsPaletteChanges &changes)
+{
+	for (int key : changes.m_keys)
+		index(key);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPalette::refresh()
+///
+/// \brief  Resolves the colour of every registered key. Costs one lookup per
+///         key in use, whatever the number of objects.
+///
+/// \return True if a colour has changed, e.g. after a palette switch.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPalette::refresh()
+{
+	size_t texelCount = ( m_keys.size() + TABLE_WIDTH - 1 ) / TABLE_WIDTH * TABLE_WIDTH;
+	if ( texelCount > m_texels.size() )
+	{
+		m_texels.resize(texelCount, QVector4D());
+		m_isDirty = true;
+	}
+
+	bool isChanged = false;
+	for (size_t i = 0; i < m_keys.size(); ++i)
+	{
+		QColor colour = CUserMapColourManager::instance()->getColourByKey(m_keys[i]);
+		QVector4D texel(colour.red() / 255.0f, colour.green() / 255.0f, colour.blue() / 255.0f, 1.0f);
+		if ( texel != m_texels[i] )
+		{
+			m_texels[i] = texel;
+			isChanged = true;
+		}
+	}
+
+	m_isDirty = m_isDirty || isChanged;
+	return isChanged;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPalette::bind(uint unit)
+///
+/// \brief  Uploads the palette if it has changed and binds it. Requires
+///         current OpenGL context.
+///
+/// \param  unit - Texture unit.
+///
+/// \return True if the palette is bound.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPalette::bind(uint unit)
+{
+	if ( m_texels.empty() )
+		return false;
+
+	QOpenGLFunctions *func = QOpenGLContext::currentContext()->functions();
+	func->glActiveTexture(GL_TEXTURE0 + unit);
+
+	if ( m_texture == 0 )
+	{
+		func->glGenTextures(1, &m_texture);
+		func->glBindTexture(GL_TEXTURE_2D, m_texture);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	else
+	{
+		func->glBindTexture(GL_TEXTURE_2D, m_texture);
+	}
+
+	// The whole palette is a few rows at most
+	if ( m_isDirty )
+	{
+		int rows = static_cast<int>(m_texels.size() / TABLE_WIDTH);
+		func->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, TABLE_WIDTH, rows, 0, GL_RGBA, GL_FLOAT, m_texels.data());
+		m_isDirty = false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPalette::release(uint unit)
+///
+/// \brief  Unbinds the palette.
+///
+/// \param  unit - Texture unit the palette was bound to.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPalette::release(uint unit)
+{
+	QOpenGLFunctions *func = QOpenGLContext::currentContext()->functions();
+	func->glActiveTexture(GL_TEXTURE0 + unit);
+	func->glBindTexture(GL_TEXTURE_2D, 0);
+	func->glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapspalette.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsPalette class, a small texture
+///			resolving the colour keys of user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSPALETTE_H
+#define USERMAPSPALETTE_H
+
+#include <QHash>
+#include <QOpenGLFunctions>
+#include <QVector4D>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsColour - colour of an object as set by the user: a key of
+///        the colour manager and an opacity, resolved when drawn.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsColour
+{
+	UserMapsColour(int key = 0, float opacity = 1.0f);
+
+	int m_key;			///< Colour key of CUserMapColourManager.
+	float m_opacity;	///< Opacity, 0 .. 1.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsPaletteChanges - colour keys registered in a palette, passed
+///        from the palette of the geometry worker to the palette of the renderer.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsPaletteChanges
+{
+	std::vector<int> m_keys;	///< Keys registered since the last call, in index order.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsPalette - colour of every colour key in use, one RGBA32F
+///        texel per key.
+///
+/// Objects (their style table slot or instance record) carry palette indices
+/// instead of colours, so the shaders look the colour up and a palette switch
+/// (day, dusk, night) changes only this texture. The geometry worker hands out
+/// the indices and passes new keys on with takeChanges(); the renderer
+/// resolves all keys again with refresh() every synchronisation and uploads
+/// the texture only if a colour has changed.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsPalette
+{
+public:
+	static const int TABLE_WIDTH = 256;		///< Width of the texture in texels.
+
+	CUserMapsPalette();
+	~CUserMapsPalette();
+
+	float index(int colourKey);
+
+	bool takeChanges(UserMapsPaletteChanges &changes);
+	void applyChanges(const UserMapsPaletteChanges &changes);
+	bool refresh();
+
+	bool bind(uint unit);
+	void release(uint unit);
+
+private:
+	GLuint m_texture;					///< OpenGL texture, 0 until first bind.
+	QHash<int, int> m_indices;			///< Palette index of every registered key.
+	std::vector<int> m_keys;			///< Key of every palette index.
+	std::vector<QVector4D> m_texels;	///< CPU copy of the texture, whole rows.
+	size_t m_takenKeys;					///< Keys already passed on by takeChanges().
+	bool m_isDirty;						///< True if the texture has to be uploaded.
+};
+
+#endif // USERMAPSPALETTE_H
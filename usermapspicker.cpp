@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapspicker.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsPicker class, an off-screen id
+///			buffer finding the user map object under a clicked position.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapspicker.h"
+#include <QDebug>
+#include <QOpenGLContext>
+
+const int CUserMapsPicker::WINDOW_RADIUS;
+const int CUserMapsPicker::WINDOW_SIZE;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsPicker::CUserMapsPicker()
+///
+/// \brief  Constructor. OpenGL objects are created on first use.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsPicker::CUserMapsPicker()
+	: m_framebuffer(0),
+	  m_idBuffer(0),
+	  m_callerFramebuffer(0),
+	  m_isRequested(false),
+	  m_isReading(false),
+	  m_isResultReady(false),
+	  m_pickId(0),
+	  m_isComplete(false)
+{
+	m_viewport[0] = m_viewport[1] = m_viewport[2] = m_viewport[3] = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsPicker::~CUserMapsPicker()
+///
+/// \brief  Destructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsPicker::~CUserMapsPicker()
+{
+	QOpenGLContext *pContext = QOpenGLContext::currentContext();
+	if ( pContext == nullptr )
+		return;
+
+	QOpenGLExtraFunctions *func = pContext->extraFunctions();
+	if ( m_idBuffer != 0 )
+		func->glDeleteRenderbuffers(1, &m_idBuffer);
+	if ( m_framebuffer != 0 )
+		func->glDeleteFramebuffers(1, &m_framebuffer);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPicker::request(const QPointF &position)
+///
+/// \brief  Asks for the object at a position, drawn by the next pick pass.
+///         A request not drawn yet is replaced.
+///
+/// \param  position - Position in view pixels.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPicker::request(const QPointF &position)
+{
+	m_position = position;
+	m_isRequested = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPicker::isBusy() const
+///
+/// \brief  Returns true if a pick pass is still to be drawn or its result is
+///         still to be taken, so another frame is needed.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPicker::isBusy() const
+{
+	return m_isRequested || m_isReading;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPicker::beginPass(QRectF &window)
+///
+/// \brief  Binds and clears the id buffer if a pick pass is requested. The
+///         caller draws the pick ids of the objects, projected so that the
+///         window fills the buffer, and calls endPass().
+///
+/// \param  window - Receives the part of the view covered, in view pixels.
+///
+/// \return True if the pass has to be drawn.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPicker::beginPass(QRectF &window)
+{
+	// One read at a time, a newer request waits for the pending one
+	if ( !m_isRequested || m_isReading )
+		return false;
+
+	QOpenGLExtraFunctions *func = QOpenGLContext::currentContext()->extraFunctions();
+	if ( !create(func) )
+	{
+		m_isRequested = false;
+		return false;
+	}
+
+	func->glGetIntegerv(GL_VIEWPORT, m_viewport);
+	func->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_callerFramebuffer);
+	func->glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	func->glViewport(0, 0, WINDOW_SIZE, WINDOW_SIZE);
+
+	const GLuint background[4] = { 0, 0, 0, 0 };
+	func->glClearBufferuiv(GL_COLOR, 0, background);
+
+	window = QRectF(m_position.x() - WINDOW_RADIUS - 0.5, m_position.y() - WINDOW_RADIUS - 0.5, WINDOW_SIZE, WINDOW_SIZE);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPicker::endPass()
+///
+/// \brief  Starts reading the ids and restores the framebuffer and viewport
+///         of the caller.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPicker::endPass()
+{
+	QOpenGLExtraFunctions *func = QOpenGLContext::currentContext()->extraFunctions();
+
+	// RGBA_INTEGER, the read format every R32UI buffer supports
+	m_readback.request(QRect(0, 0, WINDOW_SIZE, WINDOW_SIZE), GL_RGBA_INTEGER, GL_UNSIGNED_INT,
+					   [this](const UserMapsReadbackResult &result) { takeNearest(result); });
+	m_readback.capture();
+	m_isReading = true;
+
+	func->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(m_callerFramebuffer));
+	func->glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+	m_isRequested = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPicker::takeResult(quint32 &pickId)
+///
+/// \brief  Takes the result of the last pick pass if the GPU has finished
+///         it. Does not wait.
+///
+/// \param  pickId - Receives the id nearest to the position, 0 if there is
+///                  no object around it.
+///
+/// \return True if a result was taken.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPicker::takeResult(quint32 &pickId)
+{
+	if ( !m_isReading )
+		return false;
+
+	m_readback.deliver();
+	if ( !m_isResultReady )
+		return false;
+
+	pickId = m_pickId;
+	m_isReading = false;
+	m_isResultReady = false;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPicker::takeNearest(const UserMapsReadbackResult &result)
+///
+/// \brief  Finds the id nearest to the position in a finished read.
+///
+/// \param  result - Ids read, RGBA_INTEGER; no pixels if the read failed.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPicker::takeNearest(const UserMapsReadbackResult &result)
+{
+	m_pickId = 0;
+	m_isResultReady = true;
+	if ( result.m_pPixels == nullptr )
+		return;
+
+	const GLuint *pPixels = reinterpret_cast<const GLuint *>(result.m_pPixels);
+	int nearest = WINDOW_SIZE * WINDOW_SIZE;
+	for (int y = 0; y < WINDOW_SIZE; ++y)
+	{
+		for (int x = 0; x < WINDOW_SIZE; ++x)
+		{
+			GLuint id = pPixels[( y * WINDOW_SIZE + x ) * 4];
+			int distance = ( x - WINDOW_RADIUS ) * ( x - WINDOW_RADIUS ) + ( y - WINDOW_RADIUS ) * ( y - WINDOW_RADIUS );
+			if ( id != 0 && distance < nearest )
+			{
+				m_pickId = id;
+				nearest = distance;
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPicker::create(QOpenGLExtraFunctions *func)
+///
+/// \brief  Creates the framebuffer and id buffer the first time.
+///
+/// \param  func - OpenGL ES 3.0 functions.
+///
+/// \return True if the framebuffer is complete.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPicker::create(QOpenGLExtraFunctions *func)
+{
+	if ( m_framebuffer != 0 )
+		return m_isComplete;
+
+	GLint previous = 0;
+	func->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+
+	func->glGenRenderbuffers(1, &m_idBuffer);
+	func->glBindRenderbuffer(GL_RENDERBUFFER, m_idBuffer);
+	func->glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, WINDOW_SIZE, WINDOW_SIZE);
+	func->glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	func->glGenFramebuffers(1, &m_framebuffer);
+	func->glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	func->glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_idBuffer);
+	m_isComplete = ( func->glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE );
+	func->glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+
+	if ( !m_isComplete )
+		qDebug() << "CUserMapsPicker::create() failed! Id buffer not GL_FRAMEBUFFER_COMPLETE";
+	return m_isComplete;
+}
@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapspicker.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsPicker class, an off-screen id buffer
+///			finding the user map object under a clicked position.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSPICKER_H
+#define USERMAPSPICKER_H
+
+#include <QOpenGLExtraFunctions>
+#include <QPointF>
+#include <QRectF>
+#include "usermapsreadback.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsPicker - finds the object drawn at a position of the view.
+///
+/// A pick pass draws the pick id of every object instead of its colour into
+/// a small R32UI framebuffer covering only WINDOW_SIZE pixels around the
+/// position, so its fill cost does not depend on the number of objects. The
+/// ids are read by a CUserMapsReadback and taken a frame or more later, when
+/// the read has finished, so the pipeline is never stalled.
+/// The id nearest to the position wins, which lets thin lines be hit without
+/// pixel accuracy. All functions require the current OpenGL context.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsPicker
+{
+public:
+	static const int WINDOW_RADIUS = 10;					///< Pixels searched on each side of the position, the click tolerance of the layer.
+	static const int WINDOW_SIZE = 2 * WINDOW_RADIUS + 1;	///< Width and height of the id buffer in pixels.
+
+	CUserMapsPicker();
+	~CUserMapsPicker();
+
+	void request(const QPointF &position);
+	bool isBusy() const;
+
+	bool beginPass(QRectF &window);
+	void endPass();
+	bool takeResult(quint32 &pickId);
+
+private:
+	CUserMapsPicker(const CUserMapsPicker &) = delete;
+	CUserMapsPicker &operator=(const CUserMapsPicker &) = delete;
+
+	bool create(QOpenGLExtraFunctions *func);
+	void takeNearest(const UserMapsReadbackResult &result);
+
+	GLuint m_framebuffer;		///< Framebuffer of the pick pass, 0 until first used.
+	GLuint m_idBuffer;			///< R32UI colour attachment receiving the ids.
+	CUserMapsReadback m_readback;	///< Reads the ids without waiting.
+	GLint m_viewport[4];		///< Viewport of the caller, restored by endPass().
+	GLint m_callerFramebuffer;	///< Framebuffer of the caller, bound again by endPass().
+	QPointF m_position;			///< Requested position in view pixels.
+	bool m_isRequested;			///< True if a pick pass has to be drawn.
+	bool m_isReading;			///< True from endPass() until the result is taken.
+	bool m_isResultReady;		///< True if the read has been delivered into m_pickId.
+	quint32 m_pickId;			///< Id nearest to the position in the last read.
+	bool m_isComplete;			///< True if the framebuffer can be drawn to.
+};
+
+#endif // USERMAPSPICKER_H
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapspicktable.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsPickTable class, mapping the ids
+///			drawn into the picking buffer back to user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapspicktable.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsPickTarget::UserMapsPickTarget()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsPickTarget::UserMapsPickTarget()
+	: m_type(EUserMapObjectType::Unkown_Object),
+	  m_objectId(-1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsPickTable::CUserMapsPickTable()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsPickTable::CUserMapsPickTable()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     quint32 CUserMapsPickTable::allocate(const UserMapsPickTarget &target)
+///
+/// \brief  Hands out an id for an object, reusing released ids first.
+///
+/// \param  target - Object the id stands for.
+///
+/// \return Pick id, never 0.
+////////////////////////////////////////////////////////////////////////////////
+quint32 CUserMapsPickTable::allocate(const UserMapsPickTarget &target)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if ( !m_freeIds.empty() )
+	{
+		quint32 pickId = m_freeIds.back();
+		m_freeIds.pop_back();
+		m_targets[pickId - 1] = target;
+		return pickId;
+	}
+
+	m_targets.push_back(target);
+	return static_cast<quint32>(m_targets.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPickTable::deallocate(quint32 &pickId)
+///
+/// \brief  Gives an id back. It resolves to nothing from now on, and is handed
+///         out again only after it has been through takeReleasedIds() and
+///         recycle().
+///
+/// \param  pickId - Id to release, set to 0. Nothing happens if it is 0.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPickTable::deallocate(quint32 &pickId)
+{
+	if ( pickId == 0 )
+		return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_targets[pickId - 1] = UserMapsPickTarget();
+	m_releasedIds.push_back(pickId);
+	pickId = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsPickTable::resolve(quint32 pickId, UserMapsPickTarget &target) const
+///
+/// \brief  Looks up the object of an id read from the picking buffer.
+///
+/// \param  pickId - Id read back, 0 for the background.
+///         target - Receives the object.
+///
+/// \return True if the id stands for an object that can be selected.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsPickTable::resolve(quint32 pickId, UserMapsPickTarget &target) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if ( pickId == 0 || pickId > m_targets.size() || m_targets[pickId - 1].m_objectId < 0 )
+		return false;
+
+	target = m_targets[pickId - 1];
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPickTable::takeReleasedIds(std::vector<quint32> &pickIds)
+///
+/// \brief  Takes the ids released since the last call, to be passed to the
+///         renderer with the update which no longer draws them.
+///
+/// \param  pickIds - Receives the ids, appended.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPickTable::takeReleasedIds(std::vector<quint32> &pickIds)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	pickIds.insert(pickIds.end(), m_releasedIds.begin(), m_releasedIds.end());
+	m_releasedIds.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsPickTable::recycle(std::vector<quint32> &pickIds)
+///
+/// \brief  Lets released ids be handed out again. Called by the renderer once
+///         no pick pass drawn with them is waiting for its result.
+///
+/// \param  pickIds - Ids from takeReleasedIds(), cleared.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsPickTable::recycle(std::vector<quint32> &pickIds)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_freeIds.insert(m_freeIds.end(), pickIds.begin(), pickIds.end());
+	}
+	pickIds.clear();
+}
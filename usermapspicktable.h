@@ -0,0 +1,66 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapspicktable.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsPickTable class, mapping the ids drawn
+///			into the picking buffer back to user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSPICKTABLE_H
+#define USERMAPSPICKTABLE_H
+
+#include <QString>
+#include <mutex>
+#include <vector>
+#include "../UserMapsDataLib/UserMapObjects/usermapobject.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsPickTarget - object a pick id stands for.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsPickTarget
+{
+	UserMapsPickTarget();
+
+	QString m_mapName;			///< Name of the map holding the object.
+	EUserMapObjectType m_type;	///< Type of the object.
+	int m_objectId;				///< Id of the object inside its map, -1 if it cannot be selected.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsPickTable - pick id of every drawn object.
+///
+/// Every cache entry gets a non-zero id, drawn by the picking pass of the
+/// renderer instead of a colour; 0 is left for the background. Ids are
+/// handed out and given back by the geometry worker and resolved by the
+/// renderer, so the table is guarded by a mutex. A released id resolves to
+/// nothing until it is handed out again.
+///
+/// The pick buffer is read back frames after it is drawn, so a released id
+/// is not handed out again straight away: the worker passes it to the
+/// renderer with the update removing its object (takeReleasedIds()), and
+/// the renderer gives it back with recycle() once no pick pass drawn before
+/// that update is waiting for its result. A late result can then not
+/// resolve to another object.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsPickTable
+{
+public:
+	CUserMapsPickTable();
+
+	quint32 allocate(const UserMapsPickTarget &target);
+	void deallocate(quint32 &pickId);
+	bool resolve(quint32 pickId, UserMapsPickTarget &target) const;
+
+	void takeReleasedIds(std::vector<quint32> &pickIds);
+	void recycle(std::vector<quint32> &pickIds);
+
+private:
+	mutable std::mutex m_mutex;					///< Guards the tables below.
+	std::vector<UserMapsPickTarget> m_targets;	///< Object of every id, id 1 first.
+	std::vector<quint32> m_freeIds;				///< Released ids which can be handed out again.
+	std::vector<quint32> m_releasedIds;			///< Released ids not yet passed to the renderer.
+};
+
+#endif // USERMAPSPICKTABLE_H
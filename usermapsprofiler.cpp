@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsprofiler.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsProfiler class, collecting the CPU
+///			time of the phases of building and drawing the user maps.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsprofiler.h"
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+const int CUserMapsProfiler::SAMPLE_COUNT;
+
+static const double NSECS_PER_MS = 1000000.0;	///< Nanoseconds per millisecond.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsPhaseStats::UserMapsPhaseStats()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsPhaseStats::UserMapsPhaseStats()
+	: m_samples(0),
+	  m_minMs(0.0),
+	  m_meanMs(0.0),
+	  m_p99Ms(0.0),
+	  m_maxMs(0.0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsProfiler::CUserMapsProfiler()
+///
+/// \brief  Constructor. Enabled if USERMAPS_PROFILE is set to a positive
+///         number of frames.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsProfiler::CUserMapsProfiler()
+	: m_isEnabled(false),
+	  m_logInterval(0)
+{
+	m_logInterval = std::max(0, qEnvironmentVariableIntValue("USERMAPS_PROFILE"));
+	m_isEnabled = ( m_logInterval > 0 );
+
+	for (PhaseSamples &phase : m_phases)
+	{
+		phase.m_count = 0;
+		phase.m_next = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsProfiler *CUserMapsProfiler::Instance()
+///
+/// \brief  Returns the profiler shared by all user maps layers.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsProfiler *CUserMapsProfiler::Instance()
+{
+	static CUserMapsProfiler profiler;
+	return &profiler;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsProfiler::isEnabled() const
+///
+/// \brief  Returns true if timers record.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsProfiler::isEnabled() const
+{
+	return m_isEnabled.load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProfiler::setEnabled(bool isEnabled)
+///
+/// \brief  Switches recording on or off. Samples already taken are kept.
+///
+/// \param  isEnabled - True to record.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProfiler::setEnabled(bool isEnabled)
+{
+	m_isEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsProfiler::logInterval() const
+///
+/// \brief  Returns number of frames between the reports the renderer logs,
+///         from USERMAPS_PROFILE; 0 if it does not log.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsProfiler::logInterval() const
+{
+	return m_logInterval;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProfiler::record(EUserMapsPhase phase, qint64 nsecs)
+///
+/// \brief  Adds a sample to a phase, replacing its oldest one if full.
+///
+/// \param  phase - Phase timed.
+///         nsecs - CPU time in nanoseconds.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProfiler::record(EUserMapsPhase phase, qint64 nsecs)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	PhaseSamples &samples = m_phases[static_cast<int>(phase)];
+	samples.m_nsecs[samples.m_next] = nsecs;
+	samples.m_next = ( samples.m_next + 1 ) % SAMPLE_COUNT;
+	samples.m_count = std::min(samples.m_count + 1, SAMPLE_COUNT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsPhaseStats CUserMapsProfiler::stats(EUserMapsPhase phase) const
+///
+/// \brief  Calculates statistics of the recent samples of a phase.
+///
+/// \param  phase - Phase.
+///
+/// \return Statistics, all zero if the phase has no samples.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsPhaseStats CUserMapsProfiler::stats(EUserMapsPhase phase) const
+{
+	std::vector<qint64> nsecs;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const PhaseSamples &samples = m_phases[static_cast<int>(phase)];
+		nsecs.assign(samples.m_nsecs, samples.m_nsecs + samples.m_count);
+	}
+
+	UserMapsPhaseStats stats;
+	if ( nsecs.empty() )
+		return stats;
+
+	std::sort(nsecs.begin(), nsecs.end());
+
+	qint64 sum = 0;
+	for (qint64 sample : nsecs)
+		sum += sample;
+
+	size_t p99 = std::min(nsecs.size() - 1, ( nsecs.size() * 99 ) / 100);
+
+	stats.m_samples = static_cast<int>(nsecs.size());
+	stats.m_minMs = nsecs.front() / NSECS_PER_MS;
+	stats.m_meanMs = sum / NSECS_PER_MS / nsecs.size();
+	stats.m_p99Ms = nsecs[p99] / NSECS_PER_MS;
+	stats.m_maxMs = nsecs.back() / NSECS_PER_MS;
+	return stats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProfiler::reset()
+///
+/// \brief  Drops the samples of all phases.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProfiler::reset()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (PhaseSamples &phase : m_phases)
+	{
+		phase.m_count = 0;
+		phase.m_next = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProfiler::log() const
+///
+/// \brief  Logs the statistics of every phase with samples, one line each.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProfiler::log() const
+{
+	for (int i = 0; i < static_cast<int>(EUserMapsPhase::Count); ++i)
+	{
+		EUserMapsPhase phase = static_cast<EUserMapsPhase>(i);
+		UserMapsPhaseStats phaseStats = stats(phase);
+		if ( phaseStats.m_samples == 0 )
+			continue;
+
+		qDebug().noquote() << QString("CUserMapsProfiler: %1 n=%2 min=%3 mean=%4 p99=%5 max=%6 ms")
+							  .arg(phaseName(phase), -15)
+							  .arg(phaseStats.m_samples)
+							  .arg(phaseStats.m_minMs, 0, 'f', 3)
+							  .arg(phaseStats.m_meanMs, 0, 'f', 3)
+							  .arg(phaseStats.m_p99Ms, 0, 'f', 3)
+							  .arg(phaseStats.m_maxMs, 0, 'f', 3);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     const char *CUserMapsProfiler::phaseName(EUserMapsPhase phase)
+///
+/// \brief  Returns name of a phase for reports.
+////////////////////////////////////////////////////////////////////////////////
+const char *CUserMapsProfiler::phaseName(EUserMapsPhase phase)
+{
+	switch ( phase )
+	{
+	case EUserMapsPhase::Synchronize:		return "Synchronize";
+	case EUserMapsPhase::Snapshot:			return "Snapshot";
+	case EUserMapsPhase::MapIteration:		return "MapIteration";
+	case EUserMapsPhase::GeometryBuild:		return "GeometryBuild";
+	case EUserMapsPhase::GeometryCommit:	return "GeometryCommit";
+	case EUserMapsPhase::SpatialIndex:		return "SpatialIndex";
+	case EUserMapsPhase::DrawLists:			return "DrawLists";
+	case EUserMapsPhase::Triangulation:		return "Triangulation";
+	case EUserMapsPhase::IconInstances:		return "IconInstances";
+	case EUserMapsPhase::Render:			return "Render";
+	case EUserMapsPhase::SceneUpload:		return "SceneUpload";
+	case EUserMapsPhase::FilledPolygons:	return "FilledPolygons";
+	case EUserMapsPhase::Circles:			return "Circles";
+	case EUserMapsPhase::Outlines:			return "Outlines";
+	case EUserMapsPhase::Textures:			return "Textures";
+	case EUserMapsPhase::PickPass:			return "PickPass";
+	default:								return "Unknown";
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsScopedTimer::CUserMapsScopedTimer(EUserMapsPhase phase)
+///
+/// \brief  Constructor. Starts timing if profiling is enabled.
+///
+/// \param  phase - Phase timed.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsScopedTimer::CUserMapsScopedTimer(EUserMapsPhase phase)
+	: m_phase(phase),
+	  m_isActive(CUserMapsProfiler::Instance()->isEnabled())
+{
+	if ( m_isActive )
+		m_timer.start();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsScopedTimer::~CUserMapsScopedTimer()
+///
+/// \brief  Destructor. Records the time since construction.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsScopedTimer::~CUserMapsScopedTimer()
+{
+	if ( m_isActive )
+		CUserMapsProfiler::Instance()->record(m_phase, m_timer.nsecsElapsed());
+}
@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsprofiler.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsProfiler class, collecting the CPU
+///			time of the phases of building and drawing the user maps.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSPROFILER_H
+#define USERMAPSPROFILER_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <atomic>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief EUserMapsPhase - timed phases. Phases may nest, each is timed
+///        inclusive of the phases it calls.
+////////////////////////////////////////////////////////////////////////////////
+enum class EUserMapsPhase
+{
+	Synchronize,		///< CUserMapsRenderer::synchronize(), GUI thread blocked.
+	Snapshot,			///< Taking the containers of the loaded maps.
+	MapIteration,		///< Worker visiting the loaded maps for changed objects.
+	GeometryBuild,		///< Projection and simplification of changed objects, in parallel.
+	GeometryCommit,		///< Storing built geometry into the vertex pools and style table.
+	SpatialIndex,		///< Packing the spatial index of the cache entries.
+	DrawLists,			///< Culling and flattening the index lists and circle instances.
+	Triangulation,		///< Triangulating areas, part of DrawLists.
+	IconInstances,		///< Flattening the icon instances.
+	Render,				///< CUserMapsRenderer::render().
+	SceneUpload,		///< Applying worker updates to the buffers and textures.
+	FilledPolygons,		///< drawfilledPolygons().
+	Circles,			///< drawCircles().
+	Outlines,			///< drawOutlines().
+	Textures,			///< renderTextures(), icons and text.
+	PickPass,			///< Pick ids around a click.
+	Count				///< Number of phases.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsPhaseStats - statistics of the recent samples of a phase.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsPhaseStats
+{
+	UserMapsPhaseStats();
+
+	int m_samples;		///< Number of samples, at most CUserMapsProfiler::SAMPLE_COUNT.
+	double m_minMs;		///< Shortest sample in milliseconds.
+	double m_meanMs;	///< Mean in milliseconds.
+	double m_p99Ms;		///< 99th percentile in milliseconds.
+	double m_maxMs;		///< Longest sample in milliseconds.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsProfiler - rolling CPU time statistics per phase.
+///
+/// Phases are timed by CUserMapsScopedTimer objects and keep their last
+/// SAMPLE_COUNT samples. Profiling is off by default and costs one atomic
+/// load per timer then; it is switched on by setEnabled() or by setting the
+/// environment variable USERMAPS_PROFILE to the number of frames between
+/// reports the renderer logs (e.g. USERMAPS_PROFILE=600), so a release build
+/// can be profiled as it is. Samples come from the render, GUI and worker
+/// threads, so they are guarded by a mutex.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsProfiler
+{
+public:
+	static const int SAMPLE_COUNT = 256;	///< Samples kept per phase.
+
+	static CUserMapsProfiler *Instance();
+
+	bool isEnabled() const;
+	void setEnabled(bool isEnabled);
+	int logInterval() const;
+
+	void record(EUserMapsPhase phase, qint64 nsecs);
+	UserMapsPhaseStats stats(EUserMapsPhase phase) const;
+	void reset();
+	void log() const;
+
+	static const char *phaseName(EUserMapsPhase phase);
+
+private:
+	CUserMapsProfiler();
+	CUserMapsProfiler(const CUserMapsProfiler &) = delete;
+	CUserMapsProfiler &operator=(const CUserMapsProfiler &) = delete;
+
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief PhaseSamples - ring of the recent samples of a phase.
+	////////////////////////////////////////////////////////////////////////////
+	struct PhaseSamples
+	{
+		qint64 m_nsecs[SAMPLE_COUNT];	///< Samples in nanoseconds.
+		int m_count;					///< Number of valid samples.
+		int m_next;						///< Slot the next sample is written to.
+	};
+
+	std::atomic<bool> m_isEnabled;									///< True if timers record.
+	int m_logInterval;												///< Frames between logged reports, 0 to not log.
+	mutable std::mutex m_mutex;										///< Guards the samples.
+	PhaseSamples m_phases[static_cast<int>(EUserMapsPhase::Count)];	///< Samples of every phase.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsScopedTimer - records the time from construction to
+///        destruction into a phase, if profiling is enabled.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsScopedTimer
+{
+public:
+	explicit CUserMapsScopedTimer(EUserMapsPhase phase);
+	~CUserMapsScopedTimer();
+
+private:
+	CUserMapsScopedTimer(const CUserMapsScopedTimer &) = delete;
+	CUserMapsScopedTimer &operator=(const CUserMapsScopedTimer &) = delete;
+
+	EUserMapsPhase m_phase;		///< Phase timed.
+	bool m_isActive;			///< True if profiling was enabled at construction.
+	QElapsedTimer m_timer;		///< Started at construction if active.
+};
+
+#endif // USERMAPSPROFILER_H
@@ -0,0 +1,697 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsprojection.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsProjection class which maps user map
+///			geometry into a view independent world space.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsprojection.h"
+#include <QDebug>
+#include <QtMath>
+#include <cmath>
+#include "../LayerLib/viewcoordinates.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define USERMAPS_SIMD_SSE2
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define USERMAPS_SIMD_NEON
+#endif
+
+static const double EARTH_RADIUS_NM = 10800.0 / M_PI;	///< Sphere radius giving one nautical mile per minute of arc.
+static const double MAX_LATITUDE = 85.0;				///< Mercator is clamped to this latitude (degrees).
+static const double REBASE_DISTANCE = 1000.0;			///< View can get this far (world units) from the anchor before it moves.
+static const double MIN_SAMPLE_DEGREES = 1.0e-4;		///< Smallest offset of the positions sampled to calibrate the view.
+static const double MAX_FIT_ERROR = 0.5;				///< Largest error in pixels of the calibrated view at the probe positions.
+static const double DEGREES_TO_RADIANS = M_PI / 180.0;	///< Degrees to radians factor.
+
+#if defined(USERMAPS_SIMD_SSE2) || defined(USERMAPS_SIMD_NEON)
+static const int SIMD_WIDTH = 2;	///< Doubles per SIMD register.
+
+static const int LOG_SERIES_LENGTH = 10;	///< Terms of the logarithm series.
+static const double LOG_SERIES[LOG_SERIES_LENGTH] =	///< 1 / (2k + 1), highest term first.
+{
+	1.0 / 19.0, 1.0 / 17.0, 1.0 / 15.0, 1.0 / 13.0, 1.0 / 11.0,
+	1.0 / 9.0, 1.0 / 7.0, 1.0 / 5.0, 1.0 / 3.0, 1.0
+};
+
+static const int SIN_SERIES_LENGTH = 11;	///< Terms of the sine series.
+static const double SIN_SERIES[SIN_SERIES_LENGTH] =	///< (-1)^k / (2k + 1)!, highest term first.
+{
+	 1.0 / 51090942171709440000.0,
+	-1.0 / 121645100408832000.0,
+	 1.0 / 355687428096000.0,
+	-1.0 / 1307674368000.0,
+	 1.0 / 6227020800.0,
+	-1.0 / 39916800.0,
+	 1.0 / 362880.0,
+	-1.0 / 5040.0,
+	 1.0 / 120.0,
+	-1.0 / 6.0,
+	 1.0
+};
+
+#if defined(USERMAPS_SIMD_SSE2)
+typedef __m128d SimdDouble;
+
+static inline SimdDouble simdSet(double value) { return _mm_set1_pd(value); }
+static inline SimdDouble simdLoad(const double *pValues) { return _mm_loadu_pd(pValues); }
+static inline void simdStore(double *pValues, SimdDouble value) { _mm_storeu_pd(pValues, value); }
+static inline SimdDouble simdAdd(SimdDouble a, SimdDouble b) { return _mm_add_pd(a, b); }
+static inline SimdDouble simdSub(SimdDouble a, SimdDouble b) { return _mm_sub_pd(a, b); }
+static inline SimdDouble simdMul(SimdDouble a, SimdDouble b) { return _mm_mul_pd(a, b); }
+static inline SimdDouble simdDiv(SimdDouble a, SimdDouble b) { return _mm_div_pd(a, b); }
+static inline SimdDouble simdMin(SimdDouble a, SimdDouble b) { return _mm_min_pd(a, b); }
+static inline SimdDouble simdMax(SimdDouble a, SimdDouble b) { return _mm_max_pd(a, b); }
+static inline SimdDouble simdGreater(SimdDouble a, SimdDouble b) { return _mm_cmpgt_pd(a, b); }
+static inline SimdDouble simdAnd(SimdDouble mask, SimdDouble value) { return _mm_and_pd(mask, value); }
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     static inline SimdDouble simdSplit(SimdDouble value, SimdDouble &exponent)
+///
+/// \brief  Splits positive, normal values into mantissa in [1, 2) and exponent.
+////////////////////////////////////////////////////////////////////////////////
+static inline SimdDouble simdSplit(SimdDouble value, SimdDouble &exponent)
+{
+	const __m128i bits = _mm_castpd_si128(value);
+	const __m128i biased = _mm_sub_epi64(_mm_srli_epi64(bits, 52), _mm_set1_epi64x(1023));
+	exponent = _mm_cvtepi32_pd(_mm_shuffle_epi32(biased, _MM_SHUFFLE(3, 1, 2, 0)));
+
+	const __m128i mantissa = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+										  _mm_set1_epi64x(0x3FF0000000000000LL));
+	return _mm_castsi128_pd(mantissa);
+}
+#else
+typedef float64x2_t SimdDouble;
+
+static inline SimdDouble simdSet(double value) { return vdupq_n_f64(value); }
+static inline SimdDouble simdLoad(const double *pValues) { return vld1q_f64(pValues); }
+static inline void simdStore(double *pValues, SimdDouble value) { vst1q_f64(pValues, value); }
+static inline SimdDouble simdAdd(SimdDouble a, SimdDouble b) { return vaddq_f64(a, b); }
+static inline SimdDouble simdSub(SimdDouble a, SimdDouble b) { return vsubq_f64(a, b); }
+static inline SimdDouble simdMul(SimdDouble a, SimdDouble b) { return vmulq_f64(a, b); }
+static inline SimdDouble simdDiv(SimdDouble a, SimdDouble b) { return vdivq_f64(a, b); }
+static inline SimdDouble simdMin(SimdDouble a, SimdDouble b) { return vminq_f64(a, b); }
+static inline SimdDouble simdMax(SimdDouble a, SimdDouble b) { return vmaxq_f64(a, b); }
+static inline SimdDouble simdGreater(SimdDouble a, SimdDouble b) { return vreinterpretq_f64_u64(vcgtq_f64(a, b)); }
+static inline SimdDouble simdAnd(SimdDouble mask, SimdDouble value)
+{
+	return vreinterpretq_f64_u64(vandq_u64(vreinterpretq_u64_f64(mask), vreinterpretq_u64_f64(value)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     static inline SimdDouble simdSplit(SimdDouble value, SimdDouble &exponent)
+///
+/// \brief  Splits positive, normal values into mantissa in [1, 2) and exponent.
+////////////////////////////////////////////////////////////////////////////////
+static inline SimdDouble simdSplit(SimdDouble value, SimdDouble &exponent)
+{
+	const uint64x2_t bits = vreinterpretq_u64_f64(value);
+	exponent = vcvtq_f64_s64(vsubq_s64(vreinterpretq_s64_u64(vshrq_n_u64(bits, 52)), vdupq_n_s64(1023)));
+
+	const uint64x2_t mantissa = vorrq_u64(vandq_u64(bits, vdupq_n_u64(0x000FFFFFFFFFFFFFULL)),
+										  vdupq_n_u64(0x3FF0000000000000ULL));
+	return vreinterpretq_f64_u64(mantissa);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     static inline SimdDouble simdLog(SimdDouble value)
+///
+/// \brief  Natural logarithm of positive, normal values, accurate to about 1 ulp.
+///         log(m * 2^e) = e * log(2) + 2 * atanh((m - 1) / (m + 1)), with the
+///         mantissa m moved into [sqrt(1/2), sqrt(2)) so the series converges fast.
+////////////////////////////////////////////////////////////////////////////////
+static inline SimdDouble simdLog(SimdDouble value)
+{
+	SimdDouble exponent;
+	SimdDouble mantissa = simdSplit(value, exponent);
+
+	const SimdDouble isLarge = simdGreater(mantissa, simdSet(M_SQRT2));
+	mantissa = simdSub(mantissa, simdAnd(isLarge, simdMul(mantissa, simdSet(0.5))));
+	exponent = simdAdd(exponent, simdAnd(isLarge, simdSet(1.0)));
+
+	const SimdDouble one = simdSet(1.0);
+	const SimdDouble t = simdDiv(simdSub(mantissa, one), simdAdd(mantissa, one));
+	const SimdDouble t2 = simdMul(t, t);
+
+	// 1 + t^2/3 + t^4/5 + ... + t^18/19, |t| < 0.172
+	SimdDouble series = simdSet(LOG_SERIES[0]);
+	for (int k = 1; k < LOG_SERIES_LENGTH; ++k)
+		series = simdAdd(simdMul(series, t2), simdSet(LOG_SERIES[k]));
+
+	return simdAdd(simdMul(exponent, simdSet(M_LN2)), simdMul(simdMul(simdSet(2.0), t), series));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     static inline SimdDouble simdSin(SimdDouble angle)
+///
+/// \brief  Sine of angles within +/-pi/2 (Taylor series up to x^21).
+////////////////////////////////////////////////////////////////////////////////
+static inline SimdDouble simdSin(SimdDouble angle)
+{
+	const SimdDouble a2 = simdMul(angle, angle);
+
+	SimdDouble series = simdSet(SIN_SERIES[0]);
+	for (int k = 1; k < SIN_SERIES_LENGTH; ++k)
+		series = simdAdd(simdMul(series, a2), simdSet(SIN_SERIES[k]));
+	return simdMul(angle, series);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     static inline void simdToWorld(SimdDouble latitude, SimdDouble longitude,
+///                                       double anchorX, double anchorY,
+///                                       SimdDouble &x, SimdDouble &y)
+///
+/// \brief  Mercator projection relative to the anchor, see toWorld().
+///         Northing is R * atanh(sin(latitude)).
+////////////////////////////////////////////////////////////////////////////////
+static inline void simdToWorld(SimdDouble latitude, SimdDouble longitude, double anchorX, double anchorY,
+							   SimdDouble &x, SimdDouble &y)
+{
+	const SimdDouble halfWorld = simdSet(EARTH_RADIUS_NM * M_PI);
+	const SimdDouble radiansToWorld = simdSet(EARTH_RADIUS_NM * DEGREES_TO_RADIANS);
+
+	latitude = simdMax(simdMin(latitude, simdSet(MAX_LATITUDE)), simdSet(-MAX_LATITUDE));
+	const SimdDouble sine = simdSin(simdMul(latitude, simdSet(DEGREES_TO_RADIANS)));
+	const SimdDouble one = simdSet(1.0);
+	y = simdMul(simdSet(0.5 * EARTH_RADIUS_NM), simdLog(simdDiv(simdAdd(one, sine), simdSub(one, sine))));
+	y = simdSub(y, simdSet(anchorY));
+
+	// Take the shorter way around the antimeridian
+	x = simdSub(simdMul(longitude, radiansToWorld), simdSet(anchorX));
+	const SimdDouble twoWorlds = simdAdd(halfWorld, halfWorld);
+	x = simdSub(x, simdAnd(simdGreater(x, halfWorld), twoWorlds));
+	x = simdAdd(x, simdAnd(simdGreater(simdSub(simdSet(0.0), halfWorld), x), twoWorlds));
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsProjection::CUserMapsProjection()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsProjection::CUserMapsProjection()
+	: m_anchorX(0.0),
+	  m_anchorY(0.0),
+	  m_isAnchored(false),
+	  m_anchorRevision(0),
+	  m_isAccurate(false)
+{
+	for (int i = 0; i < 6; ++i)
+		m_worldToView[i] = 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsProjection::update()
+///
+/// \brief  Calibrates the world to pixel transformation against the current view.
+///         CViewCoordinates is sampled at the geo origin and two nearby positions;
+///         the affine transformation through these samples includes scale, rotation
+///         and the view origin, so pan, offset and range changes need no geometry
+///         work. Must be called once per synchronisation. The fit is then checked
+///         at the corners and the centre of the view, see isAccurate().
+///
+/// \return True if the transformation is valid.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsProjection::update()
+{
+	qreal originX = 0.0;
+	qreal originY = 0.0;
+	CViewCoordinates::Instance()->getViewOriginPixel( originX, originY );
+
+	// Geo position at the view origin
+	GEOGRAPHICAL originLat;
+	GEOGRAPHICAL originLon;
+	CViewCoordinates::Instance()->Convert(PIXEL(0.0), PIXEL(0.0), originLat, originLon);
+	double lat0 = qBound(-MAX_LATITUDE, double(originLat), MAX_LATITUDE);
+	double lon0 = double(originLon);
+
+	// Move the anchor if the view got too far from it
+	double mercatorX = 0.0;
+	double mercatorY = 0.0;
+	toMercator(lat0, lon0, mercatorX, mercatorY);
+	if ( !m_isAnchored || qAbs(mercatorX - m_anchorX) > REBASE_DISTANCE || qAbs(mercatorY - m_anchorY) > REBASE_DISTANCE )
+	{
+		m_anchorX = mercatorX;
+		m_anchorY = mercatorY;
+		m_isAnchored = true;
+		++m_anchorRevision;
+	}
+
+	// Sample about a tenth of the visible range away from the origin
+	double sampleNm = 0.1 * qMax(originX, originY) * CViewCoordinates::getPixelsToNauticalMiles();
+	double sampleDegrees = qMax(sampleNm / 60.0, MIN_SAMPLE_DEGREES);
+	double lat1 = ( lat0 + sampleDegrees <= MAX_LATITUDE ) ? lat0 + sampleDegrees : lat0 - sampleDegrees;
+	double lon2 = lon0 + sampleDegrees;
+
+	const double sampleLat[3] = { lat0, lat1, lat0 };
+	const double sampleLon[3] = { lon0, lon0, lon2 };
+	double worldX[3];
+	double worldY[3];
+	double pixelX[3];
+	double pixelY[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		QPointF world = toWorld(sampleLat[i], sampleLon[i]);
+		worldX[i] = world.x();
+		worldY[i] = world.y();
+
+		PIXEL x;
+		PIXEL y;
+		CViewCoordinates::Instance()->Convert(GEOGRAPHICAL(sampleLat[i]), GEOGRAPHICAL(sampleLon[i]), x, y);
+		pixelX[i] = x + originX;
+		pixelY[i] = y + originY;
+	}
+
+	// Solve pixel = M * world + t from the three samples
+	double w11 = worldX[1] - worldX[0];
+	double w21 = worldY[1] - worldY[0];
+	double w12 = worldX[2] - worldX[0];
+	double w22 = worldY[2] - worldY[0];
+	double determinant = w11 * w22 - w12 * w21;
+	if ( qAbs(determinant) < 1.0e-12 )
+	{
+		qDebug() << "CUserMapsProjection::update() failed! View could not be calibrated";
+		return false;
+	}
+
+	double p11 = pixelX[1] - pixelX[0];
+	double p21 = pixelY[1] - pixelY[0];
+	double p12 = pixelX[2] - pixelX[0];
+	double p22 = pixelY[2] - pixelY[0];
+
+	double a = ( p11 * w22 - p12 * w21) / determinant;
+	double b = (-p11 * w12 + p12 * w11) / determinant;
+	double c = ( p21 * w22 - p22 * w21) / determinant;
+	double d = (-p21 * w12 + p22 * w11) / determinant;
+	double tx = pixelX[0] - (a * worldX[0] + b * worldY[0]);
+	double ty = pixelY[0] - (c * worldX[0] + d * worldY[0]);
+
+	m_worldToPixel = QMatrix4x4(float(a), float(b), 0.0f, float(tx),
+								float(c), float(d), 0.0f, float(ty),
+								0.0f,     0.0f,     1.0f, 0.0f,
+								0.0f,     0.0f,     0.0f, 1.0f);
+
+	// Batch conversions work in view pixels, relative to the view origin
+	m_worldToView[0] = a;
+	m_worldToView[1] = b;
+	m_worldToView[2] = tx - originX;
+	m_worldToView[3] = c;
+	m_worldToView[4] = d;
+	m_worldToView[5] = ty - originY;
+
+	// The fit is exact for a Mercator view only, check it away from the samples
+	bool wasAccurate = m_isAccurate;
+	double error = fitError(originX, originY);
+	m_isAccurate = ( error <= MAX_FIT_ERROR );
+	if ( wasAccurate && !m_isAccurate )
+		qDebug() << "CUserMapsProjection::update() View fit is off by" << error << "pixels";
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsProjection::isAccurate() const
+///
+/// \brief  Returns true if the calibrated view matched CViewCoordinates to
+///         within MAX_FIT_ERROR pixels across the view at the last update().
+///         Drawing may use an inaccurate view; conversions of positions the
+///         user edits should fall back to CViewCoordinates.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsProjection::isAccurate() const
+{
+	return m_isAccurate;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double CUserMapsProjection::fitError(double originX, double originY) const
+///
+/// \brief  Measures the calibrated view against CViewCoordinates at the corners
+///         and the centre of the view.
+///
+/// \param  originX - View origin pixel X.
+///         originY - View origin pixel Y.
+///
+/// \return Largest distance in pixels between the two at the probe positions.
+////////////////////////////////////////////////////////////////////////////////
+double CUserMapsProjection::fitError(double originX, double originY) const
+{
+	qreal left = 0.0;
+	qreal right = 0.0;
+	qreal top = 0.0;
+	qreal bottom = 0.0;
+	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
+
+	// View pixels relative to the view origin, as CViewCoordinates converts them
+	const int PROBE_COUNT = 5;
+	const double probeX[PROBE_COUNT] = { left, right, left, right, 0.5 * ( left + right ) };
+	const double probeY[PROBE_COUNT] = { top, top, bottom, bottom, 0.5 * ( top + bottom ) };
+	double latitudes[PROBE_COUNT];
+	double longitudes[PROBE_COUNT];
+	for (int i = 0; i < PROBE_COUNT; ++i)
+	{
+		GEOGRAPHICAL lat;
+		GEOGRAPHICAL lon;
+		CViewCoordinates::Instance()->Convert(PIXEL(probeX[i] - originX), PIXEL(probeY[i] - originY), lat, lon);
+		latitudes[i] = double(lat);
+		longitudes[i] = double(lon);
+	}
+
+	double x[PROBE_COUNT];
+	double y[PROBE_COUNT];
+	toPixel(latitudes, longitudes, PROBE_COUNT, x, y);
+
+	double error = 0.0;
+	for (int i = 0; i < PROBE_COUNT; ++i)
+		error = qMax(error, std::hypot(x[i] + originX - probeX[i], y[i] + originY - probeY[i]));
+	return error;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     QPointF CUserMapsProjection::toWorld(double latitude, double longitude) const
+///
+/// \brief  Projects a geo position into world space.
+///
+/// \param  latitude - Latitude in degrees.
+///         longitude - Longitude in degrees.
+///
+/// \return Position relative to the anchor.
+////////////////////////////////////////////////////////////////////////////////
+QPointF CUserMapsProjection::toWorld(double latitude, double longitude) const
+{
+	double x = 0.0;
+	double y = 0.0;
+	toMercator(latitude, longitude, x, y);
+
+	// Take the shorter way around the antimeridian
+	x -= m_anchorX;
+	const double halfWorld = EARTH_RADIUS_NM * M_PI;
+	if ( x > halfWorld )
+		x -= 2.0 * halfWorld;
+	else if ( x < -halfWorld )
+		x += 2.0 * halfWorld;
+
+	return QPointF(x, y - m_anchorY);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double CUserMapsProjection::toWorldDistance(double latitude, double distanceNm)
+///
+/// \brief  Converts a distance into world units. Mercator scale grows with latitude;
+///         the anchor and the view do not matter.
+///
+/// \param  latitude - Latitude (degrees) where the distance is measured.
+///         distanceNm - Distance in nautical miles.
+///
+/// \return Distance in world units.
+////////////////////////////////////////////////////////////////////////////////
+double CUserMapsProjection::toWorldDistance(double latitude, double distanceNm)
+{
+	double lat = qBound(-MAX_LATITUDE, latitude, MAX_LATITUDE);
+	return distanceNm / std::cos(qDegreesToRadians(lat));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProjection::toWorld(const double *latitudes, const double *longitudes,
+///                                         int count, double *x, double *y) const
+///
+/// \brief  Projects geo positions into world space, two at a time where SIMD is
+///         available. Results match toWorld() to within a few ulps.
+///
+/// \param  latitudes - Latitudes in degrees.
+///         longitudes - Longitudes in degrees.
+///         count - Number of positions.
+///         x - Positions relative to the anchor, X.
+///         y - Positions relative to the anchor, Y.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProjection::toWorld(const double *latitudes, const double *longitudes, int count, double *x, double *y) const
+{
+	int i = 0;
+#if defined(USERMAPS_SIMD_SSE2) || defined(USERMAPS_SIMD_NEON)
+	for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH)
+	{
+		SimdDouble worldX;
+		SimdDouble worldY;
+		simdToWorld(simdLoad(latitudes + i), simdLoad(longitudes + i), m_anchorX, m_anchorY, worldX, worldY);
+		simdStore(x + i, worldX);
+		simdStore(y + i, worldY);
+	}
+
+	// Odd position goes through the same kernel, so all positions are rounded alike
+	if ( i < count )
+	{
+		double latitude[SIMD_WIDTH] = { latitudes[i], latitudes[i] };
+		double longitude[SIMD_WIDTH] = { longitudes[i], longitudes[i] };
+		double worldX[SIMD_WIDTH];
+		double worldY[SIMD_WIDTH];
+		SimdDouble resultX;
+		SimdDouble resultY;
+		simdToWorld(simdLoad(latitude), simdLoad(longitude), m_anchorX, m_anchorY, resultX, resultY);
+		simdStore(worldX, resultX);
+		simdStore(worldY, resultY);
+		x[i] = worldX[0];
+		y[i] = worldY[0];
+		++i;
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		QPointF world = toWorld(latitudes[i], longitudes[i]);
+		x[i] = world.x();
+		y[i] = world.y();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProjection::toWorldPath(const double *latitudes, const double *longitudes,
+///                                             int count, double *x, double *y) const
+///
+/// \brief  Projects the positions of a line or an area into world space. The
+///         first position takes the shorter way around from the anchor, each
+///         next one the shorter way around from the one before, so a path
+///         crossing the antimeridian does not jump across the world.
+///
+/// \param  latitudes - Latitudes in degrees.
+///         longitudes - Longitudes in degrees.
+///         count - Number of positions.
+///         x - Positions relative to the anchor, X.
+///         y - Positions relative to the anchor, Y.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProjection::toWorldPath(const double *latitudes, const double *longitudes, int count,
+									  double *x, double *y) const
+{
+	toWorld(latitudes, longitudes, count, x, y);
+	unwrapPath(x, count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProjection::toPixel(const double *latitudes, const double *longitudes,
+///                                         int count, double *x, double *y) const
+///
+/// \brief  Projects geo positions into view pixels through world space. Pixels
+///         are relative to the view origin, as from CViewCoordinates::Convert().
+///         update() must have been called for the current view.
+///
+/// \param  latitudes - Latitudes in degrees.
+///         longitudes - Longitudes in degrees.
+///         count - Number of positions.
+///         x - Pixel X.
+///         y - Pixel Y.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProjection::toPixel(const double *latitudes, const double *longitudes, int count, double *x, double *y) const
+{
+	toWorld(latitudes, longitudes, count, x, y);
+
+	const double a = m_worldToView[0];
+	const double b = m_worldToView[1];
+	const double tx = m_worldToView[2];
+	const double c = m_worldToView[3];
+	const double d = m_worldToView[4];
+	const double ty = m_worldToView[5];
+
+	int i = 0;
+#if defined(USERMAPS_SIMD_SSE2) || defined(USERMAPS_SIMD_NEON)
+	for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH)
+	{
+		const SimdDouble worldX = simdLoad(x + i);
+		const SimdDouble worldY = simdLoad(y + i);
+		simdStore(x + i, simdAdd(simdAdd(simdMul(simdSet(a), worldX), simdMul(simdSet(b), worldY)), simdSet(tx)));
+		simdStore(y + i, simdAdd(simdAdd(simdMul(simdSet(c), worldX), simdMul(simdSet(d), worldY)), simdSet(ty)));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const double worldX = x[i];
+		const double worldY = y[i];
+		x[i] = a * worldX + b * worldY + tx;
+		y[i] = c * worldX + d * worldY + ty;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProjection::fromPixel(const double *x, const double *y, int count,
+///                                           double *latitudes, double *longitudes) const
+///
+/// \brief  Converts view pixels (relative to the view origin) into geo positions,
+///         the inverse of toPixel(). The inverse Mercator is evaluated per
+///         position; only the view constants are shared.
+///
+/// \param  x - Pixel X.
+///         y - Pixel Y.
+///         count - Number of positions.
+///         latitudes - Latitudes in degrees.
+///         longitudes - Longitudes in degrees, within +/-180.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProjection::fromPixel(const double *x, const double *y, int count, double *latitudes, double *longitudes) const
+{
+	const double determinant = m_worldToView[0] * m_worldToView[4] - m_worldToView[1] * m_worldToView[3];
+	if ( qAbs(determinant) < 1.0e-12 )
+	{
+		qDebug() << "CUserMapsProjection::fromPixel() failed! View is not calibrated";
+		return;
+	}
+
+	// Inverse of the view transformation
+	const double a = m_worldToView[4] / determinant;
+	const double b = -m_worldToView[1] / determinant;
+	const double c = -m_worldToView[3] / determinant;
+	const double d = m_worldToView[0] / determinant;
+	const double tx = m_worldToView[2];
+	const double ty = m_worldToView[5];
+	const double worldToDegrees = 1.0 / (EARTH_RADIUS_NM * DEGREES_TO_RADIANS);
+
+	for (int i = 0; i < count; ++i)
+	{
+		const double pixelX = x[i] - tx;
+		const double pixelY = y[i] - ty;
+		const double mercatorX = a * pixelX + b * pixelY + m_anchorX;
+		const double mercatorY = c * pixelX + d * pixelY + m_anchorY;
+
+		latitudes[i] = qRadiansToDegrees(std::atan(std::sinh(mercatorY / EARTH_RADIUS_NM)));
+		longitudes[i] = std::remainder(mercatorX * worldToDegrees, 360.0);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     const QMatrix4x4 &CUserMapsProjection::worldToPixel() const
+///
+/// \brief  Returns transformation from world space into view pixels.
+////////////////////////////////////////////////////////////////////////////////
+const QMatrix4x4 &CUserMapsProjection::worldToPixel() const
+{
+	return m_worldToPixel;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     QMatrix4x4 CUserMapsProjection::worldToPixel(const CUserMapsProjection &geometrySpace) const
+///
+/// \brief  Returns transformation into view pixels for geometry built in the
+///         world space of another projection, whose anchor may not have moved
+///         yet (geometry is rebuilt off the render thread).
+///
+/// \param  geometrySpace - Projection the geometry was built with.
+////////////////////////////////////////////////////////////////////////////////
+QMatrix4x4 CUserMapsProjection::worldToPixel(const CUserMapsProjection &geometrySpace) const
+{
+	if ( geometrySpace.m_anchorRevision == m_anchorRevision )
+		return m_worldToPixel;
+
+	// Shift from the other anchor to this one, the shorter way around
+	const double world = 2.0 * EARTH_RADIUS_NM * M_PI;
+	double dx = std::remainder(geometrySpace.m_anchorX - m_anchorX, world);
+	double dy = geometrySpace.m_anchorY - m_anchorY;
+
+	QMatrix4x4 shift;
+	shift.translate(static_cast<float>(dx), static_cast<float>(dy));
+	return m_worldToPixel * shift;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     QRectF CUserMapsProjection::pixelToWorld(const QRectF &pixels) const
+///
+/// \brief  Returns the world space box around a rectangle of view pixels, e.g.
+///         the visible area. The view may be rotated, so the box can be larger
+///         than the rectangle.
+///
+/// \param  pixels - Rectangle in view pixels.
+////////////////////////////////////////////////////////////////////////////////
+QRectF CUserMapsProjection::pixelToWorld(const QRectF &pixels) const
+{
+	bool isInvertible = false;
+	QMatrix4x4 pixelToWorld = m_worldToPixel.inverted(&isInvertible);
+	if ( !isInvertible )
+		return QRectF();
+
+	return pixelToWorld.mapRect(pixels);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double CUserMapsProjection::pixelsPerWorldUnit() const
+///
+/// \brief  Returns scale of the view, the length in pixels of one world unit.
+////////////////////////////////////////////////////////////////////////////////
+double CUserMapsProjection::pixelsPerWorldUnit() const
+{
+	return std::sqrt(qAbs(m_worldToView[0] * m_worldToView[4] - m_worldToView[1] * m_worldToView[3]));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     uint CUserMapsProjection::anchorRevision() const
+///
+/// \brief  Returns stamp of the anchor. World space geometry built with another
+///         stamp has to be rebuilt.
+////////////////////////////////////////////////////////////////////////////////
+uint CUserMapsProjection::anchorRevision() const
+{
+	return m_anchorRevision;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProjection::toMercator(double latitude, double longitude, double &x, double &y)
+///
+/// \brief  Spherical Mercator projection in nautical miles at the equator.
+///
+/// \param  latitude - Latitude in degrees, clamped to +/-85 degrees.
+///         longitude - Longitude in degrees.
+///         x - Projected easting.
+///         y - Projected northing.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProjection::toMercator(double latitude, double longitude, double &x, double &y)
+{
+	double lat = qDegreesToRadians(qBound(-MAX_LATITUDE, latitude, MAX_LATITUDE));
+	x = EARTH_RADIUS_NM * qDegreesToRadians(longitude);
+	y = EARTH_RADIUS_NM * std::log(std::tan(M_PI / 4.0 + lat / 2.0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsProjection::unwrapPath(double *x, int count)
+///
+/// \brief  Moves projected eastings of a path by whole worlds, so consecutive
+///         positions are at most half the world apart. The first one is kept.
+///
+/// \param  x - Eastings in world units, Mercator or world space.
+///         count - Number of positions.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsProjection::unwrapPath(double *x, int count)
+{
+	const double world = worldWidth();
+	for (int i = 1; i < count; ++i)
+		x[i] = x[i - 1] + std::remainder(x[i] - x[i - 1], world);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double CUserMapsProjection::worldWidth()
+///
+/// \brief  Returns width of the world in world units, the length of the equator.
+////////////////////////////////////////////////////////////////////////////////
+double CUserMapsProjection::worldWidth()
+{
+	return 2.0 * EARTH_RADIUS_NM * M_PI;
+}
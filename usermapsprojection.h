@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsprojection.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsProjection class which maps user map
+///			geometry into a view independent world space.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSPROJECTION_H
+#define USERMAPSPROJECTION_H
+
+#include <QMatrix4x4>
+#include <QPointF>
+#include <QRectF>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsProjection - projects positions into world space and keeps
+///        the transformation from world space into view pixels.
+///
+/// World space is Mercator, in nautical miles at the equator, relative to an
+/// anchor position. Geometry stored in world space stays valid when the view
+/// is panned, offset or zoomed; only the world to pixel matrix is updated.
+/// The anchor is moved (and all geometry has to be rebuilt) only if the view
+/// gets so far from it that float precision would suffer.
+///
+/// The batch functions take contiguous coordinate arrays and project two
+/// positions per SSE2 (x86) or NEON (AArch64) instruction, with the view
+/// constants taken once per call. Other targets use a scalar loop.
+///
+/// The view is an affine fit through three samples of CViewCoordinates.
+/// update() checks it against CViewCoordinates at the corners and the centre
+/// of the view; if it is off by more than half a pixel there (a view which
+/// is not Mercator, or a range spanning much of the globe), isAccurate()
+/// returns false and conversions which must match CViewCoordinates go through
+/// it point by point instead.
+///
+/// Positions are wrapped into the world the anchor is in, each taking the
+/// shorter way around the antimeridian. Lines and areas are projected by
+/// toWorldPath() instead, which keeps consecutive positions less than half
+/// the world apart, so a path crossing the antimeridian stays continuous and
+/// its bounds stay tight instead of spanning the world.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsProjection
+{
+public:
+	CUserMapsProjection();
+
+	bool update();
+	bool isAccurate() const;
+
+	QPointF toWorld(double latitude, double longitude) const;
+
+	void toWorld(const double *latitudes, const double *longitudes, int count, double *x, double *y) const;
+	void toWorldPath(const double *latitudes, const double *longitudes, int count, double *x, double *y) const;
+	void toPixel(const double *latitudes, const double *longitudes, int count, double *x, double *y) const;
+	void fromPixel(const double *x, const double *y, int count, double *latitudes, double *longitudes) const;
+
+	const QMatrix4x4 &worldToPixel() const;
+	QMatrix4x4 worldToPixel(const CUserMapsProjection &geometrySpace) const;
+	QRectF pixelToWorld(const QRectF &pixels) const;
+	double pixelsPerWorldUnit() const;
+	uint anchorRevision() const;
+
+	static double toWorldDistance(double latitude, double distanceNm);
+	static void toMercator(double latitude, double longitude, double &x, double &y);
+	static void unwrapPath(double *x, int count);
+	static double worldWidth();
+
+private:
+	double fitError(double originX, double originY) const;
+
+	double m_anchorX;				///< Mercator X of the anchor.
+	double m_anchorY;				///< Mercator Y of the anchor.
+	bool m_isAnchored;				///< True once the anchor has been set.
+	uint m_anchorRevision;			///< Incremented every time the anchor moves.
+	bool m_isAccurate;				///< True if the fit matched CViewCoordinates across the view at the last update().
+	QMatrix4x4 m_worldToPixel;		///< Transformation from world space into view pixels.
+	double m_worldToView[6];		///< Same transformation in double precision, relative to the view origin (row major 2x3).
+};
+
+#endif // USERMAPSPROJECTION_H
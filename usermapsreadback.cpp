@@ -0,0 +1,321 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsreadback.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsReadback class, reading rectangles
+///			of a framebuffer without waiting for the GPU.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsreadback.h"
+#include <QDebug>
+#include <QOpenGLContext>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsReadbackResult::UserMapsReadbackResult()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsReadbackResult::UserMapsReadbackResult()
+	: m_format(GL_RGBA),
+	  m_type(GL_UNSIGNED_BYTE),
+	  m_bytesPerLine(0),
+	  m_pPixels(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsReadback::Read::Read()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsReadback::Read::Read()
+	: m_format(GL_RGBA),
+	  m_type(GL_UNSIGNED_BYTE),
+	  m_buffer(-1),
+	  m_fence(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsReadback::CUserMapsReadback()
+///
+/// \brief  Constructor. Pack buffers are created on first use.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsReadback::CUserMapsReadback()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsReadback::~CUserMapsReadback()
+///
+/// \brief  Destructor. Reads not delivered yet are dropped.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsReadback::~CUserMapsReadback()
+{
+	QOpenGLContext *pContext = QOpenGLContext::currentContext();
+	if ( pContext == nullptr )
+		return;
+
+	QOpenGLExtraFunctions *func = pContext->extraFunctions();
+	for (const Read &read : m_pending)
+	{
+		if ( read.m_fence != nullptr )
+			func->glDeleteSync(read.m_fence);
+	}
+	for (const PackBuffer &buffer : m_buffers)
+		func->glDeleteBuffers(1, &buffer.m_id);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsReadback::request(const QRect &rect, GLenum format, GLenum type,
+///                                         const Callback &callback)
+///
+/// \brief  Asks for a rectangle to be read by the next capture().
+///
+/// \param  rect - Rectangle in framebuffer pixels from the bottom left.
+///         format - Format of the pixels, e.g. GL_RGBA for colour buffers or
+///                  GL_RGBA_INTEGER for integer ones.
+///         type - Data type of the pixels, e.g. GL_UNSIGNED_BYTE for colour
+///                buffers or GL_UNSIGNED_INT for integer ones.
+///         callback - Receives the pixels when the read has finished.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsReadback::request(const QRect &rect, GLenum format, GLenum type, const Callback &callback)
+{
+	Read read;
+	read.m_rect = rect;
+	read.m_format = format;
+	read.m_type = type;
+	read.m_callback = callback;
+	m_requested.push_back(read);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsReadback::isBusy() const
+///
+/// \brief  Returns true if reads are still to be captured or delivered, so
+///         another frame is needed.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsReadback::isBusy() const
+{
+	return !m_requested.empty() || !m_pending.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsReadback::capture()
+///
+/// \brief  Starts the requested reads from the framebuffer currently bound.
+///         Returns at once, the copies run behind fences.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsReadback::capture()
+{
+	if ( m_requested.empty() )
+		return;
+
+	QOpenGLExtraFunctions *func = QOpenGLContext::currentContext()->extraFunctions();
+
+	// Rows packed without padding, whatever the pixel size
+	GLint alignment = 4;
+	func->glGetIntegerv(GL_PACK_ALIGNMENT, &alignment);
+	func->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+	for (Read &read : m_requested)
+	{
+		int bytes = read.m_rect.width() * read.m_rect.height() * bytesPerPixel(read.m_format, read.m_type);
+		if ( bytes > 0 )
+		{
+			read.m_buffer = takeBuffer(func, bytes);
+			func->glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[static_cast<size_t>(read.m_buffer)].m_id);
+			func->glReadPixels(read.m_rect.x(), read.m_rect.y(), read.m_rect.width(), read.m_rect.height(),
+							   read.m_format, read.m_type, nullptr);
+			read.m_fence = func->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		else
+		{
+			qDebug() << "CUserMapsReadback::capture() failed! Empty rectangle or unknown pixel format" << read.m_rect;
+		}
+		m_pending.push_back(read);
+	}
+	func->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	func->glPixelStorei(GL_PACK_ALIGNMENT, alignment);
+
+	m_requested.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsReadback::deliver()
+///
+/// \brief  Hands the pixels of the reads the GPU has finished to their
+///         callbacks, in request order. Does not wait.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsReadback::deliver()
+{
+	if ( m_pending.empty() )
+		return;
+
+	QOpenGLExtraFunctions *func = QOpenGLContext::currentContext()->extraFunctions();
+
+	// Fences signal in order, so the first one still running ends the search
+	size_t count = 0;
+	for (; count < m_pending.size(); ++count)
+	{
+		Read &read = m_pending[count];
+		if ( read.m_fence == nullptr )
+		{
+			finish(func, read, false);
+			continue;
+		}
+
+		GLenum status = func->glClientWaitSync(read.m_fence, 0, 0);
+		if ( status == GL_TIMEOUT_EXPIRED )
+			break;
+
+		func->glDeleteSync(read.m_fence);
+		read.m_fence = nullptr;
+		finish(func, read, status != GL_WAIT_FAILED);
+	}
+	m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsReadback::bytesPerPixel(GLenum format, GLenum type)
+///
+/// \brief  Returns size of a pixel read in a format and data type.
+///
+/// \param  format - Format of the pixels.
+///         type - Data type of the pixels.
+///
+/// \return Bytes per pixel, 0 if the format or type is not supported.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsReadback::bytesPerPixel(GLenum format, GLenum type)
+{
+	int components = 0;
+	switch ( format )
+	{
+	case GL_RED:
+	case GL_RED_INTEGER:
+		components = 1;
+		break;
+	case GL_RG:
+	case GL_RG_INTEGER:
+		components = 2;
+		break;
+	case GL_RGB:
+	case GL_RGB_INTEGER:
+		components = 3;
+		break;
+	case GL_RGBA:
+	case GL_RGBA_INTEGER:
+		components = 4;
+		break;
+	default:
+		return 0;
+	}
+
+	switch ( type )
+	{
+	case GL_UNSIGNED_BYTE:
+	case GL_BYTE:
+		return components;
+	case GL_HALF_FLOAT:
+		return components * 2;
+	case GL_UNSIGNED_INT:
+	case GL_INT:
+	case GL_FLOAT:
+		return components * 4;
+	default:
+		return 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsReadback::takeBuffer(QOpenGLExtraFunctions *func, int bytes)
+///
+/// \brief  Takes the smallest free pack buffer holding a read, growing or
+///         creating one if none does.
+///
+/// \param  func - OpenGL ES 3.0 functions.
+///         bytes - Size of the read.
+///
+/// \return Index of the buffer, marked in use.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsReadback::takeBuffer(QOpenGLExtraFunctions *func, int bytes)
+{
+	int best = -1;
+	int largest = -1;
+	for (size_t i = 0; i < m_buffers.size(); ++i)
+	{
+		const PackBuffer &buffer = m_buffers[i];
+		if ( buffer.m_isInUse )
+			continue;
+
+		if ( buffer.m_capacity >= bytes && ( best < 0 || buffer.m_capacity < m_buffers[static_cast<size_t>(best)].m_capacity ) )
+			best = static_cast<int>(i);
+		if ( largest < 0 || buffer.m_capacity > m_buffers[static_cast<size_t>(largest)].m_capacity )
+			largest = static_cast<int>(i);
+	}
+
+	if ( best < 0 )
+	{
+		// Grow a free buffer rather than adding one
+		if ( largest < 0 )
+		{
+			PackBuffer buffer;
+			func->glGenBuffers(1, &buffer.m_id);
+			buffer.m_capacity = 0;
+			buffer.m_isInUse = false;
+			m_buffers.push_back(buffer);
+			largest = static_cast<int>(m_buffers.size()) - 1;
+		}
+
+		best = largest;
+		PackBuffer &buffer = m_buffers[static_cast<size_t>(best)];
+		func->glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.m_id);
+		func->glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		buffer.m_capacity = bytes;
+	}
+
+	m_buffers[static_cast<size_t>(best)].m_isInUse = true;
+	return best;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsReadback::finish(QOpenGLExtraFunctions *func, Read &read, bool isSignalled)
+///
+/// \brief  Hands the pixels of a read to its callback and frees its buffer.
+///
+/// \param  func - OpenGL ES 3.0 functions.
+///         read - Read whose fence has been deleted.
+///         isSignalled - True if the read has finished, false if it failed.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsReadback::finish(QOpenGLExtraFunctions *func, Read &read, bool isSignalled)
+{
+	UserMapsReadbackResult result;
+	result.m_rect = read.m_rect;
+	result.m_format = read.m_format;
+	result.m_type = read.m_type;
+	result.m_bytesPerLine = read.m_rect.width() * bytesPerPixel(read.m_format, read.m_type);
+
+	if ( read.m_buffer < 0 )
+	{
+		if ( read.m_callback )
+			read.m_callback(result);
+		return;
+	}
+
+	PackBuffer &buffer = m_buffers[static_cast<size_t>(read.m_buffer)];
+	func->glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.m_id);
+	if ( isSignalled )
+		result.m_pPixels = static_cast<const uchar *>(func->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+																			 result.m_bytesPerLine * read.m_rect.height(),
+																			 GL_MAP_READ_BIT));
+
+	if ( read.m_callback )
+		read.m_callback(result);
+
+	if ( result.m_pPixels != nullptr )
+		func->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	func->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	buffer.m_isInUse = false;
+}
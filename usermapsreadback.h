@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsreadback.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsReadback class, reading rectangles of
+///			a framebuffer without waiting for the GPU.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSREADBACK_H
+#define USERMAPSREADBACK_H
+
+#include <QOpenGLExtraFunctions>
+#include <QRect>
+#include <functional>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsReadbackResult - pixels of a finished read, handed to the
+///        callback of the request.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsReadbackResult
+{
+	UserMapsReadbackResult();
+
+	QRect m_rect;				///< Rectangle read, in framebuffer pixels from the bottom left.
+	GLenum m_format;			///< Format of the pixels.
+	GLenum m_type;				///< Data type of the pixels.
+	int m_bytesPerLine;			///< Bytes of one row, rows packed without padding, bottom row first.
+	const uchar *m_pPixels;		///< Pixels, valid during the callback only; nullptr if the read failed.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsReadback - asynchronous reads of framebuffer rectangles.
+///
+/// Requested rectangles are read by capture() from the framebuffer bound at
+/// that time into pixel pack buffers, each behind a fence, so the call
+/// returns at once. deliver() polls the fences without waiting and hands the
+/// pixels of the finished reads to their callbacks, in request order, one
+/// or more frames later. Pack buffers are reused by later reads that fit.
+/// All functions require the current OpenGL context and are called on the
+/// render thread; callbacks run there too.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsReadback
+{
+public:
+	typedef std::function<void (const UserMapsReadbackResult &result)> Callback;	///< Receives the pixels of a read.
+
+	CUserMapsReadback();
+	~CUserMapsReadback();
+
+	void request(const QRect &rect, GLenum format, GLenum type, const Callback &callback);
+	bool isBusy() const;
+
+	void capture();
+	void deliver();
+
+	static int bytesPerPixel(GLenum format, GLenum type);
+
+private:
+	CUserMapsReadback(const CUserMapsReadback &) = delete;
+	CUserMapsReadback &operator=(const CUserMapsReadback &) = delete;
+
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief Read - one requested rectangle.
+	////////////////////////////////////////////////////////////////////////////
+	struct Read
+	{
+		Read();
+
+		QRect m_rect;				///< Rectangle to read.
+		GLenum m_format;			///< Format of the pixels.
+		GLenum m_type;				///< Data type of the pixels.
+		Callback m_callback;		///< Receives the pixels.
+		int m_buffer;				///< Pack buffer read into, -1 if the read could not be started.
+		GLsync m_fence;				///< Signalled when the read has finished, nullptr if not started.
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief PackBuffer - pixel pack buffer a read is copied into.
+	////////////////////////////////////////////////////////////////////////////
+	struct PackBuffer
+	{
+		GLuint m_id;				///< OpenGL buffer.
+		int m_capacity;				///< Bytes allocated.
+		bool m_isInUse;				///< True while a read is pending in the buffer.
+	};
+
+	int takeBuffer(QOpenGLExtraFunctions *func, int bytes);
+	void finish(QOpenGLExtraFunctions *func, Read &read, bool isSignalled);
+
+	std::vector<Read> m_requested;		///< Reads to start by the next capture().
+	std::vector<Read> m_pending;		///< Started reads not delivered yet, in request order.
+	std::vector<PackBuffer> m_buffers;	///< Pack buffers, reused.
+};
+
+#endif // USERMAPSREADBACK_H
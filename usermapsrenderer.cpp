@@ -1,1298 +1,890 @@
-////////////////////////////////////////////////////////////////////////////////
-///	\file   usermapsrenderer.cpp
-///
-///	\author Elreg
-///
-///	\brief	Implementation of the CUserMapsRenderer class which renders
-///			the user maps layer.
-///
-///	(C) Kelvin Hughes, 2020.
-////////////////////////////////////////////////////////////////////////////////
-
-#include "usermapsrenderer.h"
-#include <QDebug>
-#include <QElapsedTimer>
-#include <QOpenGLFramebufferObject>
-#include "../OpenGLBaseLib/genericvertexdata.h"
-#include <QTextStream>
-#include "../UserMapsDataLib/usermapsmanager.h"
-#include "../LoggingLib/logginglib.h"
-#include "../UserMapsDataLib/usermapcolourmanager.h"
-#include "../UserMapsDataLib/usermapiconmanager.h"
-
-
-#ifndef GL_PRIMITIVE_RESTART_FIXED_INDEX
-#define GL_PRIMITIVE_RESTART_FIXED_INDEX  0x8D69 ///<taken from opengl specifications
-#endif
-
-const bool LOG_OPENGL_ERRORS = false; ///< Used for open GL errors.
-const int rbDegrees = 360; ///< A circle has 360 degrees.
-static const int FONT_PT_SIZE = 20; ///< Font size.
-
-MapPoint::MapPoint()
-	: m_vertexData(QVector4D( 0.0f, 0.0f, 0.0f, 0.0f ), QVector4D(0.0f , 0.0f, 0.0f, 0.0f)),
-	  m_iconSize(0.0f),
-	  m_icon(0)
-{
-
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn     CUserMapsRenderer::CUserMapsRenderer()
-///
-/// \brief  Constructor.
-////////////////////////////////////////////////////////////////////////////////
-CUserMapsRenderer::CUserMapsRenderer()
-	: CBaseRenderer("UserMapsView", OGL_TYPE::PROJ_ORTHO),
-	  m_tgtTextRenderer(TextRendering::OPENGL),
-	  m_PointBuf(nullptr),
-	  m_LineBuf(nullptr),
-	  m_CircleBuf(nullptr),
-	  m_PolygonBuf(nullptr),
-	  m_pOpenGLLogger(nullptr),
-	  m_pMapShader(nullptr),
-	  out(stdout)
-{
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn CUserMapsRenderer::~CUserMapsRenderer()
-///
-/// \brief Destructor.
-////////////////////////////////////////////////////////////////////////////////
-CUserMapsRenderer::~CUserMapsRenderer()
-{
-	m_tgtTextRenderer.clearText();
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CCUserMapsRenderer::render()
-///
-/// \brief	Called by the Qt framework to render shapes and text.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::render()
-{
-	framebufferObject()->bind();
-	QOpenGLFunctions* pFunctions = QOpenGLContext::currentContext()->functions();
-
-	// Clear the FBO to transparent black
-	pFunctions->glClearColor( 0, 0, 0, 0 );
-	pFunctions->glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT );
-
-	// Enable alpha blending
-	pFunctions->glEnable (GL_BLEND );
-
-	//enable fixed restart index so number of draw calls will be greatly reduced,and performance will be improved
-	pFunctions->glEnable ( GL_PRIMITIVE_RESTART_FIXED_INDEX);
-	pFunctions->glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );	// Set The Blending Function For Translucency
-
-	renderPrimitives( pFunctions );
-	renderTextures();
-
-	// Disable blending after use
-	pFunctions->glDisable( GL_BLEND );
-
-	framebufferObject()->release();
-
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CCUserMapsRenderer::initShader()
-///
-/// \brief	Called by the Qt framework to initialize map shader.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::initShader()
-{
-	if( m_pMapShader == nullptr )
-		m_pMapShader = QSharedPointer<CMapShaderProgram>(new CMapShaderProgram());
-
-}
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::synchronize(QQuickFramebufferObject *item)
-///
-/// \brief	Called by the Qt framework to synchronise data with the Layer.
-///
-/// \param	item - UserMapslayer to synchronise with.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::synchronize(QQuickFramebufferObject *item)
-{
-	Q_UNUSED(item);
-
-	// Get the view dimensions
-	qreal left = 0, right = 0, top = 0, bottom = 0;
-	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
-
-
-	// Initialise OpenGL if needed
-	if(!m_bGLinit)
-	{
-		initializeGL();
-	}
-
-	m_tgtTextRenderer.clearText();
-
-	float pixelsInMm = static_cast<float>(CViewCoordinates::Instance()->getScreenMmToPixels());
-	if ( pixelsInMm == 0.0f )
-		return;
-
-	m_pPoints.clear();
-	m_pTexture.clear();
-	m_pfilledPolygonData.clear();
-	m_pCircleData.clear();
-	m_pfilledCircleData.clear();
-	m_pLineData.clear();
-	m_pPolygonData.clear();
-
-	// pick selected objects
-	const QMap<QString, QSharedPointer<CUserMap> > &loadedMaps = CUserMapsManager::getLoadedMapsStat();
-	QMap<QString, QSharedPointer<CUserMap>>::const_iterator iter = loadedMaps.constBegin();
-	while (iter != loadedMaps.constEnd())
-	{
-		auto &pMap = iter.value();
-		const CUserMapObjectContainer<CUserMapPoint> &points = pMap->getPoints();
-		const CUserMapObjectContainer<CUserMapArea> &areas = pMap->getAreas();
-		const CUserMapObjectContainer<CUserMapLine> &lines = pMap->getLines();
-		const CUserMapObjectContainer<CUserMapCircle> &circles = pMap->getCircles();
-
-		for (auto item : {EUserMapObjectStatus::Loaded, EUserMapObjectStatus::Edited, EUserMapObjectStatus::Created})
-		{
-			updatePointsData(points.map(item));
-			updateLines(lines.map(item));
-			updateCircles(circles.map(item));
-			updatePolygons(areas.map(item));
-		}
-
-		EUserMapObjectType objType = pMap->getSelectedObjectType();
-
-		switch (objType)
-		{
-		case EUserMapObjectType::Point: {
-			updatePointData(pMap->getSelectedObject().staticCast< CUserMapPoint>());
-			break;
-		}
-		case EUserMapObjectType::Circle:
-		{
-			std::vector<GenericVertexData> circle;
-			updateCircle(pMap->getSelectedObject().staticCast< CUserMapCircle>(), circle);
-			circle.pop_back();//remove last point, because it is same as the first one
-
-			fillCircle(circle, convertColour(pMap->getSelectedObject().staticCast< CUserMapCircle>()->getColor(), pMap->getSelectedObject().staticCast< CUserMapCircle>()->getTransparency()));
-			break;
-		}
-		
-		case EUserMapObjectType::Line:
-		{
-			updateLine(pMap->getSelectedObject().staticCast< CUserMapLine>());
-			break;
-
-		}
-		
-		case EUserMapObjectType::Area:
-		{
-			std::vector<GenericVertexData> area;
-			updatePolygon(pMap->getSelectedObject().staticCast< CUserMapArea>(), area);
-			fillPolygon(area, convertColour(pMap->getSelectedObject().staticCast< CUserMapArea>()->getColor() , pMap->getSelectedObject().staticCast< CUserMapArea>()->getTransparency()));
-			break;
-		}
-		case EUserMapObjectType::Unkown_Object:
-		{
-		}
-		}
-
-		pMap->getSelectedObject();
-
-		iter++;
-	}
-
-	// Set the width, height and projection for each target texture
-	for( uint i = 0; i < m_pTexture.size(); ++i )
-	{
-		float imgWidthInMM = m_pTexture[i]->imageWidth() / 20.0f;	// Images are designed to be 20 texels/mm
-		float textureWidthInPixels = imgWidthInMM * pixelsInMm;	// Total width in pixels
-		float imgHeightInMM = m_pTexture[i]->imageHeight() / 20.0f;
-		float textureHeightInPixel = imgHeightInMM * pixelsInMm;
-		m_pTexture[i]->setWidth(textureWidthInPixels/2.0f); // set width for one side (left/right)
-		m_pTexture[i]->setHeight(textureHeightInPixel/2.0f);
-		m_pTexture[i]->setProjection(left, right, bottom, top);
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::initializeGL()
-///
-/// \brief	Initialise OpenGL for this renderer.
-///			Includes creating the image textures;
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::initializeGL()
-{
-	QOpenGLFunctions* func = QOpenGLContext::currentContext()->functions();
-	func->initializeOpenGLFunctions();
-
-	func->glClearColor(0, 0, 0, 0);
-	func->glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-
-	if( m_pOpenGLLogger == nullptr )
-	{
-		QOpenGLContext *pContext = QOpenGLContext::currentContext();
-		if( pContext != nullptr )
-		{
-			if( LOG_OPENGL_ERRORS )
-			{
-				if( pContext->hasExtension(QByteArrayLiteral("GL_KHR_debug")) )
-				{
-					m_pOpenGLLogger = new QOpenGLDebugLogger();
-					bool bOk = m_pOpenGLLogger->initialize();
-					if ( bOk )
-						qDebug() << "\nCUserMapsRenderer OpenGL debug logging initialized";
-					else
-						qDebug() << "\nCUserMapsRenderer OpenGL debug logging initialization failed";
-				}
-			}
-		}
-	}
-
-	// Initialise the string renderer
-	QOpenGLFunctions* openGL = QOpenGLContext::currentContext()->functions();
-
-	if( openGL->glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE )
-	{
-		m_tgtTextRenderer.init( framebufferObject(), &m_textureShader );
-
-		// Get the view dimensions
-		qreal left = 0;
-		qreal right = 0;
-		qreal top = 0;
-		qreal bottom = 0;
-		CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
-		m_tgtTextRenderer.setScreenGeometry( QRect( static_cast<int> ( left ),
-													static_cast<int> ( top ),
-													static_cast<int> ( right ),
-													static_cast<int> ( bottom ) ) );
-
-	}
-	m_bGLinit = true;
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::renderPrimitives( QOpenGLFunctions* func )
-///
-/// \brief	Render shapes.
-///
-/// \param	func - The QOpenGLFunctions to use if needed.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::renderPrimitives(QOpenGLFunctions *func)
-{
-
-	drawPoints(func);
-	drawfilledPolygons(func);
-	drawfilledCircles(func);
-	drawLines(func);
-	drawCircles(func);
-	drawPolygons(func);
-
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::renderTextures()
-///
-/// \brief	Render the textures and text.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::renderTextures()
-{
-	m_textureShader.bind();
-
-	for ( uint i = 0; i < m_pPoints.size(); ++i )
-	{
-		// Calculate target plot data
-		QMatrix4x4 matrix;
-
-		// Set translation
-		matrix.translate(m_pPoints[i].m_vertexData.position().x(),m_pPoints[i].m_vertexData.position().y(), 0.0f );
-
-		// Set scale
-		float fScaleWidth = m_pTexture[i]->getWidth();
-		float fScaleHeight = m_pTexture[i]->getHeight();
-		matrix.scale(fScaleWidth, fScaleHeight, 0.0f);
-
-		// Set the projection matrix
-		m_textureShader.setMVPMatrix(m_pTexture[i]->getProjection() * matrix);
-
-		// Set the texture colour
-		m_textureShader.setTexUserColour(m_pPoints[i].m_vertexData.color());
-
-		// Use texture unit 0 for the sampler
-		m_textureShader.setTextureSampler(0);
-
-		// Draw the target
-		m_pTexture[i]->drawTexture(&m_textureShader);
-	}
-
-	m_tgtTextRenderer.renderText();
-	m_textureShader.release();
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updateLines(const QMap<int, QSharedPointer<CUserMapLine> >&loadedLines)
-///
-/// \brief	Add line points so line could be drawn.
-///
-/// \param	loadedLines- lines that should be drawn.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updateLines(const QMap<int, QSharedPointer<CUserMapLine> >&loadedLines )
-{
-	if( !m_LineBuf.isNull() )
-	{
-		m_LineBuf.clear();
-		m_LineBuf = nullptr;
-	}
-
-	if(loadedLines.empty()) return; //if there is not any line return
-
-	// Screen information
-	double pixelsInMm = CViewCoordinates::Instance()->getScreenMmToPixels();
-	if ( pixelsInMm == 0.0 )
-		return ;//if screen information cannot be read also return;
-
-	for(QMap<int, QSharedPointer<CUserMapLine> >::const_iterator it = loadedLines.constBegin(); it != loadedLines.constEnd() ; it++)
-	{
-		std::vector<GenericVertexData> line;
-		updateLine(it.value());
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updateLine(const QSharedPointer<CUserMapLine>& it)
-///
-/// \brief	Add points so line could be drawn.
-///
-/// \param	it - Pointer that points to line.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updateLine(const QSharedPointer<CUserMapLine>& it)
-{
-	// Get coordiante system data
-	qreal originX = 0.0;
-	qreal originY = 0.0;
-	CViewCoordinates::Instance()->getViewOriginPixel( originX, originY );
-
-
-	qreal offsetX = 0.0;
-	qreal offsetY = 0.0;
-	CViewCoordinates::Instance()->getGeoOriginOffsetPixel( offsetX, offsetY );
-	std::vector<GenericVertexData> line;
-	CUserMapsVertexData tempData;
-	for (const CPosition & point : it->getPoints())
-	{
-
-		// Relative target position (in pixels) from the ownship (Geo Origin)
-		GEOGRAPHICAL dfLat = ToGEOGRAPHICAL(point.Latitude());
-		GEOGRAPHICAL dfLon = ToGEOGRAPHICAL(point.Longitude());
-		PIXEL tgtPosX;
-		PIXEL tgtPosY;
-		CViewCoordinates::Instance()->Convert(dfLat, dfLon, tgtPosX, tgtPosY);
-
-		// Absolute target position (in pixels)
-		double xPos = tgtPosX + originX;
-		double yPos = tgtPosY + originY;
-
-		line.push_back( GenericVertexData(QVector4D( static_cast<float>(xPos), static_cast<float>(yPos), 0.0f, 1.0f), convertColour(it->getColor(), it->getTransparency())));
-	}
-
-	tempData.setVertexData(line);
-	setLineStyle(tempData,it->getLineStyle(),it->getLineWidth());
-
-	m_pLineData.push_back(tempData);
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updateCircles(const QMap<int, QSharedPointer<CUserMapCircle> >& loadedCircles)
-///
-/// \brief	Add Circle points so circle could be drawn.
-///
-/// \param	loadedCircles - Circles that should be drawn.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updateCircles(const QMap<int, QSharedPointer<CUserMapCircle> >& loadedCircles)
-{
-
-	if( !m_CircleBuf.isNull() )
-	{
-		m_CircleBuf.clear();
-		m_CircleBuf = nullptr;
-	}
-
-	if(loadedCircles.empty())
-		return;
-
-	// Screen information
-	double pixelsInMm = CViewCoordinates::Instance()->getScreenMmToPixels();
-	if ( pixelsInMm == 0.0 )
-		return ;
-
-	for (QMap<int, QSharedPointer<CUserMapCircle> >::const_iterator it = loadedCircles.constBegin(); it != loadedCircles.constEnd() ; it++)
-	{
-		std::vector<GenericVertexData> circle;
-		updateCircle(it.value(), circle );
-		circle.pop_back();//remove last point, because it is same as the first one
-
-		fillCircle(circle, convertColour( it.value()->getColor(),it.value()->getTransparency()));
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updateCircle(const QSharedPointer<CUserMapCircle>& it, std::vector<GenericVertexData>& circle)
-///
-/// \brief	Add Circle points so circle could be drawn.
-///
-/// \param	it - Pointer that points to circle.
-///         circle - Vector where circle points will be stored.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updateCircle(const QSharedPointer<CUserMapCircle>& it, std::vector<GenericVertexData>& circle)
-{
-	// Get coordiante system data
-	qreal originX = 0.0;
-	qreal originY = 0.0;
-	CViewCoordinates::Instance()->getViewOriginPixel( originX, originY );
-
-	qreal offsetX = 0.0;
-	qreal offsetY = 0.0;
-	CViewCoordinates::Instance()->getGeoOriginOffsetPixel( offsetX, offsetY );
-	const int k = 8; // k is used as a circle segment for  drawing circle
-	circle.reserve(360 / k + 3);//number of points needed for circle
-
-	double radius = it->getRadius() * CViewCoordinates::getNauticalMilesToPixels();
-
-	int bufferIndex = 0;
-
-	// Relative target position (in pixels) from the ownship (Geo Origin)
-	GEOGRAPHICAL dfLat = ToGEOGRAPHICAL(it->getCenter().Latitude());
-	GEOGRAPHICAL dfLon = ToGEOGRAPHICAL(it->getCenter().Longitude());
-	PIXEL tgtPosX;
-	PIXEL tgtPosY;
-	CViewCoordinates::Instance()->Convert(dfLat, dfLon, tgtPosX, tgtPosY);
-
-	// Absolute target position (in pixels)
-	double xCenter = tgtPosX + originX;
-	double yCenter = tgtPosY + originY;
-
-	// Draw the circle (line strip)
-	for ( bufferIndex = 0; bufferIndex <= rbDegrees; bufferIndex += k )
-	{
-		double angle = 2 * M_PI * bufferIndex / rbDegrees;
-		float x = static_cast<float>(xCenter + (radius * std::sin(angle)));
-		float y = static_cast<float>(yCenter - (radius * std::cos(angle)));
-
-		// Set Vertex data
-		circle.push_back( GenericVertexData(QVector4D(x, y, 0.0f, 1.0f), convertColour(it->getOutlineColor())));
-
-		// Check if it is the last point
-		if( bufferIndex == rbDegrees )
-		{
-			circle.push_back( GenericVertexData(QVector4D(x, y, 0.0f, 1.0f), convertColour(it->getOutlineColor())));
-		}
-
-	}
-	CUserMapsVertexData tempData;
-	tempData.setVertexData(circle);
-	setLineStyle(tempData,it->getLineStyle(),it->getLineWidth());
-
-	m_pCircleData.push_back(tempData);
-
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::fillCircle(const std::vector<GenericVertexData>& circle, qreal originX, qreal originY, QVector4D colour)
-///
-/// \brief	Add Circle points so circle could be drawn.
-///
-/// \param	it - Pointer that points to circle.
-///         circle - Vector where circle points will be stored.
-///         colour - Used to paint circle.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::fillCircle(const std::vector<GenericVertexData>& circle, QVector4D colour)
-{
-	// Get coordiante system data
-	qreal originX = 0.0;
-	qreal originY = 0.0;
-	CViewCoordinates::Instance()->getViewOriginPixel( originX, originY );
-
-	qreal offsetX = 0.0;
-	qreal offsetY = 0.0;
-	CViewCoordinates::Instance()->getGeoOriginOffsetPixel( offsetX, offsetY );
-	std::vector<GenericVertexData> filledCircle;
-	for(const GenericVertexData & data : circle)
-	{
-		filledCircle.push_back(GenericVertexData(data.position(), colour));
-	}
-	filledCircle.push_back(GenericVertexData(QVector4D(originX, originY, 0.0f, 1.0f), colour));// add center so,circles could be drawn more effectively in opengl
-	m_pfilledCircleData.push_back(filledCircle);
-
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updatePolygons(const QMap<int, QSharedPointer<CUserMapArea> >& loadedArea)
-///
-/// \brief	Adds polygon points.
-///
-/// \param	loadedArea - Received areas that should be drawn.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updatePolygons(const QMap<int, QSharedPointer<CUserMapArea> >& loadedAreas)
-{
-
-	if( !m_PolygonBuf.isNull() )
-	{
-		m_PolygonBuf.clear();
-		m_PolygonBuf = nullptr;
-	}
-
-	if(loadedAreas.empty())
-		return;
-
-	// Screen information
-	double pixelsInMm = CViewCoordinates::Instance()->getScreenMmToPixels();
-	if ( pixelsInMm == 0.0 )
-		return ;
-
-	QMap<int, QSharedPointer<CUserMapCircle> >::Iterator it;
-
-	for (QMap<int, QSharedPointer<CUserMapArea> >::const_iterator it = loadedAreas.constBegin(); it != loadedAreas.constEnd() ; it++)
-	{
-		std::vector<GenericVertexData> polygon; //test case polygon ,will be deleted
-
-		updatePolygon(it.value(), polygon);
-		fillPolygon(polygon, convertColour(it.value()->getColor(), it.value()->getTransparency()));
-
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updatePolygon(const QSharedPointer<CUserMapArea>& it, std::vector<GenericVertexData>& polygon)
-///
-/// \brief	Add area points so polygon could be drawn.
-///
-/// \param	it - Pointer that points to area.
-///         polygon - Vector where polygon points will be stored.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updatePolygon(const QSharedPointer<CUserMapArea>& it, std::vector<GenericVertexData>& polygon)
-{
-	// Get coordiante system data
-	qreal originX = 0.0;
-	qreal originY = 0.0;
-	CViewCoordinates::Instance()->getViewOriginPixel( originX, originY );
-
-	qreal offsetX = 0.0;
-	qreal offsetY = 0.0;
-	CViewCoordinates::Instance()->getGeoOriginOffsetPixel( offsetX, offsetY );
-	for(const CPosition & point : it->getPoints())
-	{
-
-		// Relative target position (in pixels) from the ownship (Geo Origin)
-		GEOGRAPHICAL dfLat = ToGEOGRAPHICAL(point.Latitude());
-		GEOGRAPHICAL dfLon = ToGEOGRAPHICAL(point.Longitude());
-		PIXEL tgtPosX;
-		PIXEL tgtPosY;
-		CViewCoordinates::Instance()->Convert(dfLat, dfLon, tgtPosX, tgtPosY);
-
-		// Absolute target position (in pixels)
-		double xPos = tgtPosX + originX;
-		double yPos = tgtPosY + originY;
-
-		polygon.push_back( GenericVertexData(QVector4D( static_cast<float>(xPos), static_cast<float>(yPos), 0.0f, 1.0f), convertColour(it->getOutlineColor())));
-	}
-
-	CUserMapsVertexData tempData;
-	tempData.setVertexData(polygon);
-	setLineStyle(tempData, it->getLineStyle(), it->getLineWidth());
-	m_pPolygonData.push_back(tempData);
-
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::fillPolygon(const std::vector<GenericVertexData> &polygon,  QVector4D colour)
-///
-/// \brief	Add polygon points so filled polygon could be drawn.
-///
-/// \param	it - pointer that points to circle.
-///         polygon - vector where polygon points will be stored.
-///         colour - used to paint polygon.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::fillPolygon(const std::vector<GenericVertexData> &polygon,  QVector4D colour)
-{
-	std::vector<GenericVertexData>result;
-	Triangulate::Process(polygon, result); //triangulate received points
-
-	for(GenericVertexData &data : result)
-		data.setColor(colour);
-	m_pfilledPolygonData.push_back(result);
-}
-
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updatePointsData(const QMap<int, QSharedPointer<CUserMapPoint> > &pointData)
-///
-/// \brief	Add textures that should be drawn.
-///
-/// \param	pointData - Textures details.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updatePointsData(const QMap<int, QSharedPointer<CUserMapPoint> > &pointData)
-{
-
-	for(const QSharedPointer<CUserMapPoint>& uPoint : pointData)
-	{
-		updatePointData(uPoint);
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::updatePointData(const QSharedPointer<CUserMapPoint>& uPoint)
-///
-/// \brief	Updates points so they could be drawn.
-///
-/// \param	uPoint - Pointer that points to UserMapPoint.
-////////////////////////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::updatePointData(const QSharedPointer<CUserMapPoint>& uPoint)
-{
-	qreal originX = 0;
-	qreal originY = 0;
-	CViewCoordinates::Instance()->getViewOriginPixel( originX, originY );
-
-	// Geo Origin
-	qreal offsetX = 0;
-	qreal offsetY = 0;
-	CViewCoordinates::Instance()->getGeoOriginOffsetPixel( offsetX, offsetY );
-	MapPoint data;
-	GEOGRAPHICAL dfLat = ToGEOGRAPHICAL(uPoint->getPosition().Latitude());
-	GEOGRAPHICAL dfLon = ToGEOGRAPHICAL(uPoint->getPosition().Longitude());
-	PIXEL tgtPosX;
-	PIXEL tgtPosY;
-	CViewCoordinates::Instance()->Convert(dfLat, dfLon, tgtPosX, tgtPosY);
-
-	// Absolute target position (in pixels)
-	double xPos = tgtPosX + originX;
-	double yPos = tgtPosY + originY;
-
-	QVector4D colour = convertColour(uPoint->getColor(),uPoint->getTransparency());
-	// Set attributes
-
-	data.m_icon = uPoint->getIcon();
-	data.m_iconSize = uPoint->getIconSize();
-	data.m_vertexData= GenericVertexData(QVector4D( static_cast<float>(xPos), static_cast<float>(yPos), 0.0f, 1.0f ),colour);
-
-	QString strIconPath = CUserMapIconManager::instance()->getIconPath(data.m_icon);
-
-	m_pPoints.push_back(data);
-	m_pTexture.push_back( QSharedPointer<CImageTexture>(new CImageTexture( strIconPath, colour)));
-
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn void CUserMapsRenderer::drawPoints(QOpenGLFunctions *func)
-///
-/// \brief  Handles mouse move event.
-///
-/// \param  func - Pointer that points to QOpenGLFunctions.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::drawPoints(QOpenGLFunctions *func)
-{
-
-	// Set translation matrix (no translation)
-	QMatrix4x4 translation;
-	translation.translate(0.0, 0.0, 0.0);
-
-	// Set projection matrix
-	QMatrix4x4 projection;
-	qreal left = 0;
-	qreal right = 0;
-	qreal top = 0;
-	qreal bottom = 0;
-	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
-	setProjection( left, right, bottom, top, projection );
-
-	// Bind the shader
-	m_primShader.bind();
-
-	// Set the projection and translation
-	m_primShader.setMVPMatrix(projection * translation);
-
-	addPointstoBuffer();
-
-	m_PointBuf->bind();
-
-	// Check Frame buffer is OK
-	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if( e != GL_FRAMEBUFFER_COMPLETE)
-		qDebug() << "CUserMapsRenderer::drawPoints() failed! Not GL_FRAMEBUFFER_COMPLETE";
-
-	m_primShader.setupVertexState();
-
-	func->glDrawArrays(GL_POINTS, 0, m_pPointData.size());
-	// Tidy up
-	m_primShader.cleanupVertexState();
-
-	m_PointBuf->release();
-
-	m_primShader.release();
-
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::drawLines(QOpenGLFunctions *func)
-///
-/// \brief	Draws Lines.
-///
-/// \param  func - Pointer that points to QOpenGLFunctions.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::drawLines(QOpenGLFunctions *func)
-{
-
-	// Set translation matrix (no translation)
-	QMatrix4x4 translation;
-	translation.translate(0.0, 0.0, 0.0);
-
-	// Set projection matrix
-	QMatrix4x4 projection;
-	qreal left = 0;
-	qreal right = 0;
-	qreal top = 0;
-	qreal bottom = 0;
-	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
-	setProjection( left, right, bottom, top, projection );
-
-	initShader();
-
-	// Bind the shader
-	m_pMapShader->bind();
-
-	// Set the projection and translation
-	m_pMapShader->setMVPMatrix(projection * translation);
-
-	GLfloat winWidth = static_cast<float>(right-left);
-	GLfloat winHeight = static_cast<float>(bottom-top);
-
-	m_pMapShader->setResolution(winWidth, winHeight);
-
-
-	drawMultipleElements(m_LineBuf, m_pLineData);
-
-	m_LineBuf->bind();
-
-	// Check Frame buffer is OK
-	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if( e != GL_FRAMEBUFFER_COMPLETE)
-		qDebug() << "CUserMapsRenderer::drawLines() failed! Not GL_FRAMEBUFFER_COMPLETE";
-
-	m_pMapShader->setupVertexState();
-
-	int offset = 0;
-
-
-	func->glLineWidth(500);
-
-	for(uint i = 0; i<m_pLineData.size(); i++ )
-	{
-		m_pMapShader->setDashSize(m_pLineData[i].getDashSize());
-		m_pMapShader->setGapSize(m_pLineData[i].getGapSize());
-		m_pMapShader->setDotSize(m_pLineData[i].getDotSize());
-
-		func->glDrawArrays(GL_LINE_STRIP, offset,  m_pLineData[i].getVertexData().size());
-		func->glLineWidth(1);
-		offset += m_pLineData[i].getVertexData().size();
-	}
-	//func->glDrawArrays(GL_LINE_STRIP, 0,  counter);
-	// Tidy up
-	m_pMapShader->cleanupVertexState();
-
-	m_LineBuf->release();
-
-	m_pMapShader->release();
-
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::drawPolygons(QOpenGLFunctions *func)
-///
-/// \brief	Draws polygons.
-///
-/// \param  func - Pointer that points to QOpenGLFunctions.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::drawPolygons(QOpenGLFunctions *func)
-{
-
-	// Set translation matrix (no translation)
-	QMatrix4x4 translation;
-	translation.translate(0.0, 0.0, 0.0);
-
-	// Set projection matrix
-	QMatrix4x4 projection;
-	qreal left = 0;
-	qreal right = 0;
-	qreal top = 0;
-	qreal bottom = 0;
-	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
-	setProjection( left, right, bottom, top, projection );
-
-	initShader();
-	m_pMapShader->bind();
-
-	// Set the projection and translation
-	m_pMapShader->setMVPMatrix(projection * translation);
-
-	GLfloat winWidth = static_cast<float>(right-left);
-	GLfloat winHeight = static_cast<float>(bottom-top);
-
-	m_pMapShader->setResolution(winWidth, winHeight);
-
-	drawMultipleElements(m_PolygonBuf, m_pPolygonData);
-
-	m_PolygonBuf->bind();
-
-	// Check Frame buffer is OK
-	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if( e != GL_FRAMEBUFFER_COMPLETE)
-		qDebug() << "CUserMapsRenderer::drawPolygons() failed! Not GL_FRAMEBUFFER_COMPLETE";
-
-	m_pMapShader->setupVertexState();
-
-	int offset = 0;
-
-	for(uint i = 0; i<m_pPolygonData.size(); i++ )
-	{
-		m_pMapShader->setDashSize(m_pPolygonData[i].getDashSize());
-		m_pMapShader->setGapSize(m_pPolygonData[i].getGapSize());
-		m_pMapShader->setDotSize(m_pPolygonData[i].getDotSize());
-
-		func->glDrawArrays(GL_LINE_LOOP, offset,  m_pPolygonData[i].getVertexData().size());
-		func->glLineWidth(1);
-		offset += m_pPolygonData[i].getVertexData().size();
-	}
-
-	// Tidy up
-	m_pMapShader->cleanupVertexState();
-
-	m_PolygonBuf->release();
-
-	m_pMapShader->release();
-
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::drawfilledPolygons(QOpenGLFunctions *func)
-///
-/// \brief  Draws polygons.
-///
-/// \param  func - Pointer that points to QOpenGLFunctions.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::drawfilledPolygons(QOpenGLFunctions *func)
-{
-
-	// Set translation matrix (no translation)
-	QMatrix4x4 translation;
-	translation.translate(0.0, 0.0, 0.0);
-
-	// Set projection matrix
-	QMatrix4x4 projection;
-	qreal left = 0;
-	qreal right = 0;
-	qreal top = 0;
-	qreal bottom = 0;
-	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
-	setProjection( left, right, bottom, top, projection );
-
-	// Bind the shader
-	m_primShader.bind();
-
-	// Set the projection and translation
-	m_primShader.setMVPMatrix(projection * translation);
-
-	int counter=drawMultipleElements(m_filledPolygonBuf, m_pfilledPolygonData);
-	m_filledPolygonBuf->bind();
-
-	// Check Frame buffer is OK
-	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if( e != GL_FRAMEBUFFER_COMPLETE)
-		qDebug() << "COwnshipRenderer::drawPolygons() failed! Not GL_FRAMEBUFFER_COMPLETE";
-
-	m_primShader.setupVertexState();
-
-	//draw
-	func->glDrawArrays(GL_TRIANGLES, 0, counter);
-
-	// Tidy up
-	m_primShader.cleanupVertexState();
-
-	m_filledPolygonBuf->release();
-
-	m_primShader.release();
-
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn void CUserMapsRenderer::drawfilledCircles(QOpenGLFunctions *func)
-///
-/// \brief  Draws Circles.
-///
-/// \param  func - Pointer that points to QOpenGLFunctions.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::drawfilledCircles(QOpenGLFunctions *func) 
-{
-	// Set translation matrix (no translation)
-	QMatrix4x4 translation;
-	translation.translate(0.0, 0.0, 0.0);
-
-	// Set projection matrix
-	QMatrix4x4 projection;
-	qreal left = 0;
-	qreal right = 0;
-	qreal top = 0;
-	qreal bottom = 0;
-	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top);
-	setProjection( left, right, bottom, top, projection );
-
-	// Bind the shader
-	m_primShader.bind();
-
-	// Set the projection and translation
-	m_primShader.setMVPMatrix(projection * translation);
-
-
-	// Tell OpenGL which VBOs to use
-	drawMultipleElements(m_InlineCircleBuf, m_pfilledCircleData);
-	m_InlineCircleBuf->bind();
-
-
-	// Check Frame buffer is OK
-	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if( e != GL_FRAMEBUFFER_COMPLETE)
-		qDebug() << "CUserMapsRenderer::drawfilledCircles() failed! Not GL_FRAMEBUFFER_COMPLETE";
-
-	m_primShader.setupVertexState();
-	int offset = 0; //offset
-
-	//Draw inline and outline circle from data in the VBOs
-
-	for(uint  i = 0; i<m_pfilledCircleData.size(); i++)
-	{
-		func->glDrawArrays(GL_TRIANGLE_FAN, offset, m_pfilledCircleData[i].size());
-		offset += m_pfilledCircleData[i].size();
-	}
-	func->glLineWidth( 1 );
-
-	// Tidy up
-	m_InlineCircleBuf->release();
-
-	m_primShader.cleanupVertexState();
-
-	m_primShader.release();
-
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::drawCircles(QOpenGLFunctions *func)
-///
-/// \brief  Draws outline Circle.
-///
-/// \param  func - Pointer that points to QOpenGLFunctions.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::drawCircles(QOpenGLFunctions *func)
-{
-	// Set translation matrix (no translation)
-	QMatrix4x4 translation;
-	translation.translate(0.0, 0.0, 0.0);
-
-	// Set projection matrix
-	QMatrix4x4 projection;
-	qreal left = 0;
-	qreal right = 0;
-	qreal top = 0;
-	qreal bottom = 0;
-	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top);
-	setProjection( left, right, bottom, top, projection );
-	initShader();
-
-	// Bind the shader
-	m_pMapShader->bind();
-
-	// Set the projection and translation
-	m_pMapShader->setMVPMatrix(projection * translation);
-
-
-	GLfloat winWidth = static_cast<float>(right-left);
-	GLfloat winHeight = static_cast<float>(bottom-top);
-
-	m_pMapShader->setResolution(winWidth, winHeight);
-
-	// Tell OpenGL which VBOs to use
-	drawMultipleElements(m_CircleBuf, m_pCircleData);
-	m_CircleBuf->bind();
-
-	// Check Frame buffer is OK
-	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
-	if( e != GL_FRAMEBUFFER_COMPLETE)
-		qDebug() << "CUserMapsRenderer::drawCircles() failed! Not GL_FRAMEBUFFER_COMPLETE";
-
-	m_pMapShader->setupVertexState();
-	func->glLineWidth(1);
-
-	int offset = 0;
-
-	for(uint i = 0; i<m_pCircleData.size(); i++ )
-	{
-		m_pMapShader->setDashSize(m_pCircleData[i].getDashSize());
-		m_pMapShader->setGapSize(m_pCircleData[i].getGapSize());
-		m_pMapShader->setDotSize(m_pCircleData[i].getDotSize());
-
-		func->glDrawArrays(GL_LINE_STRIP, offset,  m_pCircleData[i].getVertexData().size());
-		func->glLineWidth(1);
-		offset += m_pCircleData[i].getVertexData().size();
-	}
-
-	// Tidy up
-	m_pMapShader->cleanupVertexState();
-
-	m_CircleBuf->release();
-
-	m_pMapShader->release();
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn void CUserMapsRenderer::addPointstoBuffer()
-///
-/// \brief	Adds points from vector to buffer
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::addPointstoBuffer() 
-{
-	m_PointBuf = QSharedPointer<CVertexBuffer>( new CVertexBuffer(m_pPointData.data(), m_pPointData.size()));
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn     CUserMapsRenderer::drawMultipleElements(QSharedPointer<CVertexBuffer> &buffer ,
-///								const std::vector<std::vector<GenericVertexData>> &data)
-///
-/// \brief  add genericvertexdata to buffer
-///
-/// \param  buffer - vertex buffer
-///         data- points that form a shape
-////////////////////////////////////////////////////////////////////////////////
-int CUserMapsRenderer::drawMultipleElements(QSharedPointer<CVertexBuffer> &buffer,
-							const std::vector<std::vector<GenericVertexData>> &data) 
-{
-	uint counter = 0;
-
-	for( uint  i = 0; i < data.size(); i++)
-	{
-		counter += data[i].size();
-	}
-
-	std::vector<GenericVertexData> vertices;
-	vertices.reserve(counter);
-
-	for( uint  i=0; i < data.size(); i++)
-	{
-		for( uint j=0; j < data[i].size(); j++)
-		{
-			vertices.push_back(data[i][j]);
-		}
-	}
-	buffer = QSharedPointer<CVertexBuffer>( new CVertexBuffer(vertices.data(), counter));
-
-	return counter;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn	int CUserMapsRenderer::drawMultipleElements( QSharedPointer<CVertexBuffer> &buffer,
-///											const std::vector<CUserMapsVertexData> &data)
-///
-/// \brief	Adds usermapsvertexdata to buffer.
-///
-/// \param  buffer - Vertex buffer.
-///         data - Points that form a shape.
-///
-/// \return Number of elements to be rendered.
-////////////////////////////////////////////////////////////////////////////////
-int CUserMapsRenderer::drawMultipleElements( QSharedPointer<CVertexBuffer> &buffer, 
-											const std::vector<CUserMapsVertexData> &data)
-{
-	uint totalSize = 0;
-	for (uint i = 0; i < data.size(); i++)
-		totalSize += data[i].getVertexData().size();
-
-	std::vector<GenericVertexData> vertices;
-	vertices.reserve(totalSize);
-
-	for (uint i = 0; i < data.size(); i++)
-	{
-		for (uint j = 0; j < data[i].getVertexData().size(); j++)
-			vertices.push_back(data[i].getVertexData().at(j));
-	}
-
-	buffer = QSharedPointer<CVertexBuffer>(new CVertexBuffer( vertices.data(), totalSize));
-
-	return totalSize;
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn void CUserMapsRenderer::logOpenGLErrors()
-///
-/// \brief  OpenGL logger.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::logOpenGLErrors()
-{
-	if( m_pOpenGLLogger )
-	{
-		const QList<QOpenGLDebugMessage> messages = m_pOpenGLLogger->loggedMessages();
-		for (const QOpenGLDebugMessage &message : messages)
-		{
-			//if( message.severity() == QOpenGLDebugMessage::HighSeverity || message.severity() == QOpenGLDebugMessage::MediumSeverity )
-			qDebug() << "CUserMapsRenderer:" << message;
-		}
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn void CUserMapsRenderer::addText( QString text, double x, double y, QVector4D colour,
-///																TextAlignment alignment)
-///
-/// \brief	This function is used for writing text.
-///
-/// \param  text - Text to be written.
-///			x - xAxis position of text.
-///			y - yAxis position of text.
-///			colour - Colour of the text.
-///			alignment - Specifies text alignment.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::addText( QString text,double x, double y, QVector4D colour,
-												TextAlignment alignment)
-{
-	m_tgtTextRenderer.addText( text, static_cast<int> (x ), static_cast<int> ( y ), FONT_PT_SIZE, colour, alignment );
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn void CUserMapsRenderer::testCircle(qreal originX, qreal originY)
-///
-/// \brief	This function is used for measuring drawing speed.
-///
-/// \param	originX - xAxis position of the origin.
-///         originY - yAxis position of the origin.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::testCircle(qreal originX, qreal originY) 
-{
-	double radius = CViewCoordinates::Instance()->getRadiusPixels() / 128;
-
-	int bufferIndex = 0;
-	std::vector<GenericVertexData> circle;
-	std::vector<GenericVertexData> circle2;
-	std::vector<GenericVertexData> circle3;
-
-	// Draw the circle (line strip)
-	for ( bufferIndex = 0 ; bufferIndex < rbDegrees; bufferIndex += 8 ) //if circle is not round enough use ++ instead of 8
-	{
-		double angle = 2 * M_PI * bufferIndex / rbDegrees;
-		float x = static_cast<float>(originX + (radius * std::sin(angle)));
-		float y = static_cast<float>(originY - (radius * std::cos(angle)));
-
-		// Set Vertex data
-		circle.push_back(GenericVertexData(QVector4D( x, y, 0.0f, 1.0f ), QVector4D(1.0f ,0.0f , 0.0f, 1.0f)));
-
-		// Check if it is the last point
-	}
-	m_pfilledCircleData.push_back(circle);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn void CUserMapsRenderer::read( GLint x, GLint y, GLsizei width, GLsizei height,
-///							GLenum format, GLenum type, QOpenGLFunctions *func)
-///
-/// \brief	Reads colour data of the pixel.
-///
-/// \param	x - xAxis coordinate of the first pixel.
-///			y - yAxis coordinate of the first pixel.
-///			width - Width of the pixel rectangle, should be 1.
-///			height - Height of the pixel rectangle, should be 1.
-///			format - Format of the pixel data.
-///			type - Data type of the pixel data.
-///			func - Pointer that points to qopengl functions.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::read( GLint x, GLint y, GLsizei width, GLsizei height,
-								GLenum format, GLenum type, QOpenGLFunctions *func)
-{
-	func->glFlush();
-	func->glFinish();
-	func->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	unsigned char data[4] = { 0, 0, 0, 0 };
-
-	func->glReadPixels( x, y, width, height, format, type, data );
-	CLoggingLib::logging( E_DEBUGGING )<<endl<<"Colours of<<"<<x<<"and"<<y<<"are r:" <<data[0] << " g" <<data[1]<<" b" <<data[2] <<" a" << data[3];
-
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn QVector4D CUserMapsRenderer::convertColour(int colourKey, float opacity)
-///
-/// \brief  This function is used for converting colour into 4d vector.
-///
-/// \param	colourKey - Colour that should be converted.
-///			opacity - opacity.
-///
-/// \return	4D Qvector of converted colour.
-////////////////////////////////////////////////////////////////////////////////
-QVector4D CUserMapsRenderer::convertColour(int colourKey, float opacity)
-{
-	QColor colour = CUserMapColourManager::instance()->getColourByKey(colourKey);
-	return QVector4D(colour.red() / 255.0f, colour.green() / 255.0f, colour.blue() / 255.0f, opacity);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// \fn	void CUserMapsRenderer::setLineStyle(CUserMapsVertexData& tempData, EUserMapLineStyle lineStyle, float lineWidth)
-///
-/// \brief	This function is used for setting up linestyles.
-///
-/// \param	tempData - Data to be drawn.
-///			lineStyle - Enumerated lineStyle.
-///			lineWidth - Width of the line.
-////////////////////////////////////////////////////////////////////////////////
-void CUserMapsRenderer::setLineStyle(CUserMapsVertexData& tempData, EUserMapLineStyle lineStyle, float lineWidth)
-{
-	switch (lineStyle)
-	{
-	case EUserMapLineStyle::Solid :
-	{
-		tempData.setDashSize(30.0f);
-		tempData.setDotSize(0.0f);
-		tempData.setGapSize(0.0f);
-		break;
-	}
-	
-	case EUserMapLineStyle::Dashed :
-	{
-		tempData.setDashSize(15.0f);
-		tempData.setDotSize(0.0f);
-		tempData.setGapSize(15.0f);
-		break;
-	}
-	
-	case EUserMapLineStyle::Dotted :
-	{
-		tempData.setDashSize(2.0f);
-		tempData.setGapSize(10.0f);
-		tempData.setDotSize(0.0f);
-		break;
-	}
-	
-	case EUserMapLineStyle::Dot_Dash :
-	{
-		tempData.setDashSize(30.0f);
-		tempData.setGapSize(15.0f);
-		tempData.setDotSize(10.0f);
-		break;
-	}
-	}
-	tempData.setLineWidth(lineWidth);
-}
-
-
+////////////////////////////////////////////////////////////////////////////////
+///	\file   usermapsrenderer.cpp
+///
+///	\author Elreg
+///
+///	\brief	Implementation of the CUserMapsRenderer class which renders
+///			the user maps layer.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+
+#include "usermapsrenderer.h"
+#include <QDebug>
+#include <QOpenGLFramebufferObject>
+#include <QVector2D>
+#include "../OpenGLBaseLib/genericvertexdata.h"
+#include <QTextStream>
+#include "../UserMapsDataLib/usermapsmanager.h"
+#include "../LoggingLib/logginglib.h"
+#include "usermapslayer.h"
+
+
+#ifndef GL_PRIMITIVE_RESTART_FIXED_INDEX
+#define GL_PRIMITIVE_RESTART_FIXED_INDEX  0x8D69 ///<taken from opengl specifications
+#endif
+
+const bool LOG_OPENGL_ERRORS = false; ///< Used for open GL errors.
+static const int FONT_PT_SIZE = 20; ///< Font size.
+static const double CULL_MARGIN = 0.5; ///< Cull bounds reach this fraction of the view size beyond every edge.
+static const double CULL_SHRINK_RATIO = 16.0; ///< Cull bounds are renewed when they get this many times larger than the view.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsRenderer::CUserMapsRenderer()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsRenderer::CUserMapsRenderer()
+	: CBaseRenderer("UserMapsView", OGL_TYPE::PROJ_ORTHO),
+	  m_tgtTextRenderer(TextRendering::OPENGL),
+	  m_outlineBuf(sizeof(MapVertexData)),
+	  m_iconQuadBuf(QOpenGLBuffer::VertexBuffer),
+	  m_iconInstanceBuf(QOpenGLBuffer::VertexBuffer),
+	  m_isIconInstancesDirty(true),
+	  m_circleInstanceBuf(QOpenGLBuffer::VertexBuffer),
+	  m_isCircleInstancesDirty(true),
+	  m_pixelsInMm(0.0f),
+	  m_pOpenGLLogger(nullptr),
+	  m_pMapShader(nullptr),
+	  m_pIconShader(nullptr),
+	  m_pCircleShader(nullptr),
+	  m_pMapPickShader(nullptr),
+	  m_pIconPickShader(nullptr),
+	  m_pCirclePickShader(nullptr),
+	  m_postedSceneRevision(0),
+	  m_profiledFrames(0),
+	  out(stdout)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn CUserMapsRenderer::~CUserMapsRenderer()
+///
+/// \brief Destructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsRenderer::~CUserMapsRenderer()
+{
+	m_tgtTextRenderer.clearText();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CCUserMapsRenderer::render()
+///
+/// \brief	Called by the Qt framework to render shapes and text.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::render()
+{
+	// Timing report every few frames, if switched on by USERMAPS_PROFILE
+	CUserMapsProfiler *pProfiler = CUserMapsProfiler::Instance();
+	if ( pProfiler->isEnabled() && pProfiler->logInterval() > 0 && ++m_profiledFrames % pProfiler->logInterval() == 0 )
+		pProfiler->log();
+
+	CUserMapsScopedTimer timer(EUserMapsPhase::Render);
+
+	// Geometry published by the worker, uploaded when the buffers are bound
+	applySceneUpdates();
+
+	// Object under an earlier click and other reads the GPU has finished
+	takePickResult();
+	m_readback.deliver();
+
+	// Ids of removed objects may be reused once no earlier pick pass can return them
+	if ( !m_picker.isBusy() && !m_releasedPickIds.empty() )
+		m_geometryWorker.recyclePickIds(m_releasedPickIds);
+
+	framebufferObject()->bind();
+	QOpenGLFunctions* pFunctions = QOpenGLContext::currentContext()->functions();
+
+	// Clear the FBO to transparent black
+	pFunctions->glClearColor( 0, 0, 0, 0 );
+	pFunctions->glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT );
+
+	// Enable alpha blending
+	pFunctions->glEnable (GL_BLEND );
+
+	//enable fixed restart index so number of draw calls will be greatly reduced,and performance will be improved
+	pFunctions->glEnable ( GL_PRIMITIVE_RESTART_FIXED_INDEX);
+	pFunctions->glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );	// Set The Blending Function For Translucency
+
+	renderPrimitives( pFunctions );
+	renderTextures();
+
+	// Disable blending after use
+	pFunctions->glDisable( GL_BLEND );
+
+	// Ids around a click, drawn with the buffers just uploaded
+	renderPickPass();
+
+	// Reads of the frame just drawn
+	m_readback.capture();
+
+	framebufferObject()->release();
+
+	// The pick result and reads are delivered on a later frame
+	if ( ( m_picker.isBusy() || m_readback.isBusy() ) && !m_pItem.isNull() )
+		QMetaObject::invokeMethod(m_pItem.data(), "update", Qt::QueuedConnection);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CCUserMapsRenderer::initShader()
+///
+/// \brief	Called by the Qt framework to initialize map shader.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::initShader()
+{
+	if( m_pMapShader == nullptr )
+		m_pMapShader = QSharedPointer<CMapShaderProgram>(new CMapShaderProgram());
+
+	if( m_pIconShader == nullptr )
+		m_pIconShader = QSharedPointer<CIconShaderProgram>(new CIconShaderProgram());
+
+	if( m_pCircleShader == nullptr )
+		m_pCircleShader = QSharedPointer<CCircleShaderProgram>(new CCircleShaderProgram());
+
+	if( m_pMapPickShader == nullptr )
+		m_pMapPickShader = QSharedPointer<CMapShaderProgram>(new CMapShaderProgram(true));
+
+	if( m_pIconPickShader == nullptr )
+		m_pIconPickShader = QSharedPointer<CIconShaderProgram>(new CIconShaderProgram(true));
+
+	if( m_pCirclePickShader == nullptr )
+		m_pCirclePickShader = QSharedPointer<CCircleShaderProgram>(new CCircleShaderProgram(true));
+
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::synchronize(QQuickFramebufferObject *item)
+///
+/// \brief	Called by the Qt framework to synchronise data with the Layer. The GUI
+///			thread is blocked meanwhile, so geometry is not built here: the
+///			loaded maps are posted to the geometry worker if they may have
+///			changed and the updates it has published are taken over.
+///
+/// \param	item - UserMapslayer to synchronise with.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::synchronize(QQuickFramebufferObject *item)
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::Synchronize);
+
+	// Initialise OpenGL if needed
+	if(!m_bGLinit)
+	{
+		initializeGL();
+	}
+
+	// Ask for a new frame whenever the worker has published
+	if ( m_pItem.isNull() )
+	{
+		m_pItem = item;
+		QPointer<QQuickFramebufferObject> pItem(item);
+		m_geometryWorker.setPublishedCallback([pItem]()
+		{
+			if ( !pItem.isNull() )
+				QMetaObject::invokeMethod(pItem.data(), "update", Qt::QueuedConnection);
+		});
+	}
+
+	m_tgtTextRenderer.clearText();
+
+	m_pixelsInMm = static_cast<float>(CViewCoordinates::Instance()->getScreenMmToPixels());
+	if ( m_pixelsInMm == 0.0f )
+		return;
+
+	// Geometry is kept in world space, a view change only updates the matrix
+	if ( !m_projection.update() )
+		return;
+
+	CUserMapsLayer *pLayer = static_cast<CUserMapsLayer*>(item);
+
+	// Click to select an object at, drawn by the next pick pass
+	QPointF pickPosition;
+	if ( pLayer->takePickRequest(pickPosition) )
+		m_picker.request(pickPosition);
+
+	// Only objects added or edited since the last synchronisation are copied
+	UserMapsSceneSnapshot snapshot;
+	bool isSceneChanged = takeSnapshot(snapshot, pLayer);
+
+	// Objects are culled against a box around the view with a margin, so small
+	// pans and zooms reuse the draw lists of the previous cull bounds
+	qreal left = 0;
+	qreal right = 0;
+	qreal top = 0;
+	qreal bottom = 0;
+	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
+	UserMapsBounds view(m_projection.pixelToWorld(QRectF(QPointF(left, top), QPointF(right, bottom))));
+
+	const UserMapsBounds &postedCullBounds = m_postedSnapshot.m_cullBounds;
+	bool isViewChanged = ( m_postedSnapshot.m_projection.anchorRevision() != m_projection.anchorRevision() ||
+						   !postedCullBounds.contains(view) || postedCullBounds.area() > CULL_SHRINK_RATIO * view.area() );
+	if ( isViewChanged )
+	{
+		double margin = CULL_MARGIN * qMax(view.m_maxX - view.m_minX, view.m_maxY - view.m_minY);
+		snapshot.m_cullBounds = view.adjusted(margin);
+	}
+	else
+	{
+		snapshot.m_cullBounds = postedCullBounds;
+	}
+
+	// Lines and outlines are simplified as far as the tolerance allows at this range
+	snapshot.m_lodLevel = CUserMapsSimplifier::levelFor(m_projection.pixelsPerWorldUnit(), pLayer->simplifyTolerance());
+	isViewChanged = isViewChanged || snapshot.m_lodLevel != m_postedSnapshot.m_lodLevel;
+
+	// A view change within the cull bounds and level of detail posts nothing
+	if ( isSceneChanged || isViewChanged )
+	{
+		snapshot.m_isSceneChanged = isSceneChanged;
+		m_geometryWorker.post(snapshot);
+		m_postedSnapshot = snapshot;
+	}
+
+	m_geometryWorker.takeUpdates(m_takenUpdates);
+	m_sceneUpdates.insert(m_sceneUpdates.end(), m_takenUpdates.begin(), m_takenUpdates.end());
+
+	// Colours are resolved here, so a palette switch uploads only the palette
+	for (const QSharedPointer<UserMapsSceneUpdate> &pUpdate : m_takenUpdates)
+		m_palette.applyChanges(pUpdate->m_paletteChanges);
+	m_palette.refresh();
+	m_takenUpdates.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	bool CUserMapsRenderer::takeSnapshot(UserMapsSceneSnapshot &snapshot, CUserMapsLayer *pLayer)
+///
+/// \brief	Takes copies of the objects of all loaded maps. Called while the GUI
+///			thread is blocked; only objects added or reported edited by the
+///			layer since the last call are copied, the copies of the others
+///			are shared with the last snapshot.
+///
+/// \param	snapshot - Receives the loaded maps and the current world space.
+///			pLayer - Layer reporting the objects edited in place.
+///
+/// \return	True if objects have changed since the last posted snapshot.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsRenderer::takeSnapshot(UserMapsSceneSnapshot &snapshot, CUserMapsLayer *pLayer)
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::Snapshot);
+
+	snapshot.m_projection = m_projection;
+
+	pLayer->takeEditedObjects(m_editedObjects);
+	bool isSceneChanged = m_sceneSource.update(m_editedObjects);
+	m_editedObjects.clear();
+	snapshot.m_maps = m_sceneSource.maps();
+
+	// A new anchor or a change reported without an edited object rebuilds everything
+	uint sceneRevision = pLayer->sceneRevision();
+	isSceneChanged = isSceneChanged || sceneRevision != m_postedSceneRevision ||
+					 m_projection.anchorRevision() != m_postedSnapshot.m_projection.anchorRevision();
+	m_postedSceneRevision = sceneRevision;
+
+	return isSceneChanged;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::applySceneUpdates()
+///
+/// \brief	Applies the updates taken from the geometry worker, in publishing
+///			order, to the buffers and textures. Changed vertex ranges are
+///			written straight from the updates, changed rows of the textures
+///			when they are bound. Pick ids released by the updates are kept
+///			until render() can give them back. The applied updates go back
+///			to the worker for reuse.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::applySceneUpdates()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::SceneUpload);
+
+	for (const QSharedPointer<UserMapsSceneUpdate> &pUpdate : m_sceneUpdates)
+	{
+		m_outlineBuf.applyChanges(pUpdate->m_outlineChanges);
+		m_styleTable.applyChanges(pUpdate->m_styleChanges);
+		m_releasedPickIds.insert(m_releasedPickIds.end(), pUpdate->m_releasedPickIds.begin(),
+								 pUpdate->m_releasedPickIds.end());
+
+		if ( pUpdate->m_isDrawListChanged )
+		{
+			m_outlineIndices.swapIndices(pUpdate->m_outlineIndices);
+			m_filledPolygonIndices.swapIndices(pUpdate->m_filledPolygonIndices);
+			m_circleInstances.swap(pUpdate->m_circleInstances);
+			m_isCircleInstancesDirty = true;
+		}
+
+		if ( pUpdate->m_isIconInstancesChanged )
+		{
+			m_iconInstances.swap(pUpdate->m_iconInstances);
+			m_isIconInstancesDirty = true;
+		}
+
+		if ( !pUpdate->m_iconAtlas.isNull() )
+			m_iconAtlas.setImage(pUpdate->m_iconAtlas);
+
+		m_geometryProjection = pUpdate->m_projection;
+	}
+
+	m_geometryWorker.recycleUpdates(m_sceneUpdates);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::renderPickPass()
+///
+/// \brief	Draws the pick id of every object around a clicked position into
+///			the id buffer of the picker, in the order of render(), so the
+///			object drawn on top wins. Only the few pixels around the click are
+///			drawn, and the ids are read back on a later frame.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::renderPickPass()
+{
+	QRectF window;
+	if ( !m_picker.beginPass(window) )
+		return;
+
+	CUserMapsScopedTimer timer(EUserMapsPhase::PickPass);
+
+	QOpenGLExtraFunctions* func = QOpenGLContext::currentContext()->extraFunctions();
+
+	// The window around the click fills the id buffer
+	QMatrix4x4 projection;
+	setProjection( window.left(), window.right(), window.bottom(), window.top(), projection );
+	QMatrix4x4 worldToPixel = m_projection.worldToPixel(m_geometryProjection);
+
+	initShader();
+
+	// Areas, pick ids from the style table
+	if ( m_filledPolygonIndices.indexCount() > 0 )
+	{
+		m_pMapPickShader->bind();
+		m_pMapPickShader->setMVPMatrix(projection * worldToPixel);
+		m_styleTable.bind(0);
+		m_pMapPickShader->setStyleTableSampler(0);
+		m_pMapPickShader->setFillMode(true);
+
+		m_outlineBuf.bind();
+		m_filledPolygonIndices.bind();
+		m_pMapPickShader->setupVertexState();
+		func->glDrawElements(GL_TRIANGLES, m_filledPolygonIndices.indexCount(), GL_UNSIGNED_INT, nullptr);
+		m_pMapPickShader->cleanupVertexState();
+
+		m_filledPolygonIndices.release();
+		m_outlineBuf.release();
+		m_styleTable.release(0);
+		m_pMapPickShader->release();
+	}
+
+	// Circles, inside and on the outline
+	if ( !m_circleInstances.empty() && m_circleInstanceBuf.isCreated() && !m_isCircleInstancesDirty )
+	{
+		m_pCirclePickShader->bind();
+		m_pCirclePickShader->setMVPMatrix(projection);
+		m_pCirclePickShader->setWorldToPixel(worldToPixel);
+		m_pCirclePickShader->setPixelsPerWorldUnit(static_cast<float>(m_projection.pixelsPerWorldUnit()));
+
+		m_iconQuadBuf.bind();
+		m_pCirclePickShader->setupVertexState();
+		m_circleInstanceBuf.bind();
+		m_pCirclePickShader->setupInstanceState(func);
+		func->glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_circleInstances.size()));
+		m_pCirclePickShader->cleanupVertexState(func);
+
+		m_circleInstanceBuf.release();
+		m_pCirclePickShader->release();
+	}
+
+	// Lines and outlines, dashes included
+	if ( m_outlineIndices.indexCount() > 0 )
+	{
+		m_pMapPickShader->bind();
+		m_pMapPickShader->setMVPMatrix(projection * worldToPixel);
+		m_styleTable.bind(0);
+		m_pMapPickShader->setStyleTableSampler(0);
+		m_pMapPickShader->setFillMode(false);
+
+		m_outlineBuf.bind();
+		m_outlineIndices.bind();
+		m_pMapPickShader->setupVertexState();
+		func->glDrawElements(GL_LINE_STRIP, m_outlineIndices.indexCount(), GL_UNSIGNED_INT, nullptr);
+		m_pMapPickShader->cleanupVertexState();
+
+		m_outlineIndices.release();
+		m_outlineBuf.release();
+		m_styleTable.release(0);
+		m_pMapPickShader->release();
+	}
+
+	// Point icons, the whole icon square
+	if ( !m_iconInstances.empty() && m_iconInstanceBuf.isCreated() && !m_isIconInstancesDirty )
+	{
+		m_pIconPickShader->bind();
+		m_pIconPickShader->setMVPMatrix(projection);
+		m_pIconPickShader->setWorldToPixel(worldToPixel);
+		m_pIconPickShader->setPixelsPerMm(m_pixelsInMm);
+
+		m_iconQuadBuf.bind();
+		m_pIconPickShader->setupVertexState();
+		m_iconInstanceBuf.bind();
+		m_pIconPickShader->setupInstanceState(func);
+		func->glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_iconInstances.size()));
+		m_pIconPickShader->cleanupVertexState(func);
+
+		m_iconInstanceBuf.release();
+		m_pIconPickShader->release();
+	}
+
+	m_picker.endPass();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::takePickResult()
+///
+/// \brief	Takes the id found by the last pick pass, if the GPU has finished
+///			reading it, and passes the object it stands for to the layer to be
+///			selected. A click beside every object selects nothing.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::takePickResult()
+{
+	quint32 pickId = 0;
+	if ( !m_picker.takeResult(pickId) )
+		return;
+
+	UserMapsPickTarget target;
+	if ( m_pItem.isNull() || !m_geometryWorker.resolvePick(pickId, target) )
+		return;
+
+	// Selection changes objects of the manager, so it is done on the GUI thread
+	QMetaObject::invokeMethod(m_pItem.data(), "selectPickedObject", Qt::QueuedConnection,
+							  Q_ARG(QString, target.m_mapName), Q_ARG(int, static_cast<int>(target.m_type)),
+							  Q_ARG(int, target.m_objectId));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::initializeGL()
+///
+/// \brief	Initialise OpenGL for this renderer.
+///			Includes creating the image textures;
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::initializeGL()
+{
+	QOpenGLFunctions* func = QOpenGLContext::currentContext()->functions();
+	func->initializeOpenGLFunctions();
+
+	func->glClearColor(0, 0, 0, 0);
+	func->glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+	if( m_pOpenGLLogger == nullptr )
+	{
+		QOpenGLContext *pContext = QOpenGLContext::currentContext();
+		if( pContext != nullptr )
+		{
+			if( LOG_OPENGL_ERRORS )
+			{
+				if( pContext->hasExtension(QByteArrayLiteral("GL_KHR_debug")) )
+				{
+					m_pOpenGLLogger = new QOpenGLDebugLogger();
+					bool bOk = m_pOpenGLLogger->initialize();
+					if ( bOk )
+						qDebug() << "\nCUserMapsRenderer OpenGL debug logging initialized";
+					else
+						qDebug() << "\nCUserMapsRenderer OpenGL debug logging initialization failed";
+				}
+			}
+		}
+	}
+
+	// Initialise the string renderer
+	QOpenGLFunctions* openGL = QOpenGLContext::currentContext()->functions();
+
+	if( openGL->glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE )
+	{
+		m_tgtTextRenderer.init( framebufferObject(), &m_textureShader );
+
+		// Get the view dimensions
+		qreal left = 0;
+		qreal right = 0;
+		qreal top = 0;
+		qreal bottom = 0;
+		CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
+		m_tgtTextRenderer.setScreenGeometry( QRect( static_cast<int> ( left ),
+													static_cast<int> ( top ),
+													static_cast<int> ( right ),
+													static_cast<int> ( bottom ) ) );
+
+	}
+	// Quad every icon and circle is drawn on, corners in -1..1
+	if ( !m_iconQuadBuf.isCreated() && m_iconQuadBuf.create() )
+	{
+		const QVector2D corners[4] = { QVector2D(-1.0f, -1.0f), QVector2D(1.0f, -1.0f),
+									   QVector2D(-1.0f, 1.0f), QVector2D(1.0f, 1.0f) };
+		m_iconQuadBuf.bind();
+		m_iconQuadBuf.allocate(corners, sizeof(corners));
+		m_iconQuadBuf.release();
+	}
+
+	m_bGLinit = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::renderPrimitives( QOpenGLFunctions* func )
+///
+/// \brief	Render shapes.
+///
+/// \param	func - The QOpenGLFunctions to use if needed.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::renderPrimitives(QOpenGLFunctions *func)
+{
+
+	drawfilledPolygons(func);
+	drawCircles();
+	drawOutlines(func);
+
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::renderTextures()
+///
+/// \brief	Render the textures and text.
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::renderTextures()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::Textures);
+
+	if ( !m_iconInstances.empty() && m_iconQuadBuf.isCreated() && m_iconAtlas.bind(0) )
+	{
+		QOpenGLExtraFunctions* func = QOpenGLContext::currentContext()->extraFunctions();
+
+		// Upload per point data only when points have changed
+		if ( m_isIconInstancesDirty )
+		{
+			if ( !m_iconInstanceBuf.isCreated() )
+			{
+				m_iconInstanceBuf.create();
+				m_iconInstanceBuf.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+			}
+			m_iconInstanceBuf.bind();
+			m_iconInstanceBuf.allocate(m_iconInstances.data(), static_cast<int>(m_iconInstances.size() * sizeof(IconInstanceData)));
+			m_iconInstanceBuf.release();
+			m_isIconInstancesDirty = false;
+		}
+
+		// Set projection matrix
+		QMatrix4x4 projection;
+		qreal left = 0;
+		qreal right = 0;
+		qreal top = 0;
+		qreal bottom = 0;
+		CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
+		setProjection( left, right, bottom, top, projection );
+
+		initShader();
+		m_pIconShader->bind();
+
+		// Icons are placed and sized in the vertex shader
+		m_pIconShader->setMVPMatrix(projection);
+		m_pIconShader->setWorldToPixel(m_projection.worldToPixel(m_geometryProjection));
+		m_pIconShader->setPixelsPerMm(m_pixelsInMm);
+
+		// Use texture unit 0 for the sampler, 1 for the palette
+		m_pIconShader->setTextureSampler(0);
+		m_palette.bind(1);
+		m_pIconShader->setPaletteSampler(1);
+
+		m_iconQuadBuf.bind();
+		m_pIconShader->setupVertexState();
+		m_iconInstanceBuf.bind();
+		m_pIconShader->setupInstanceState(func);
+
+		// Draw all icons at once
+		func->glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_iconInstances.size()));
+
+		// Tidy up
+		m_pIconShader->cleanupVertexState(func);
+		m_iconInstanceBuf.release();
+		m_palette.release(1);
+		m_iconAtlas.release();
+		m_pIconShader->release();
+	}
+
+	m_textureShader.bind();
+	m_tgtTextRenderer.renderText();
+	m_textureShader.release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::drawOutlines(QOpenGLFunctions *func)
+///
+/// \brief	Draws lines and the outlines of polygons. The line style
+///			of every object is read from the style table, so all outlines are
+///			drawn with one call.
+///
+/// \param  func - Pointer that points to QOpenGLFunctions.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::drawOutlines(QOpenGLFunctions *func)
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::Outlines);
+
+	if ( m_outlineIndices.indexCount() == 0 )
+		return;
+
+	// World space to view pixels (pan, offset and range)
+	QMatrix4x4 translation = m_projection.worldToPixel(m_geometryProjection);
+
+	// Set projection matrix
+	QMatrix4x4 projection;
+	qreal left = 0;
+	qreal right = 0;
+	qreal top = 0;
+	qreal bottom = 0;
+	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
+	setProjection( left, right, bottom, top, projection );
+
+	initShader();
+
+	// Bind the shader
+	m_pMapShader->bind();
+
+	// Set the projection and translation
+	m_pMapShader->setMVPMatrix(projection * translation);
+
+	GLfloat winWidth = static_cast<float>(right-left);
+	GLfloat winHeight = static_cast<float>(bottom-top);
+
+	m_pMapShader->setResolution(winWidth, winHeight);
+
+	// Use texture unit 0 for the style table, 1 for the palette
+	m_styleTable.bind(0);
+	m_pMapShader->setStyleTableSampler(0);
+	m_palette.bind(1);
+	m_pMapShader->setPaletteSampler(1);
+	m_pMapShader->setFillMode(false);
+
+	m_outlineBuf.bind();
+	m_outlineIndices.bind();
+
+	// Check Frame buffer is OK
+	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if( e != GL_FRAMEBUFFER_COMPLETE)
+		qDebug() << "CUserMapsRenderer::drawOutlines() failed! Not GL_FRAMEBUFFER_COMPLETE";
+
+	m_pMapShader->setupVertexState();
+
+	func->glLineWidth(1);
+
+	// Strips of all objects and styles, separated by restart indices
+	func->glDrawElements(GL_LINE_STRIP, m_outlineIndices.indexCount(), GL_UNSIGNED_INT, nullptr);
+
+	// Tidy up
+	m_pMapShader->cleanupVertexState();
+
+	m_outlineIndices.release();
+	m_outlineBuf.release();
+	m_palette.release(1);
+	m_styleTable.release(0);
+
+	m_pMapShader->release();
+
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn	void CUserMapsRenderer::drawfilledPolygons(QOpenGLFunctions *func)
+///
+/// \brief  Draws polygons.
+///
+/// \param  func - Pointer that points to QOpenGLFunctions.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::drawfilledPolygons(QOpenGLFunctions *func)
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::FilledPolygons);
+
+	if ( m_filledPolygonIndices.indexCount() == 0 )
+		return;
+
+	// World space to view pixels (pan, offset and range)
+	QMatrix4x4 translation = m_projection.worldToPixel(m_geometryProjection);
+
+	// Set projection matrix
+	QMatrix4x4 projection;
+	qreal left = 0;
+	qreal right = 0;
+	qreal top = 0;
+	qreal bottom = 0;
+	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top );
+	setProjection( left, right, bottom, top, projection );
+
+	initShader();
+
+	// Bind the shader
+	m_pMapShader->bind();
+
+	// Set the projection and translation
+	m_pMapShader->setMVPMatrix(projection * translation);
+
+	GLfloat winWidth = static_cast<float>(right-left);
+	GLfloat winHeight = static_cast<float>(bottom-top);
+
+	m_pMapShader->setResolution(winWidth, winHeight);
+
+	// Fill colours come from the style table (texture unit 0) and palette (unit 1)
+	m_styleTable.bind(0);
+	m_pMapShader->setStyleTableSampler(0);
+	m_palette.bind(1);
+	m_pMapShader->setPaletteSampler(1);
+	m_pMapShader->setFillMode(true);
+
+	// Triangles index the outline vertices of the areas
+	m_outlineBuf.bind();
+	m_filledPolygonIndices.bind();
+
+	// Check Frame buffer is OK
+	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if( e != GL_FRAMEBUFFER_COMPLETE)
+		qDebug() << "CUserMapsRenderer::drawfilledPolygons() failed! Not GL_FRAMEBUFFER_COMPLETE";
+
+	m_pMapShader->setupVertexState();
+
+	//draw
+	func->glDrawElements(GL_TRIANGLES, m_filledPolygonIndices.indexCount(), GL_UNSIGNED_INT, nullptr);
+
+	// Tidy up
+	m_pMapShader->cleanupVertexState();
+
+	m_filledPolygonIndices.release();
+	m_outlineBuf.release();
+	m_palette.release(1);
+	m_styleTable.release(0);
+
+	m_pMapShader->release();
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn void CUserMapsRenderer::drawCircles()
+///
+/// \brief  Draws circles, inline and outline, as one instanced quad each. The
+///         circle shader places the quads and evaluates fill and dashes per
+///         pixel, so circles stay round at any range.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::drawCircles()
+{
+	CUserMapsScopedTimer timer(EUserMapsPhase::Circles);
+
+	if ( m_circleInstances.empty() || !m_iconQuadBuf.isCreated() )
+		return;
+
+	QOpenGLExtraFunctions* func = QOpenGLContext::currentContext()->extraFunctions();
+
+	// Upload per circle data only when the draw lists have changed
+	if ( m_isCircleInstancesDirty )
+	{
+		if ( !m_circleInstanceBuf.isCreated() )
+		{
+			m_circleInstanceBuf.create();
+			m_circleInstanceBuf.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+		}
+		m_circleInstanceBuf.bind();
+		m_circleInstanceBuf.allocate(m_circleInstances.data(), static_cast<int>(m_circleInstances.size() * sizeof(CircleInstanceData)));
+		m_circleInstanceBuf.release();
+		m_isCircleInstancesDirty = false;
+	}
+
+	// Set projection matrix
+	QMatrix4x4 projection;
+	qreal left = 0;
+	qreal right = 0;
+	qreal top = 0;
+	qreal bottom = 0;
+	CViewCoordinates::Instance()->getViewDimensions( left, right, bottom, top);
+	setProjection( left, right, bottom, top, projection );
+
+	initShader();
+	m_pCircleShader->bind();
+
+	// Circles are placed and sized in the vertex shader
+	m_pCircleShader->setMVPMatrix(projection);
+	m_pCircleShader->setWorldToPixel(m_projection.worldToPixel(m_geometryProjection));
+	m_pCircleShader->setPixelsPerWorldUnit(static_cast<float>(m_projection.pixelsPerWorldUnit()));
+
+	// Colours are looked up in the palette (texture unit 0)
+	m_palette.bind(0);
+	m_pCircleShader->setPaletteSampler(0);
+
+	// Check Frame buffer is OK
+	GLenum e = func->glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if( e != GL_FRAMEBUFFER_COMPLETE)
+		qDebug() << "CUserMapsRenderer::drawCircles() failed! Not GL_FRAMEBUFFER_COMPLETE";
+
+	m_iconQuadBuf.bind();
+	m_pCircleShader->setupVertexState();
+	m_circleInstanceBuf.bind();
+	m_pCircleShader->setupInstanceState(func);
+
+	// Draw all circles at once
+	func->glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(m_circleInstances.size()));
+
+	// Tidy up
+	m_pCircleShader->cleanupVertexState(func);
+	m_circleInstanceBuf.release();
+	m_palette.release(0);
+	m_pCircleShader->release();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn void CUserMapsRenderer::logOpenGLErrors()
+///
+/// \brief  OpenGL logger.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::logOpenGLErrors()
+{
+	if( m_pOpenGLLogger )
+	{
+		const QList<QOpenGLDebugMessage> messages = m_pOpenGLLogger->loggedMessages();
+		for (const QOpenGLDebugMessage &message : messages)
+		{
+			//if( message.severity() == QOpenGLDebugMessage::HighSeverity || message.severity() == QOpenGLDebugMessage::MediumSeverity )
+			qDebug() << "CUserMapsRenderer:" << message;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn void CUserMapsRenderer::addText( QString text, double x, double y, QVector4D colour,
+///																TextAlignment alignment)
+///
+/// \brief	This function is used for writing text.
+///
+/// \param  text - Text to be written.
+///			x - xAxis position of text.
+///			y - yAxis position of text.
+///			colour - Colour of the text.
+///			alignment - Specifies text alignment.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::addText( QString text,double x, double y, QVector4D colour,
+												TextAlignment alignment)
+{
+	m_tgtTextRenderer.addText( text, static_cast<int> (x ), static_cast<int> ( y ), FONT_PT_SIZE, colour, alignment );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn void CUserMapsRenderer::read( const QRect &rect, GLenum format, GLenum type,
+///							const CUserMapsReadback::Callback &callback )
+///
+/// \brief	Asks for a rectangle of the layer to be read after the next frame
+///			is drawn. The GPU is not waited for: the callback gets the pixels
+///			on the render thread a frame or more later. Called on the render
+///			thread, e.g. from a read callback or synchronize().
+///
+/// \param	rect - Rectangle in framebuffer pixels from the bottom left.
+///			format - Format of the pixel data, GL_RGBA for colours.
+///			type - Data type of the pixel data, GL_UNSIGNED_BYTE for colours.
+///			callback - Receives the pixels.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsRenderer::read( const QRect &rect, GLenum format, GLenum type,
+								const CUserMapsReadback::Callback &callback )
+{
+	m_readback.request( rect, format, type, callback );
+
+	if ( !m_pItem.isNull() )
+		QMetaObject::invokeMethod(m_pItem.data(), "update", Qt::QueuedConnection);
+}
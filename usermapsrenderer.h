@@ -1,151 +1,157 @@
-////////////////////////////////////////////////////////////////////////////////
-///	\file   usermapsrenderer.h
-///
-///	\author Elreg
-///
-///	\brief	Declaration of the CUserMapsRenderer class which renders
-///			the user maps layer.
-///
-///	(C) Kelvin Hughes, 2019.
-////////////////////////////////////////////////////////////////////////////////
-
-#ifndef CUSERMAPSRENDERER_H
-#define CUSERMAPSRENDERER_H
-
-#include "baserenderer.h"
-#include <QOpenGLBuffer>
-#include <QOpenGLDebugLogger>
-#include "../OpenGLBaseLib/imagetexture.h"
-#include "../OpenGLBaseLib/vertexbuffer.h"
-#include "mapshaderprogram.h"
-#include "triangulate.h"
-#include "usermapsvertexdata.h"
-#include <vector>
-#include "../UserMapsDataLib/usermap.h"
-#include "../UserMapsDataLib/UserMapObjects/usermappoint.h"
-#include "../UserMapsDataLib/UserMapObjects/usermaparea.h"
-#include "../UserMapsDataLib/UserMapObjects/usermapcircle.h"
-#include "../UserMapsDataLib/UserMapObjects/usermapline.h"
-#include "../UserMapsDataLib/UserMapObjects/usermapobject.h"
-#include "../UserMapsDataLib/usermaplinestyle.h"
-#include "../ShipDataLib/shipdata.h"
-#include "../LayerLib/viewcoordinates.h"
-#include "../LayerLib/corelayer.h"
-
-////////////////////////////////////////////////////////////////////////////////
-///
-///  \brief	This class is used for saving received texture data
-///
-////////////////////////////////////////////////////////////////////////////////
-struct MapPoint
-{
-	MapPoint();
-	GenericVertexData m_vertexData;		///< Position and colour of the point
-	float m_iconSize;			    ///< Size of an icon.
-	int m_icon;
-};
-
-
-////////////////////////////////////////////////////////////////////////////////
-///
-///  \brief	This class implements CUserMapsRenderer class which renders targets
-///
-////////////////////////////////////////////////////////////////////////////////
-class CUserMapsRenderer : public CBaseRenderer, public QObject
-{
-public:
-	CUserMapsRenderer();
-	~CUserMapsRenderer();
-
-	void render() override;
-	void synchronize( QQuickFramebufferObject* item ) override;
-	void initializeGL() override;
-	virtual void renderPrimitives( QOpenGLFunctions* func ) override;
-	virtual void renderTextures() override;
-	// Updates
-	void updateLines( const QMap<int, QSharedPointer<CUserMapLine> >& loadedLines);
-	void updateLine( const QSharedPointer<CUserMapLine> & it);
-	void updateCircles( const QMap<int, QSharedPointer<CUserMapCircle> >& loadedCircles);
-	void updateCircle( const QSharedPointer<CUserMapCircle>& it, std::vector<GenericVertexData>& circle);
-	void fillCircle( const std::vector<GenericVertexData>& circle, QVector4D colour);
-	void updatePolygons( const QMap<int, QSharedPointer<CUserMapArea> >& loadedAreas);
-	void updatePolygon( const QSharedPointer<CUserMapArea>& it,  std::vector<GenericVertexData>& polygon);
-	void fillPolygon( const std::vector<GenericVertexData>& polygon, QVector4D colour);
-	void updatePointsData( const QMap<int, QSharedPointer<CUserMapPoint> > &uPointData);
-	void updatePointData( const QSharedPointer<CUserMapPoint>& it);
-
-	// Draws
-	void drawPoints( QOpenGLFunctions* func );
-	void drawLines( QOpenGLFunctions* func );
-	void drawCircles( QOpenGLFunctions* func );
-	void drawfilledCircles(QOpenGLFunctions* func );
-	void drawPolygons( QOpenGLFunctions* func );
-	void drawfilledPolygons( QOpenGLFunctions* func );
-	void initShader();
-	void addText( QString text, double x, double y, QVector4D colour, TextAlignment alignment);
-	void loadMaps();
-
-private:
-	QVector4D m_PointColour;					///< Point colour.
-	QVector4D m_LineColour;					    ///< Line colour.
-	QVector4D m_CircleColour;					///< Circle colour.
-	QVector4D m_PolygonColour;					///< Polygon colour.
-	QVector4D m_TextColour;					    ///< Text colour.
-	CStringRenderer	m_tgtTextRenderer;	    	///< Used for rendering text.
-	QSharedPointer<CVertexBuffer> m_PointBuf;	///< OpenGL vertex buffer (vertices and colour) to draw points.
-	std::vector<QSharedPointer<CImageTexture>> m_pTexture;  ///< image used as a textures.
-
-	// Lines buffer
-	QSharedPointer<CVertexBuffer> m_LineBuf;	///< VBO used to draw Lines.
-
-	// Circle buffer
-	QSharedPointer<CVertexBuffer> m_CircleBuf;  ///< OpenGL vertex buffer (vertices and colour) to draw circles.
-
-	// Circle buffer
-	QSharedPointer<CVertexBuffer> m_InlineCircleBuf;  ///< OpenGL vertex buffer (vertices and colour) to draw filled circle.
-
-	// Polygon buffer
-	QSharedPointer<CVertexBuffer> m_PolygonBuf;  ///< OpenGL vertex buffer (vertices and colour) to draw polygons.
-
-	// Filled polygon buffer
-	QSharedPointer<CVertexBuffer> m_filledPolygonBuf;  ///< OpenGL vertex buffer (vertices and colour) to draw filled polygons.
-
-	QOpenGLDebugLogger *m_pOpenGLLogger;	///< OpenGL error logger.
-
-	QSharedPointer<CMapShaderProgram> m_pMapShader;	///< Shader.
-
-	std::vector<CUserMapsVertexData> m_pLineData; ///< Vector where all lines are stored.
-
-	std::vector<GenericVertexData> m_pPointData; ///< Vector where all points are stored.
-
-	std::vector<CUserMapsVertexData> m_pPolygonData; ///< Vector where all polygons and their points are stored.
-
-	std::vector<CUserMapsVertexData> m_pCircleData;	///< Vector where circles and their points are stored.
-
-	std::vector<std::vector<GenericVertexData>> m_pfilledCircleData;	///< Vector where circles and their points with inline colour are stored.
-
-	std::vector<std::vector<GenericVertexData>> m_pfilledPolygonData;	///< Vector where polygons and their points with inline colour are stored.
-
-	std::vector<MapPoint> m_pPoints;			///< Vector whose elements are lists of point objects contained in the map.
-
-	void logOpenGLErrors();
-
-	void addPointstoBuffer();
-
-	void drawMultipleLines();
-
-	int drawMultipleElements( QSharedPointer<CVertexBuffer> &buffer, const std::vector<std::vector<GenericVertexData>> &data);
-	int drawMultipleElements( QSharedPointer<CVertexBuffer> &buffer, const std::vector<CUserMapsVertexData> &data);
-
-	void testCircle( qreal originX, qreal originY);
-
-	void read( GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, QOpenGLFunctions *func);
-	QVector4D convertColour( int colourKey, float opacity = 1.0f);
-
-	void setLineStyle( CUserMapsVertexData& tempData, EUserMapLineStyle lineStyle, float lineWidth);
-
-	QTextStream out;
-
-};
-
-#endif // CUSERMAPSRENDERER_H
+////////////////////////////////////////////////////////////////////////////////
+///	\file   usermapsrenderer.h
+///
+///	\author Elreg
+///
+///	\brief	Declaration of the CUserMapsRenderer class which renders
+///			the user maps layer.
+///
+///	(C) Kelvin Hughes, 2019.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef CUSERMAPSRENDERER_H
+#define CUSERMAPSRENDERER_H
+
+#include "baserenderer.h"
+#include <QOpenGLBuffer>
+#include <QOpenGLDebugLogger>
+#include "../OpenGLBaseLib/imagetexture.h"
+#include "../OpenGLBaseLib/vertexbuffer.h"
+#include <QPointer>
+#include "mapshaderprogram.h"
+#include "usermapsvertexdata.h"
+#include "usermapsvertexpool.h"
+#include "usermapsindexbuffer.h"
+#include "usermapsstyletable.h"
+#include "usermapspalette.h"
+#include "usermapsprojection.h"
+#include "usermapsiconatlas.h"
+#include "usermapsgeometryworker.h"
+#include "usermapsscenesource.h"
+#include "usermapspicker.h"
+#include "usermapsreadback.h"
+#include "usermapsprofiler.h"
+#include "iconshaderprogram.h"
+#include "circleshaderprogram.h"
+#include <vector>
+#include "../UserMapsDataLib/usermap.h"
+#include "../UserMapsDataLib/UserMapObjects/usermappoint.h"
+#include "../UserMapsDataLib/UserMapObjects/usermaparea.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapcircle.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapline.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapobject.h"
+#include "../UserMapsDataLib/usermaplinestyle.h"
+#include "../ShipDataLib/shipdata.h"
+#include "../LayerLib/viewcoordinates.h"
+#include "../LayerLib/corelayer.h"
+
+class CUserMapsLayer;
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///  \brief	This class implements CUserMapsRenderer class which renders targets
+///
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsRenderer : public CBaseRenderer, public QObject
+{
+public:
+	CUserMapsRenderer();
+	~CUserMapsRenderer();
+
+	void render() override;
+	void synchronize( QQuickFramebufferObject* item ) override;
+	void initializeGL() override;
+	virtual void renderPrimitives( QOpenGLFunctions* func ) override;
+	virtual void renderTextures() override;
+	// Draws
+	void drawOutlines( QOpenGLFunctions* func );
+	void drawCircles();
+	void drawfilledPolygons( QOpenGLFunctions* func );
+	void initShader();
+	void addText( QString text, double x, double y, QVector4D colour, TextAlignment alignment);
+	void loadMaps();
+	void read( const QRect &rect, GLenum format, GLenum type, const CUserMapsReadback::Callback &callback );
+
+private:
+	QVector4D m_PointColour;					///< Point colour.
+	QVector4D m_LineColour;					    ///< Line colour.
+	QVector4D m_CircleColour;					///< Circle colour.
+	QVector4D m_PolygonColour;					///< Polygon colour.
+	QVector4D m_TextColour;					    ///< Text colour.
+	CStringRenderer	m_tgtTextRenderer;	    	///< Used for rendering text.
+	CUserMapsIconAtlas m_iconAtlas;	///< Icons of all points in one texture.
+	QOpenGLBuffer m_iconQuadBuf;	///< Corners of the quad an icon or circle is drawn on.
+	QOpenGLBuffer m_iconInstanceBuf;	///< Per point data of the drawn icons.
+	std::vector<IconInstanceData> m_iconInstances;	///< Content of the icon instance buffer.
+	bool m_isIconInstancesDirty;	///< True if the icon instance buffer has to be uploaded.
+	float m_pixelsInMm;				///< Screen pixels per millimetre, used to size icons.
+	QOpenGLBuffer m_circleInstanceBuf;	///< Per circle data of the drawn circles.
+	std::vector<CircleInstanceData> m_circleInstances;	///< Content of the circle instance buffer.
+	bool m_isCircleInstancesDirty;	///< True if the circle instance buffer has to be uploaded.
+
+	// Outline buffer
+	CUserMapsVertexPool m_outlineBuf;	///< OpenGL vertex buffer (positions and style table slots) to draw lines and outlines of polygons.
+
+	QOpenGLDebugLogger *m_pOpenGLLogger;	///< OpenGL error logger.
+
+	QSharedPointer<CMapShaderProgram> m_pMapShader;	///< Shader.
+
+	QSharedPointer<CIconShaderProgram> m_pIconShader;	///< Shader used to draw point icons.
+
+	QSharedPointer<CCircleShaderProgram> m_pCircleShader;	///< Shader used to draw circles.
+
+	QSharedPointer<CMapShaderProgram> m_pMapPickShader;	///< Shader drawing the pick ids of lines and areas.
+
+	QSharedPointer<CIconShaderProgram> m_pIconPickShader;	///< Shader drawing the pick ids of points.
+
+	QSharedPointer<CCircleShaderProgram> m_pCirclePickShader;	///< Shader drawing the pick ids of circles.
+
+	CUserMapsPicker m_picker;				///< Id buffer finding the object at a clicked position.
+
+	CUserMapsReadback m_readback;			///< Reads of the layer framebuffer, captured after drawing.
+
+	CUserMapsIndexBuffer m_outlineIndices;		///< Strips of all lines and outlines, in draw order.
+
+	CUserMapsStyleTable m_styleTable;			///< Line style and palette indices of every object, read by the map shader.
+
+	CUserMapsPalette m_palette;					///< Colour of every colour key in use, read by all shaders.
+
+	CUserMapsIndexBuffer m_filledPolygonIndices;	///< Triangles of all filled polygons, indexing the outline vertices.
+
+	CUserMapsProjection m_projection;		///< View transformation, calibrated every synchronisation.
+
+	CUserMapsProjection m_geometryProjection;	///< World space of the geometry in the buffers.
+
+	UserMapsSceneSnapshot m_postedSnapshot;	///< Snapshot last posted to the geometry worker.
+
+	CUserMapsSceneSource m_sceneSource;		///< Copies of the loaded objects, read by the geometry worker.
+
+	QSet<const void *> m_editedObjects;		///< Objects the layer has reported edited, taken every synchronisation.
+
+	uint m_postedSceneRevision;				///< Scene revision of the layer when the last snapshot was posted.
+
+	int m_profiledFrames;					///< Frames rendered while profiling, to log the timings every few.
+
+	std::vector<QSharedPointer<UserMapsSceneUpdate> > m_sceneUpdates;	///< Updates taken from the worker, applied on next render.
+	std::vector<QSharedPointer<UserMapsSceneUpdate> > m_takenUpdates;	///< Swapped with the published list of the worker, so neither allocates.
+	std::vector<quint32> m_releasedPickIds;	///< Pick ids of removed objects, given back once no pick pass drawn with them is in flight.
+
+	QPointer<QQuickFramebufferObject> m_pItem;	///< Layer, asked for a new frame when the worker has published.
+
+	CUserMapsGeometryWorker m_geometryWorker;	///< Thread building the geometry, stopped before the buffers are destroyed.
+
+	void logOpenGLErrors();
+
+	bool takeSnapshot( UserMapsSceneSnapshot &snapshot, CUserMapsLayer *pLayer);
+	void applySceneUpdates();
+
+	void renderPickPass();
+	void takePickResult();
+
+	void drawMultipleLines();
+
+	QTextStream out;
+
+};
+
+#endif // CUSERMAPSRENDERER_H
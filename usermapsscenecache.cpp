@@ -0,0 +1,356 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsscenecache.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsSceneCache class which keeps the
+///			geometry of every user map object between synchronisations.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsscenecache.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     static uint hashCombine(uint seed, uint value)
+///
+/// \brief  Mixes a hash value into a running hash.
+///
+/// \param  seed - Running hash.
+///         value - Hash value to be mixed in.
+///
+/// \return Updated hash.
+////////////////////////////////////////////////////////////////////////////////
+static uint hashCombine(uint seed, uint value)
+{
+	return seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsObjectKey::UserMapsObjectKey(const void *pObject, bool isSelected)
+///
+/// \brief  Constructor.
+///
+/// \param  pObject - Address of the user map object.
+///         isSelected - True for the copy drawn as the selected object.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsObjectKey::UserMapsObjectKey(const void *pObject, bool isSelected)
+	: m_pObject(pObject),
+	  m_isSelected(isSelected)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool UserMapsObjectKey::operator==(const UserMapsObjectKey &other) const
+///
+/// \brief  Compares two object keys.
+////////////////////////////////////////////////////////////////////////////////
+bool UserMapsObjectKey::operator==(const UserMapsObjectKey &other) const
+{
+	return m_pObject == other.m_pObject && m_isSelected == other.m_isSelected;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     uint qHash(const UserMapsObjectKey &key, uint seed)
+///
+/// \brief  Hash function used by QHash for object keys.
+////////////////////////////////////////////////////////////////////////////////
+uint qHash(const UserMapsObjectKey &key, uint seed)
+{
+	return hashCombine(qHash(key.m_pObject, seed), key.m_isSelected ? 1u : 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsTriangulation::UserMapsTriangulation()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsTriangulation::UserMapsTriangulation()
+	: m_geometryRevision(0),
+	  m_levelFirst(CUserMapsSimplifier::LEVEL_COUNT + 1, 0),
+	  m_levelCount(CUserMapsSimplifier::LEVEL_COUNT + 1, 0),
+	  m_isTriangulated(CUserMapsSimplifier::LEVEL_COUNT + 1, false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsCircleGeometry::UserMapsCircleGeometry()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsCircleGeometry::UserMapsCircleGeometry()
+	: m_radius(0.0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsCacheEntry::UserMapsCacheEntry()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsCacheEntry::UserMapsCacheEntry()
+	: m_type(EUserMapObjectType::Unkown_Object),
+	  m_objectId(-1),
+	  m_revision(0),
+	  m_lastSync(0),
+	  m_pOutlinePool(nullptr),
+	  m_styleSlot(-1),
+	  m_pickId(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void UserMapsObjectTable::clear()
+///
+/// \brief  Removes all objects, keeping the capacity of the arrays.
+////////////////////////////////////////////////////////////////////////////////
+void UserMapsObjectTable::clear()
+{
+	m_entries.clear();
+	m_types.clear();
+	m_maps.clear();
+	m_bounds.clear();
+	m_outlineRanges.clear();
+	m_effectiveLevels.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int UserMapsObjectTable::levelOf(size_t object, int level) const
+///
+/// \brief  Returns the level of detail an object is drawn at, see
+///         CUserMapsSimplifier::effectiveLevel().
+///
+/// \param  object - Position of the object in the draw order.
+///         level - Requested level.
+////////////////////////////////////////////////////////////////////////////////
+int UserMapsObjectTable::levelOf(size_t object, int level) const
+{
+	const size_t LEVELS = CUserMapsSimplifier::LEVEL_COUNT + 1;
+	size_t requested = static_cast<size_t>(qBound(0, level, CUserMapsSimplifier::LEVEL_COUNT));
+	return m_effectiveLevels[object * LEVELS + requested];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsSceneCache::CUserMapsSceneCache()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsSceneCache::CUserMapsSceneCache()
+	: m_syncCounter(0),
+	  m_worldRevision(0),
+	  m_isChanged(true)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSceneCache::beginSync(uint worldRevision)
+///
+/// \brief  Starts a synchronisation. Cached geometry is kept only if it was
+///         built in the same world space.
+///
+/// \param  worldRevision - Stamp of the world space the geometry will be built in.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSceneCache::beginSync(uint worldRevision)
+{
+	++m_syncCounter;
+	m_isChanged = false;
+
+	if ( worldRevision != m_worldRevision )
+	{
+		// World space anchor has moved, so every entry has to be built again
+		m_worldRevision = worldRevision;
+		clear();
+	}
+
+	m_previousDrawOrder.swap(m_drawOrder);
+	m_drawOrder.clear();
+	m_drawOrder.reserve(m_previousDrawOrder.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsCacheEntry *CUserMapsSceneCache::touch(const UserMapsObjectKey &key,
+///                                                       uint revision, bool &isDirty)
+///
+/// \brief  Marks an object as visited in the current synchronisation.
+///
+/// \param  key - Key of the object.
+///         revision - Edit stamp of the object copy (UserMapsObjectData::m_revision).
+///         isDirty - Set to true if the geometry of the entry has to be rebuilt.
+///
+/// \return Cache entry of the object.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsCacheEntry *CUserMapsSceneCache::touch(const UserMapsObjectKey &key, uint revision, bool &isDirty)
+{
+	QSharedPointer<UserMapsCacheEntry> &pEntry = m_entries[key];
+	if ( pEntry.isNull() )
+	{
+		pEntry = QSharedPointer<UserMapsCacheEntry>(new UserMapsCacheEntry());
+		isDirty = true;
+	}
+	else
+	{
+		isDirty = ( pEntry->m_revision != revision );
+	}
+
+	pEntry->m_revision = revision;
+	pEntry->m_lastSync = m_syncCounter;
+	m_drawOrder.push_back(pEntry.data());
+	m_isChanged = m_isChanged || isDirty;
+
+	return pEntry.data();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsSceneCache::endSync()
+///
+/// \brief  Finishes a synchronisation and drops the entries of objects
+///         which were not visited (removed or unloaded objects).
+///
+/// \return True if the scene has changed since the previous synchronisation.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsSceneCache::endSync()
+{
+	QHash<UserMapsObjectKey, QSharedPointer<UserMapsCacheEntry> >::iterator it = m_entries.begin();
+	while ( it != m_entries.end() )
+	{
+		if ( it.value()->m_lastSync != m_syncCounter )
+		{
+			m_removedEntries.push_back(it.value());
+			it = m_entries.erase(it);
+			m_isChanged = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// Triangulations are kept as long as the area or its selected copy is drawn
+	QHash<const void *, QSharedPointer<UserMapsTriangulation> >::iterator triangulation = m_triangulations.begin();
+	while ( triangulation != m_triangulations.end() )
+	{
+		if ( m_entries.contains(UserMapsObjectKey(triangulation.key())) ||
+			 m_entries.contains(UserMapsObjectKey(triangulation.key(), true)) )
+			++triangulation;
+		else
+			triangulation = m_triangulations.erase(triangulation);
+	}
+
+	// Objects can also change their order (e.g. moved from loaded to edited)
+	if ( m_drawOrder != m_previousDrawOrder )
+		m_isChanged = true;
+
+	if ( m_isChanged )
+		rebuildObjectTable();
+
+	return m_isChanged;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSceneCache::clear()
+///
+/// \brief  Drops all cached geometry.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSceneCache::clear()
+{
+	for (const QSharedPointer<UserMapsCacheEntry> &pEntry : m_entries)
+		m_removedEntries.push_back(pEntry);
+
+	m_entries.clear();
+	m_drawOrder.clear();
+	m_previousDrawOrder.clear();
+	m_objectTable.clear();
+	m_isChanged = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     const UserMapsObjectTable &CUserMapsSceneCache::objectTable() const
+///
+/// \brief  Returns metadata of the entries visited in the last synchronisation,
+///         in visiting order. Valid after endSync().
+////////////////////////////////////////////////////////////////////////////////
+const UserMapsObjectTable &CUserMapsSceneCache::objectTable() const
+{
+	return m_objectTable;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSceneCache::rebuildObjectTable()
+///
+/// \brief  Copies the metadata of the entries into the object table, in draw
+///         order. Called when the scene has changed, after the geometry of the
+///         changed entries has been stored.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSceneCache::rebuildObjectTable()
+{
+	const size_t LEVELS = CUserMapsSimplifier::LEVEL_COUNT + 1;
+	size_t count = m_drawOrder.size();
+
+	m_objectTable.clear();
+	m_objectTable.m_entries.reserve(count);
+	m_objectTable.m_types.reserve(count);
+	m_objectTable.m_maps.reserve(count);
+	m_objectTable.m_bounds.reserve(count);
+	m_objectTable.m_outlineRanges.reserve(count);
+	m_objectTable.m_effectiveLevels.reserve(count * LEVELS);
+
+	int map = -1;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const UserMapsCacheEntry *pEntry = m_drawOrder[i];
+		if ( i == 0 || pEntry->m_mapName != m_drawOrder[i - 1]->m_mapName )
+			++map;
+
+		m_objectTable.m_entries.push_back(m_drawOrder[i]);
+		m_objectTable.m_types.push_back(pEntry->m_type);
+		m_objectTable.m_maps.push_back(map);
+		m_objectTable.m_bounds.push_back(pEntry->m_bounds);
+		m_objectTable.m_outlineRanges.push_back(pEntry->m_outlineRange);
+		for (size_t level = 0; level < LEVELS; ++level)
+		{
+			int effective = CUserMapsSimplifier::effectiveLevel(pEntry->m_levelSizes, static_cast<int>(level));
+			m_objectTable.m_effectiveLevels.push_back(static_cast<quint8>(effective));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     std::vector<QSharedPointer<UserMapsCacheEntry> > CUserMapsSceneCache::takeRemovedEntries()
+///
+/// \brief  Returns entries dropped since the last call, so the owner can release
+///         their vertex ranges.
+////////////////////////////////////////////////////////////////////////////////
+std::vector<QSharedPointer<UserMapsCacheEntry> > CUserMapsSceneCache::takeRemovedEntries()
+{
+	std::vector<QSharedPointer<UserMapsCacheEntry> > removedEntries;
+	removedEntries.swap(m_removedEntries);
+	return removedEntries;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     QSharedPointer<UserMapsTriangulation> CUserMapsSceneCache::triangulation(const void *pObject,
+///                                                     uint geometryRevision, bool &isDirty)
+///
+/// \brief  Returns the triangulation of an area. It survives edits of colour or
+///         style and moves of the world space anchor, and is shared by the
+///         loaded and the selected copy of the area.
+///
+/// \param  pObject - Area object.
+///         geometryRevision - Edit stamp of the point list (UserMapsObjectData::m_geometryRevision).
+///         isDirty - Set to true if the triangles have to be computed again.
+///
+/// \return Triangulation of the area.
+////////////////////////////////////////////////////////////////////////////////
+QSharedPointer<UserMapsTriangulation> CUserMapsSceneCache::triangulation(const void *pObject, uint geometryRevision,
+																		 bool &isDirty)
+{
+	QSharedPointer<UserMapsTriangulation> &pTriangulation = m_triangulations[pObject];
+	isDirty = pTriangulation.isNull() || pTriangulation->m_geometryRevision != geometryRevision;
+	if ( isDirty )
+	{
+		// Entries still drawing the old triangles keep their copy
+		pTriangulation = QSharedPointer<UserMapsTriangulation>(new UserMapsTriangulation());
+		pTriangulation->m_geometryRevision = geometryRevision;
+	}
+
+	return pTriangulation;
+}
@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsscenecache.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsSceneCache class which keeps the
+///			geometry of every user map object between synchronisations.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSSCENECACHE_H
+#define USERMAPSSCENECACHE_H
+
+#include <QHash>
+#include <QPointF>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector4D>
+#include <vector>
+#include "usermapsvertexdata.h"
+#include "usermapsvertexpool.h"
+#include "usermapsspatialindex.h"
+#include "usermapssimplifier.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapobject.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsObjectKey - identifies one drawn user map object.
+///
+/// The selected object of a map is drawn on top of the map contents, so it
+/// gets its own cache slot even when the same object is also loaded.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsObjectKey
+{
+	UserMapsObjectKey(const void *pObject = nullptr, bool isSelected = false);
+	bool operator==(const UserMapsObjectKey &other) const;
+
+	const void *m_pObject;	///< Address of the user map object.
+	bool m_isSelected;		///< True for the copy drawn as the selected object.
+};
+
+uint qHash(const UserMapsObjectKey &key, uint seed = 0);
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsTriangulation - triangulated inline of an area.
+///
+/// Triangles are indices into the outline vertices of the area, so they stay
+/// valid while the point list is unchanged, whatever the colour, style or
+/// world space anchor. Each level of detail has triangles of its own, built
+/// the first time the area is drawn at that level. The triangles of all
+/// levels are kept in one list, in the order the levels were triangulated.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsTriangulation
+{
+	UserMapsTriangulation();
+
+	uint m_geometryRevision;			///< Edit stamp of the point list the triangles were built from.
+	std::vector<uint> m_indices;		///< Three outline vertex indices per triangle, all levels one after another.
+	std::vector<int> m_levelFirst;		///< First index of every level of detail in m_indices.
+	std::vector<int> m_levelCount;		///< Number of indices of every level of detail, 0 until triangulated.
+	std::vector<bool> m_isTriangulated;	///< True for the levels triangulated or being triangulated.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsCircleGeometry - circle of a circle object in world space,
+///        drawn by the circle shader from one instance record.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsCircleGeometry
+{
+	UserMapsCircleGeometry();
+
+	QPointF m_centre;				///< Centre in world space.
+	double m_radius;				///< Radius in world units.
+	UserMapsColour m_outlineColour;	///< Colour of the outline.
+	UserMapsColour m_fillColour;	///< Colour of the inline.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsCacheEntry - geometry generated for one user map object.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsCacheEntry
+{
+	UserMapsCacheEntry();
+
+	EUserMapObjectType m_type;		///< Type of the object.
+	QString m_mapName;				///< Name of the map holding the object.
+	int m_objectId;					///< Id of the object inside its map, -1 for the selected object.
+	uint m_revision;				///< Edit stamp of the object copy the geometry was built from.
+	quint64 m_lastSync;				///< Synchronisation in which the object was last seen.
+
+	CUserMapsVertexData m_outline;				///< Outline (line or area border), line style of circles.
+	MapPoint m_point;							///< Point data of point objects.
+	UserMapsCircleGeometry m_circle;			///< Circle of circle objects.
+	UserMapsBounds m_bounds;					///< Box around the geometry in world space, used for culling.
+	std::vector<quint8> m_vertexLevels;			///< Coarsest level of detail keeping each outline vertex of lines and areas.
+	std::vector<int> m_levelSizes;				///< Outline vertices kept at each level of detail, empty if not simplified.
+	UserMapsColour m_fillColour;				///< Fill colour of areas, drawn from the style table.
+	UserMapsColour m_outlineColour;				///< Colour of lines and area outlines, drawn from the style table.
+	QSharedPointer<UserMapsTriangulation> m_pTriangulation;	///< Triangles of areas, shared with the selected copy.
+
+	UserMapsVertexRange m_outlineRange;		///< Range of the outline in its vertex buffer.
+	CUserMapsVertexPool *m_pOutlinePool;	///< Vertex buffer holding the outline, nullptr if none.
+	int m_styleSlot;						///< Slot of the object in the style table, -1 if none.
+	quint32 m_pickId;						///< Id drawn by the pick pass, 0 until stored.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsObjectTable - what the draw lists and the spatial index need
+///        of every cached object, one array per field in draw order.
+///
+/// Rebuilding the draw lists walks the visible objects through these arrays
+/// instead of through the cache entries, which stay the place for the data
+/// used when an object is built.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsObjectTable
+{
+	void clear();
+	int levelOf(size_t object, int level) const;
+
+	std::vector<UserMapsCacheEntry *> m_entries;		///< Cache entry of every object.
+	std::vector<EUserMapObjectType> m_types;			///< Type of every object.
+	std::vector<int> m_maps;							///< Map of every object, numbered in draw order.
+	std::vector<UserMapsBounds> m_bounds;				///< Box around every object in world space.
+	std::vector<UserMapsVertexRange> m_outlineRanges;	///< Outline of every object in its vertex buffer.
+	std::vector<quint8> m_effectiveLevels;				///< Effective level of detail of every object for each requested level, LEVEL_COUNT + 1 per object.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsSceneCache - keeps per-object geometry between synchronisations
+///        so only added, removed or edited objects have to be rebuilt.
+///
+/// Entries are compared by the edit stamps CUserMapsSceneSource gives the
+/// object copies, so telling an object unchanged costs one comparison
+/// whatever its size, and no edit is ever mistaken for an older state.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsSceneCache
+{
+public:
+	CUserMapsSceneCache();
+
+	void beginSync(uint worldRevision);
+	UserMapsCacheEntry *touch(const UserMapsObjectKey &key, uint revision, bool &isDirty);
+	bool endSync();
+	void clear();
+
+	const UserMapsObjectTable &objectTable() const;
+	std::vector<QSharedPointer<UserMapsCacheEntry> > takeRemovedEntries();
+
+	QSharedPointer<UserMapsTriangulation> triangulation(const void *pObject, uint geometryRevision, bool &isDirty);
+
+private:
+	void rebuildObjectTable();
+
+	QHash<UserMapsObjectKey, QSharedPointer<UserMapsCacheEntry> > m_entries;	///< Cached geometry of every object.
+	std::vector<UserMapsCacheEntry *> m_drawOrder;			///< Entries in the order they were visited.
+	std::vector<UserMapsCacheEntry *> m_previousDrawOrder;	///< Draw order of the previous synchronisation.
+	UserMapsObjectTable m_objectTable;						///< Metadata of the entries in draw order.
+	std::vector<QSharedPointer<UserMapsCacheEntry> > m_removedEntries;	///< Dropped entries whose vertex ranges are still allocated.
+	QHash<const void *, QSharedPointer<UserMapsTriangulation> > m_triangulations;	///< Area triangulations, kept while the area is drawn.
+	quint64 m_syncCounter;		///< Number of the current synchronisation.
+	uint m_worldRevision;		///< World space the cached geometry was built in.
+	bool m_isChanged;			///< True if any entry was rebuilt during the current synchronisation.
+};
+
+#endif // USERMAPSSCENECACHE_H
@@ -0,0 +1,419 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsscenesource.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsSceneSource class, copying what the
+///			geometry worker needs of the loaded user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsscenesource.h"
+#include <QHash>
+#include "../UserMapsDataLib/usermapsmanager.h"
+
+static const EUserMapObjectStatus OBJECT_STATUSES[] = { EUserMapObjectStatus::Loaded, EUserMapObjectStatus::Edited,
+														EUserMapObjectStatus::Created };	///< Statuses of the drawn objects, in draw order.
+static const size_t STATUS_COUNT = sizeof(OBJECT_STATUSES) / sizeof(OBJECT_STATUSES[0]);	///< Number of drawn statuses.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsObjectData::UserMapsObjectData()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsObjectData::UserMapsObjectData()
+	: m_pObject(nullptr),
+	  m_type(EUserMapObjectType::Unkown_Object),
+	  m_objectId(-1),
+	  m_revision(0),
+	  m_geometryRevision(0),
+	  m_radius(0.0),
+	  m_colour(0),
+	  m_outlineColour(0),
+	  m_transparency(1.0f),
+	  m_icon(0),
+	  m_iconSize(0.0f),
+	  m_lineStyle(EUserMapLineStyle::Solid),
+	  m_lineWidth(1.0f)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsSceneSource::CUserMapsSceneSource()
+///
+/// \brief  Constructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsSceneSource::CUserMapsSceneSource()
+	: m_editStamp(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsSceneSource::update(const QSet<const void *> &editedObjects)
+///
+/// \brief  Takes the containers and selected objects of all loaded maps and
+///         copies the objects added or edited since the last update. Called
+///         while the GUI thread is blocked.
+///
+/// \param  editedObjects - Objects edited in place since the last update,
+///                         as reported by the layer.
+///
+/// \return True if any object has been added, removed, edited or selected.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsSceneSource::update(const QSet<const void *> &editedObjects)
+{
+	const QMap<QString, QSharedPointer<CUserMap> > &loadedMaps = CUserMapsManager::getLoadedMapsStat();
+
+	std::vector<MapSource> sources;
+	std::vector<UserMapsMapSnapshot> maps;
+	sources.reserve(static_cast<size_t>(loadedMaps.size()));
+	maps.reserve(static_cast<size_t>(loadedMaps.size()));
+
+	// A newly loaded map is compared with empty containers
+	MapSource noSource;
+	UserMapsMapSnapshot noMap;
+	noSource.m_points.resize(STATUS_COUNT);
+	noSource.m_lines.resize(STATUS_COUNT);
+	noSource.m_circles.resize(STATUS_COUNT);
+	noSource.m_areas.resize(STATUS_COUNT);
+	noMap.m_points.resize(STATUS_COUNT);
+	noMap.m_lines.resize(STATUS_COUNT);
+	noMap.m_circles.resize(STATUS_COUNT);
+	noMap.m_areas.resize(STATUS_COUNT);
+
+	bool isChanged = ( static_cast<size_t>(loadedMaps.size()) != m_maps.size() );
+
+	QMap<QString, QSharedPointer<CUserMap> >::const_iterator iter = loadedMaps.constBegin();
+	for (; iter != loadedMaps.constEnd(); ++iter)
+	{
+		const QSharedPointer<CUserMap> &pMap = iter.value();
+
+		size_t previous = 0;
+		while ( previous < m_maps.size() && m_maps[previous].m_mapName != iter.key() )
+			++previous;
+
+		bool isLoaded = ( previous < m_maps.size() );
+		const MapSource &previousSource = isLoaded ? m_sources[previous] : noSource;
+		const UserMapsMapSnapshot &previousMap = isLoaded ? m_maps[previous] : noMap;
+		isChanged = isChanged || !isLoaded;
+
+		const CUserMapObjectContainer<CUserMapPoint> &points = pMap->getPoints();
+		const CUserMapObjectContainer<CUserMapArea> &areas = pMap->getAreas();
+		const CUserMapObjectContainer<CUserMapLine> &lines = pMap->getLines();
+		const CUserMapObjectContainer<CUserMapCircle> &circles = pMap->getCircles();
+
+		MapSource source;
+		UserMapsMapSnapshot map;
+		map.m_mapName = iter.key();
+		for (size_t status = 0; status < STATUS_COUNT; ++status)
+		{
+			source.m_points.push_back(points.map(OBJECT_STATUSES[status]));
+			source.m_lines.push_back(lines.map(OBJECT_STATUSES[status]));
+			source.m_circles.push_back(circles.map(OBJECT_STATUSES[status]));
+			source.m_areas.push_back(areas.map(OBJECT_STATUSES[status]));
+
+			map.m_points.push_back(copyObjects(EUserMapObjectType::Point, source.m_points.back(),
+											   previousSource.m_points[status], previousMap.m_points[status],
+											   editedObjects, isChanged));
+			map.m_lines.push_back(copyObjects(EUserMapObjectType::Line, source.m_lines.back(),
+											  previousSource.m_lines[status], previousMap.m_lines[status],
+											  editedObjects, isChanged));
+			map.m_circles.push_back(copyObjects(EUserMapObjectType::Circle, source.m_circles.back(),
+												previousSource.m_circles[status], previousMap.m_circles[status],
+												editedObjects, isChanged));
+			map.m_areas.push_back(copyObjects(EUserMapObjectType::Area, source.m_areas.back(),
+											  previousSource.m_areas[status], previousMap.m_areas[status],
+											  editedObjects, isChanged));
+		}
+
+		// Selected object, the copy in its container if it has one
+		EUserMapObjectType selectedType = pMap->getSelectedObjectType();
+		source.m_pSelectedObject = pMap->getSelectedObject();
+		if ( selectedType != EUserMapObjectType::Unkown_Object && !source.m_pSelectedObject.isNull() )
+		{
+			const UserMapsObjectDataPtr &pPrevious = previousMap.m_pSelectedObject;
+			if ( source.m_pSelectedObject == previousSource.m_pSelectedObject && !pPrevious.isNull() &&
+				 pPrevious->m_type == selectedType && !editedObjects.contains(source.m_pSelectedObject.data()) )
+			{
+				map.m_pSelectedObject = pPrevious;
+			}
+			else
+			{
+				map.m_pSelectedObject = copySelectedObject(selectedType, source.m_pSelectedObject, map);
+				isChanged = true;
+			}
+		}
+		else
+		{
+			source.m_pSelectedObject.clear();
+			isChanged = isChanged || !previousMap.m_pSelectedObject.isNull();
+		}
+
+		sources.push_back(source);
+		maps.push_back(map);
+	}
+
+	m_sources.swap(sources);
+	m_maps.swap(maps);
+	return isChanged;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     const std::vector<UserMapsMapSnapshot> &CUserMapsSceneSource::maps() const
+///
+/// \brief  Returns the copied objects of the loaded maps at the last update.
+////////////////////////////////////////////////////////////////////////////////
+const std::vector<UserMapsMapSnapshot> &CUserMapsSceneSource::maps() const
+{
+	return m_maps;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     template <typename T>
+///         UserMapsObjectList CUserMapsSceneSource::copyObjects(EUserMapObjectType type,
+///                 const QMap<int, QSharedPointer<T> > &objects,
+///                 const QMap<int, QSharedPointer<T> > &previousObjects,
+///                 const UserMapsObjectList &previousList,
+///                 const QSet<const void *> &editedObjects, bool &isChanged)
+///
+/// \brief  Returns the copies of the objects of a container. Copies of the
+///         last update are kept for objects still in the container and not
+///         edited; if the container itself is unchanged, only the edited
+///         objects are looked at.
+///
+/// \param  type - Type of the objects.
+///         objects - Container of the objects.
+///         previousObjects - Same container at the last update.
+///         previousList - Copies of the last update.
+///         editedObjects - Objects edited in place since the last update.
+///         isChanged - Set to true if any copy has been added, removed or replaced.
+///
+/// \return Copies in id order.
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+UserMapsObjectList CUserMapsSceneSource::copyObjects(EUserMapObjectType type, const QMap<int, QSharedPointer<T> > &objects,
+													 const QMap<int, QSharedPointer<T> > &previousObjects,
+													 const UserMapsObjectList &previousList,
+													 const QSet<const void *> &editedObjects, bool &isChanged)
+{
+	if ( objects.isSharedWith(previousObjects) )
+	{
+		// Same objects, only those edited in place are copied again
+		UserMapsObjectList list = previousList;
+		if ( editedObjects.isEmpty() )
+			return list;
+
+		for (int i = 0; i < list.size(); ++i)
+		{
+			UserMapsObjectDataPtr pPrevious = list.at(i);
+			if ( !editedObjects.contains(pPrevious->m_pObject) )
+				continue;
+
+			QSharedPointer<T> pObject = objects.value(pPrevious->m_objectId);
+			if ( pObject.isNull() )
+				continue;
+
+			list[i] = copyObject(type, pPrevious->m_objectId, *pObject, pPrevious);
+			isChanged = true;
+		}
+		return list;
+	}
+
+	isChanged = true;
+
+	// Copies kept are found by the address of their object
+	QHash<const void *, UserMapsObjectDataPtr> previousCopies;
+	previousCopies.reserve(previousList.size());
+	for (const UserMapsObjectDataPtr &pPrevious : previousList)
+		previousCopies.insert(pPrevious->m_pObject, pPrevious);
+
+	UserMapsObjectList list;
+	list.reserve(objects.size());
+	for (typename QMap<int, QSharedPointer<T> >::const_iterator it = objects.constBegin(); it != objects.constEnd(); ++it)
+	{
+		const void *pObject = it.value().data();
+		UserMapsObjectDataPtr pCopy = previousCopies.value(pObject);
+		if ( pCopy.isNull() || pCopy->m_objectId != it.key() || editedObjects.contains(pObject) )
+			pCopy = copyObject(type, it.key(), *it.value(), pCopy);
+
+		list.append(pCopy);
+	}
+	return list;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     template <typename T>
+///         UserMapsObjectDataPtr CUserMapsSceneSource::copyObject(EUserMapObjectType type, int objectId,
+///                 const T &object, const UserMapsObjectDataPtr &pPrevious)
+///
+/// \brief  Copies an object and gives the copy a new edit stamp.
+///
+/// \param  type - Type of the object.
+///         objectId - Id of the object inside its map, -1 if not in a container.
+///         object - Object to be copied.
+///         pPrevious - Previous copy of the object, null if none.
+///
+/// \return New copy.
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+UserMapsObjectDataPtr CUserMapsSceneSource::copyObject(EUserMapObjectType type, int objectId, const T &object,
+													   const UserMapsObjectDataPtr &pPrevious)
+{
+	QSharedPointer<UserMapsObjectData> pData(new UserMapsObjectData());
+	pData->m_pObject = &object;
+	pData->m_type = type;
+	pData->m_objectId = objectId;
+	pData->m_revision = ++m_editStamp;
+	copyAttributes(object, *pData);
+
+	// Triangles of an area survive edits which leave its points where they were
+	bool isSameGeometry = ( !pPrevious.isNull() && isSamePositions(pData->m_positions, pPrevious->m_positions) );
+	pData->m_geometryRevision = isSameGeometry ? pPrevious->m_geometryRevision : pData->m_revision;
+
+	return pData;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsObjectDataPtr CUserMapsSceneSource::copySelectedObject(EUserMapObjectType type,
+///                 const QSharedPointer<CUserMapObject> &pObject, const UserMapsMapSnapshot &map)
+///
+/// \brief  Returns the copy of the selected object of a map: the copy made for
+///         its container, so both share the triangles of an area, or a copy of
+///         its own if it is in none of the containers.
+///
+/// \param  type - Type of the selected object.
+///         pObject - Selected object.
+///         map - Copies of the containers of the map, already updated.
+///
+/// \return Copy of the selected object.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsObjectDataPtr CUserMapsSceneSource::copySelectedObject(EUserMapObjectType type,
+															   const QSharedPointer<CUserMapObject> &pObject,
+															   const UserMapsMapSnapshot &map)
+{
+	const std::vector<UserMapsObjectList> *pLists = nullptr;
+	switch (type)
+	{
+	case EUserMapObjectType::Point:
+		pLists = &map.m_points;
+		break;
+	case EUserMapObjectType::Line:
+		pLists = &map.m_lines;
+		break;
+	case EUserMapObjectType::Circle:
+		pLists = &map.m_circles;
+		break;
+	case EUserMapObjectType::Area:
+		pLists = &map.m_areas;
+		break;
+	case EUserMapObjectType::Unkown_Object:
+		return UserMapsObjectDataPtr();
+	}
+
+	const void *pSelected = pObject.data();
+	for (const UserMapsObjectList &list : *pLists)
+	{
+		for (const UserMapsObjectDataPtr &pCopy : list)
+		{
+			if ( pCopy->m_pObject == pSelected )
+				return pCopy;
+		}
+	}
+
+	switch (type)
+	{
+	case EUserMapObjectType::Point:
+		return copyObject(type, -1, *pObject.staticCast<CUserMapPoint>(), UserMapsObjectDataPtr());
+	case EUserMapObjectType::Line:
+		return copyObject(type, -1, *pObject.staticCast<CUserMapLine>(), UserMapsObjectDataPtr());
+	case EUserMapObjectType::Circle:
+		return copyObject(type, -1, *pObject.staticCast<CUserMapCircle>(), UserMapsObjectDataPtr());
+	case EUserMapObjectType::Area:
+		return copyObject(type, -1, *pObject.staticCast<CUserMapArea>(), UserMapsObjectDataPtr());
+	case EUserMapObjectType::Unkown_Object:
+		break;
+	}
+	return UserMapsObjectDataPtr();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSceneSource::copyAttributes(const CUserMapPoint &point, UserMapsObjectData &data)
+///
+/// \brief  Copies position, colour and icon of a point object.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSceneSource::copyAttributes(const CUserMapPoint &point, UserMapsObjectData &data)
+{
+	data.m_positions.append(point.getPosition());
+	data.m_colour = point.getColor();
+	data.m_transparency = point.getTransparency();
+	data.m_icon = point.getIcon();
+	data.m_iconSize = point.getIconSize();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSceneSource::copyAttributes(const CUserMapLine &line, UserMapsObjectData &data)
+///
+/// \brief  Copies points, colour and line style of a line object. The point
+///         list is implicitly shared until the object changes it.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSceneSource::copyAttributes(const CUserMapLine &line, UserMapsObjectData &data)
+{
+	data.m_positions = line.getPoints();
+	data.m_colour = line.getColor();
+	data.m_transparency = line.getTransparency();
+	data.m_lineStyle = line.getLineStyle();
+	data.m_lineWidth = line.getLineWidth();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSceneSource::copyAttributes(const CUserMapArea &area, UserMapsObjectData &data)
+///
+/// \brief  Copies points, colours and line style of an area object.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSceneSource::copyAttributes(const CUserMapArea &area, UserMapsObjectData &data)
+{
+	data.m_positions = area.getPoints();
+	data.m_colour = area.getColor();
+	data.m_outlineColour = area.getOutlineColor();
+	data.m_transparency = area.getTransparency();
+	data.m_lineStyle = area.getLineStyle();
+	data.m_lineWidth = area.getLineWidth();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSceneSource::copyAttributes(const CUserMapCircle &circle, UserMapsObjectData &data)
+///
+/// \brief  Copies centre, radius, colours and line style of a circle object.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSceneSource::copyAttributes(const CUserMapCircle &circle, UserMapsObjectData &data)
+{
+	data.m_positions.append(circle.getCenter());
+	data.m_radius = circle.getRadius();
+	data.m_colour = circle.getColor();
+	data.m_outlineColour = circle.getOutlineColor();
+	data.m_transparency = circle.getTransparency();
+	data.m_lineStyle = circle.getLineStyle();
+	data.m_lineWidth = circle.getLineWidth();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsSceneSource::isSamePositions(const QVector<CPosition> &positions,
+///                                                   const QVector<CPosition> &otherPositions)
+///
+/// \brief  Compares two position lists.
+///
+/// \return True if both have the same positions in the same order.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsSceneSource::isSamePositions(const QVector<CPosition> &positions, const QVector<CPosition> &otherPositions)
+{
+	if ( positions.size() != otherPositions.size() )
+		return false;
+
+	for (int i = 0; i < positions.size(); ++i)
+	{
+		if ( positions.at(i).Latitude() != otherPositions.at(i).Latitude() ||
+			 positions.at(i).Longitude() != otherPositions.at(i).Longitude() )
+			return false;
+	}
+	return true;
+}
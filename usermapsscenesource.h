@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsscenesource.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsSceneSource class, copying what the
+///			geometry worker needs of the loaded user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSSCENESOURCE_H
+#define USERMAPSSCENESOURCE_H
+
+#include <QMap>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <vector>
+#include "../UserMapsDataLib/usermap.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapobject.h"
+#include "../UserMapsDataLib/UserMapObjects/usermappoint.h"
+#include "../UserMapsDataLib/UserMapObjects/usermaparea.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapcircle.h"
+#include "../UserMapsDataLib/UserMapObjects/usermapline.h"
+#include "../UserMapsDataLib/usermaplinestyle.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsObjectData - copy of what the geometry worker needs of one
+///        user map object. Never changed once posted, so the worker reads it
+///        while the GUI thread edits the object.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsObjectData
+{
+	UserMapsObjectData();
+
+	const void *m_pObject;				///< Address of the object, only used as cache key.
+	EUserMapObjectType m_type;			///< Type of the object.
+	int m_objectId;						///< Id of the object inside its map, -1 if not in a container.
+	uint m_revision;					///< Edit stamp, new every time the object is copied.
+	uint m_geometryRevision;			///< Edit stamp of the positions, kept by copies which left them unchanged.
+	QVector<CPosition> m_positions;		///< Points of lines and areas, position of points, centre of circles.
+	double m_radius;					///< Radius of circles in nautical miles.
+	int m_colour;						///< Colour key of points and lines, inline of areas and circles.
+	int m_outlineColour;				///< Colour key of the outline of areas and circles.
+	float m_transparency;				///< Opacity applied to m_colour.
+	int m_icon;							///< Icon of points.
+	float m_iconSize;					///< Icon size of points in millimetres.
+	EUserMapLineStyle m_lineStyle;		///< Line style of lines, areas and circles.
+	float m_lineWidth;					///< Line width of lines, areas and circles.
+};
+
+typedef QSharedPointer<const UserMapsObjectData> UserMapsObjectDataPtr;	///< Shared, read only copy of an object.
+typedef QVector<UserMapsObjectDataPtr> UserMapsObjectList;					///< Copies of the objects of a container, in id order.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsMapSnapshot - copied objects of one loaded map at the time
+///        of a synchronisation. The lists are implicitly shared between
+///        snapshots as long as their objects are unchanged.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsMapSnapshot
+{
+	QString m_mapName;						///< Name of the map.
+	std::vector<UserMapsObjectList> m_points;	///< Points, one list per object status.
+	std::vector<UserMapsObjectList> m_lines;	///< Lines, one list per object status.
+	std::vector<UserMapsObjectList> m_circles;	///< Circles, one list per object status.
+	std::vector<UserMapsObjectList> m_areas;	///< Areas, one list per object status.
+	UserMapsObjectDataPtr m_pSelectedObject;	///< Selected object, drawn on top of the map, null if none.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsSceneSource - copies of the objects of the loaded maps, as
+///        the geometry worker reads them.
+///
+/// update() is called by the renderer while the GUI thread is blocked. It
+/// compares the object containers of the loaded maps with those of the last
+/// update (cheap, they are implicitly shared) and copies only the objects of
+/// changed containers it has not copied before, and the objects the layer
+/// reports edited in place. Every copy gets a new edit stamp, which the scene
+/// cache compares to tell what to rebuild; the stamp of the positions is kept
+/// if they are unchanged, so areas keep their triangles over colour edits.
+/// Objects are never read outside update(), so the worker does not race
+/// with edits on the GUI thread.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsSceneSource
+{
+public:
+	CUserMapsSceneSource();
+
+	bool update(const QSet<const void *> &editedObjects);
+	const std::vector<UserMapsMapSnapshot> &maps() const;
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief MapSource - containers of one loaded map and their copies.
+	////////////////////////////////////////////////////////////////////////////
+	struct MapSource
+	{
+		std::vector<QMap<int, QSharedPointer<CUserMapPoint> > > m_points;	///< Points, one container per object status.
+		std::vector<QMap<int, QSharedPointer<CUserMapLine> > > m_lines;		///< Lines, one container per object status.
+		std::vector<QMap<int, QSharedPointer<CUserMapCircle> > > m_circles;	///< Circles, one container per object status.
+		std::vector<QMap<int, QSharedPointer<CUserMapArea> > > m_areas;		///< Areas, one container per object status.
+		QSharedPointer<CUserMapObject> m_pSelectedObject;					///< Selected object.
+	};
+
+	template <typename T>
+	UserMapsObjectList copyObjects(EUserMapObjectType type, const QMap<int, QSharedPointer<T> > &objects,
+								   const QMap<int, QSharedPointer<T> > &previousObjects,
+								   const UserMapsObjectList &previousList, const QSet<const void *> &editedObjects,
+								   bool &isChanged);
+	template <typename T>
+	UserMapsObjectDataPtr copyObject(EUserMapObjectType type, int objectId, const T &object,
+									 const UserMapsObjectDataPtr &pPrevious);
+	UserMapsObjectDataPtr copySelectedObject(EUserMapObjectType type, const QSharedPointer<CUserMapObject> &pObject,
+											 const UserMapsMapSnapshot &map);
+
+	static void copyAttributes(const CUserMapPoint &point, UserMapsObjectData &data);
+	static void copyAttributes(const CUserMapLine &line, UserMapsObjectData &data);
+	static void copyAttributes(const CUserMapArea &area, UserMapsObjectData &data);
+	static void copyAttributes(const CUserMapCircle &circle, UserMapsObjectData &data);
+	static bool isSamePositions(const QVector<CPosition> &positions, const QVector<CPosition> &otherPositions);
+
+	std::vector<MapSource> m_sources;			///< Containers of the loaded maps at the last update.
+	std::vector<UserMapsMapSnapshot> m_maps;	///< Copies of the loaded maps at the last update.
+	uint m_editStamp;							///< Last edit stamp given to a copy.
+};
+
+#endif // USERMAPSSCENESOURCE_H
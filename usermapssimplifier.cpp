@@ -0,0 +1,200 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapssimplifier.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsSimplifier class which ranks the
+///			vertices of lines and area outlines into levels of detail.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapssimplifier.h"
+#include <cmath>
+#include <limits>
+
+const int CUserMapsSimplifier::LEVEL_COUNT;
+
+static const double FINEST_TOLERANCE = 0.001;	///< Tolerance of level 1 in world units (about 2 m).
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     static double segmentDistance(double px, double py, double ax, double ay,
+///                                       double bx, double by)
+///
+/// \brief  Returns distance of a point from the segment a-b.
+////////////////////////////////////////////////////////////////////////////////
+static double segmentDistance(double px, double py, double ax, double ay, double bx, double by)
+{
+	double dx = bx - ax;
+	double dy = by - ay;
+	double length2 = dx * dx + dy * dy;
+
+	double t = 0.0;
+	if ( length2 > 0.0 )
+	{
+		t = ((px - ax) * dx + (py - ay) * dy) / length2;
+		t = ( t < 0.0 ) ? 0.0 : ( t > 1.0 ) ? 1.0 : t;
+	}
+
+	double ex = px - (ax + t * dx);
+	double ey = py - (ay + t * dy);
+	return std::sqrt(ex * ex + ey * ey);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double CUserMapsSimplifier::levelTolerance(int level)
+///
+/// \brief  Returns tolerance of a level in world units, 0 for level 0.
+///
+/// \param  level - Level of detail.
+////////////////////////////////////////////////////////////////////////////////
+double CUserMapsSimplifier::levelTolerance(int level)
+{
+	if ( level <= 0 )
+		return 0.0;
+
+	return std::ldexp(FINEST_TOLERANCE, level - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsSimplifier::levelFor(double pixelsPerWorldUnit, double tolerancePixels)
+///
+/// \brief  Returns the coarsest level whose error stays within a tolerance on
+///         the screen.
+///
+/// \param  pixelsPerWorldUnit - Current view scale.
+///         tolerancePixels - Largest acceptable error in pixels.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsSimplifier::levelFor(double pixelsPerWorldUnit, double tolerancePixels)
+{
+	if ( pixelsPerWorldUnit <= 0.0 || tolerancePixels <= 0.0 )
+		return 0;
+
+	double tolerance = tolerancePixels / pixelsPerWorldUnit;
+	if ( tolerance < FINEST_TOLERANCE )
+		return 0;
+
+	int level = static_cast<int>(std::floor(std::log2(tolerance / FINEST_TOLERANCE))) + 1;
+	return ( level < LEVEL_COUNT ) ? level : LEVEL_COUNT;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsSimplifier::effectiveLevel(const std::vector<int> &levelSizes, int level)
+///
+/// \brief  Returns the finest level keeping the same vertices as a level, so
+///         levels which drop nothing share their triangulation.
+///
+/// \param  levelSizes - Vertices kept at each level, from simplify().
+///         level - Requested level.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsSimplifier::effectiveLevel(const std::vector<int> &levelSizes, int level)
+{
+	if ( levelSizes.empty() )
+		return 0;
+
+	if ( level >= static_cast<int>(levelSizes.size()) )
+		level = static_cast<int>(levelSizes.size()) - 1;
+
+	while ( level > 0 && levelSizes[static_cast<size_t>(level)] == levelSizes[static_cast<size_t>(level) - 1] )
+		--level;
+	return level;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSimplifier::simplify(const double *x, const double *y, int count, bool isClosed,
+///                                           std::vector<quint8> &vertexLevels, std::vector<int> &levelSizes)
+///
+/// \brief  Ranks the vertices of a polyline. End points (for rings the first
+///         vertex and the one farthest from it) are kept at every level.
+///
+/// \param  x, y - Vertices in world space.
+///         count - Number of vertices.
+///         isClosed - True for a ring, whose last vertex connects to the first.
+///         vertexLevels - Receives the coarsest level keeping each vertex.
+///         levelSizes - Receives the number of vertices kept at levels 0 .. LEVEL_COUNT.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSimplifier::simplify(const double *x, const double *y, int count, bool isClosed,
+								   std::vector<quint8> &vertexLevels, std::vector<int> &levelSizes)
+{
+	const double keep = std::numeric_limits<double>::max();
+	vertexLevels.assign(static_cast<size_t>(count), static_cast<quint8>(LEVEL_COUNT));
+	levelSizes.assign(LEVEL_COUNT + 1, count);
+	if ( count < 3 )
+		return;
+
+	m_errors.assign(static_cast<size_t>(count), keep);
+	m_segments.clear();
+
+	if ( isClosed )
+	{
+		// Split the ring where it is widest
+		int farthest = 0;
+		double farthestDistance = 0.0;
+		for (int i = 1; i < count; ++i)
+		{
+			double distance = (x[i] - x[0]) * (x[i] - x[0]) + (y[i] - y[0]) * (y[i] - y[0]);
+			if ( distance > farthestDistance )
+			{
+				farthest = i;
+				farthestDistance = distance;
+			}
+		}
+
+		if ( farthest == 0 )
+			return;
+
+		Segment first = { 0, farthest, keep };
+		Segment second = { farthest, count, keep };
+		m_segments.push_back(first);
+		m_segments.push_back(second);
+	}
+	else
+	{
+		Segment line = { 0, count - 1, keep };
+		m_segments.push_back(line);
+	}
+
+	// Every interior vertex is reached once, with the error bounded by the
+	// split it depends on, so the levels are nested
+	while ( !m_segments.empty() )
+	{
+		Segment segment = m_segments.back();
+		m_segments.pop_back();
+		if ( segment.m_last - segment.m_first < 2 )
+			continue;
+
+		int last = ( segment.m_last < count ) ? segment.m_last : 0;
+		int farthest = segment.m_first + 1;
+		double farthestDistance = -1.0;
+		for (int i = segment.m_first + 1; i < segment.m_last; ++i)
+		{
+			double distance = segmentDistance(x[i], y[i], x[segment.m_first], y[segment.m_first], x[last], y[last]);
+			if ( distance > farthestDistance )
+			{
+				farthest = i;
+				farthestDistance = distance;
+			}
+		}
+
+		double error = ( farthestDistance < segment.m_bound ) ? farthestDistance : segment.m_bound;
+		m_errors[static_cast<size_t>(farthest)] = error;
+
+		Segment before = { segment.m_first, farthest, error };
+		Segment after = { farthest, segment.m_last, error };
+		m_segments.push_back(before);
+		m_segments.push_back(after);
+	}
+
+	for (int k = 1; k <= LEVEL_COUNT; ++k)
+		levelSizes[static_cast<size_t>(k)] = 0;
+
+	for (size_t i = 0; i < m_errors.size(); ++i)
+	{
+		int level = 0;
+		while ( level < LEVEL_COUNT && m_errors[i] > levelTolerance(level + 1) )
+			++level;
+
+		vertexLevels[i] = static_cast<quint8>(level);
+		for (int k = 1; k <= level; ++k)
+			++levelSizes[static_cast<size_t>(k)];
+	}
+}
@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapssimplifier.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsSimplifier class which ranks the
+///			vertices of lines and area outlines into levels of detail.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSSIMPLIFIER_H
+#define USERMAPSSIMPLIFIER_H
+
+#include <QtGlobal>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsSimplifier - Douglas-Peucker simplification of polylines
+///        at a fixed series of tolerances.
+///
+/// Level 0 is the full geometry, level k (1 .. LEVEL_COUNT) drops the
+/// vertices closer than levelTolerance(k) world units to the simplified
+/// line, each level twice the tolerance of the previous one. A single
+/// Douglas-Peucker pass records the error at which every vertex would be
+/// dropped, so the levels are nested and all of them cost one run: a vertex
+/// is tagged with the coarsest level still keeping it.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsSimplifier
+{
+public:
+	static const int LEVEL_COUNT = 16;	///< Simplified levels, not counting level 0.
+
+	static double levelTolerance(int level);
+	static int levelFor(double pixelsPerWorldUnit, double tolerancePixels);
+	static int effectiveLevel(const std::vector<int> &levelSizes, int level);
+
+	void simplify(const double *x, const double *y, int count, bool isClosed,
+				  std::vector<quint8> &vertexLevels, std::vector<int> &levelSizes);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief Segment - part of the polyline still to be split.
+	////////////////////////////////////////////////////////////////////////////
+	struct Segment
+	{
+		int m_first;		///< First vertex.
+		int m_last;			///< Last vertex, may be count to refer to vertex 0 of a ring.
+		double m_bound;		///< Error of the vertex the segment was split at.
+	};
+
+	std::vector<double> m_errors;		///< Error at which every vertex is dropped.
+	std::vector<Segment> m_segments;	///< Stack of segments to be split.
+};
+
+#endif // USERMAPSSIMPLIFIER_H
@@ -0,0 +1,342 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsspatialindex.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsSpatialIndex class, a packed R-tree
+///			over the world space bounding boxes of user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsspatialindex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+const int CUserMapsSpatialIndex::NODE_CAPACITY;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds::UserMapsBounds()
+///
+/// \brief  Constructor. Creates an empty box which any point extends.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds::UserMapsBounds()
+	: m_minX(std::numeric_limits<double>::max()),
+	  m_minY(std::numeric_limits<double>::max()),
+	  m_maxX(-std::numeric_limits<double>::max()),
+	  m_maxY(-std::numeric_limits<double>::max())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds::UserMapsBounds(double minX, double minY, double maxX, double maxY)
+///
+/// \brief  Constructor.
+///
+/// \param  minX, minY - Lower left corner.
+///         maxX, maxY - Upper right corner.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds::UserMapsBounds(double minX, double minY, double maxX, double maxY)
+	: m_minX(minX),
+	  m_minY(minY),
+	  m_maxX(maxX),
+	  m_maxY(maxY)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds::UserMapsBounds(const QRectF &rect)
+///
+/// \brief  Constructor. Takes the box around a (possibly flipped) rectangle.
+///
+/// \param  rect - Rectangle.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds::UserMapsBounds(const QRectF &rect)
+	: m_minX(std::min(rect.left(), rect.right())),
+	  m_minY(std::min(rect.top(), rect.bottom())),
+	  m_maxX(std::max(rect.left(), rect.right())),
+	  m_maxY(std::max(rect.top(), rect.bottom()))
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool UserMapsBounds::operator==(const UserMapsBounds &other) const
+///
+/// \brief  Checks whether two boxes have the same corners.
+///
+/// \param  other - Other box.
+////////////////////////////////////////////////////////////////////////////////
+bool UserMapsBounds::operator==(const UserMapsBounds &other) const
+{
+	return m_minX == other.m_minX && m_minY == other.m_minY && m_maxX == other.m_maxX && m_maxY == other.m_maxY;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool UserMapsBounds::isEmpty() const
+///
+/// \brief  Returns true if no point has been added to the box.
+////////////////////////////////////////////////////////////////////////////////
+bool UserMapsBounds::isEmpty() const
+{
+	return m_minX > m_maxX || m_minY > m_maxY;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool UserMapsBounds::intersects(const UserMapsBounds &other) const
+///
+/// \brief  Checks whether two boxes overlap or touch.
+///
+/// \param  other - Other box.
+////////////////////////////////////////////////////////////////////////////////
+bool UserMapsBounds::intersects(const UserMapsBounds &other) const
+{
+	return m_minX <= other.m_maxX && other.m_minX <= m_maxX &&
+		   m_minY <= other.m_maxY && other.m_minY <= m_maxY;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool UserMapsBounds::contains(const UserMapsBounds &other) const
+///
+/// \brief  Checks whether another box lies completely inside this one.
+///
+/// \param  other - Other box.
+////////////////////////////////////////////////////////////////////////////////
+bool UserMapsBounds::contains(const UserMapsBounds &other) const
+{
+	return m_minX <= other.m_minX && other.m_maxX <= m_maxX &&
+		   m_minY <= other.m_minY && other.m_maxY <= m_maxY;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void UserMapsBounds::unite(double x, double y)
+///
+/// \brief  Extends the box to include a point.
+///
+/// \param  x, y - Point.
+////////////////////////////////////////////////////////////////////////////////
+void UserMapsBounds::unite(double x, double y)
+{
+	m_minX = std::min(m_minX, x);
+	m_minY = std::min(m_minY, y);
+	m_maxX = std::max(m_maxX, x);
+	m_maxY = std::max(m_maxY, y);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void UserMapsBounds::unite(const UserMapsBounds &other)
+///
+/// \brief  Extends the box to include another box.
+///
+/// \param  other - Other box.
+////////////////////////////////////////////////////////////////////////////////
+void UserMapsBounds::unite(const UserMapsBounds &other)
+{
+	m_minX = std::min(m_minX, other.m_minX);
+	m_minY = std::min(m_minY, other.m_minY);
+	m_maxX = std::max(m_maxX, other.m_maxX);
+	m_maxY = std::max(m_maxY, other.m_maxY);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsBounds UserMapsBounds::adjusted(double margin) const
+///
+/// \brief  Returns the box grown by a margin on every side.
+///
+/// \param  margin - Margin, negative to shrink.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsBounds UserMapsBounds::adjusted(double margin) const
+{
+	return UserMapsBounds(m_minX - margin, m_minY - margin, m_maxX + margin, m_maxY + margin);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     double UserMapsBounds::area() const
+///
+/// \brief  Returns area of the box, 0 if it is empty.
+////////////////////////////////////////////////////////////////////////////////
+double UserMapsBounds::area() const
+{
+	if ( isEmpty() )
+		return 0.0;
+
+	return (m_maxX - m_minX) * (m_maxY - m_minY);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsSpatialIndex::CUserMapsSpatialIndex()
+///
+/// \brief  Constructor. Creates an empty index.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsSpatialIndex::CUserMapsSpatialIndex()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSpatialIndex::clear()
+///
+/// \brief  Removes all items.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSpatialIndex::clear()
+{
+	m_levels.clear();
+	m_bounds = UserMapsBounds();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSpatialIndex::insert(const UserMapsBounds &bounds, int value)
+///
+/// \brief  Adds an item. It is found by queries after the next build().
+///
+/// \param  bounds - Box of the item, empty boxes are ignored.
+///         value - Value returned by queries.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSpatialIndex::insert(const UserMapsBounds &bounds, int value)
+{
+	if ( bounds.isEmpty() )
+		return;
+
+	if ( m_levels.size() != 1 )
+		m_levels.resize(1);
+
+	Node item;
+	item.m_bounds = bounds;
+	item.m_first = value;
+	item.m_count = 0;
+	m_levels[0].push_back(item);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSpatialIndex::build()
+///
+/// \brief  Packs the inserted items into the tree, level by level, until a
+///         level fits into a single node.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSpatialIndex::build()
+{
+	m_bounds = UserMapsBounds();
+	if ( m_levels.empty() )
+		return;
+
+	m_levels.resize(1);
+	while ( m_levels.back().size() > static_cast<size_t>(NODE_CAPACITY) )
+	{
+		std::vector<Node> parents;
+		pack(m_levels.back(), parents);
+		m_levels.push_back(parents);
+	}
+
+	for (const Node &node : m_levels.back())
+		m_bounds.unite(node.m_bounds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSpatialIndex::query(const UserMapsBounds &region, std::vector<int> &values) const
+///
+/// \brief  Appends the values of all items whose box intersects a region.
+///         Subtrees inside the region are taken without further tests.
+///
+/// \param  region - Region to search.
+///         values - Receives the values, in no particular order.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSpatialIndex::query(const UserMapsBounds &region, std::vector<int> &values) const
+{
+	if ( m_levels.empty() || !m_bounds.intersects(region) )
+		return;
+
+	// Pending nodes as (level, index)
+	std::vector<std::pair<int, int> > stack;
+	int top = static_cast<int>(m_levels.size()) - 1;
+	for (int i = 0; i < static_cast<int>(m_levels.back().size()); ++i)
+		stack.push_back(std::make_pair(top, i));
+
+	while ( !stack.empty() )
+	{
+		int level = stack.back().first;
+		const Node &node = m_levels[static_cast<size_t>(level)][static_cast<size_t>(stack.back().second)];
+		stack.pop_back();
+
+		if ( !node.m_bounds.intersects(region) )
+			continue;
+
+		if ( level == 0 )
+		{
+			values.push_back(node.m_first);
+			continue;
+		}
+
+		if ( level == 1 && region.contains(node.m_bounds) )
+		{
+			// Whole leaf inside the region
+			for (int i = node.m_first; i < node.m_first + node.m_count; ++i)
+				values.push_back(m_levels[0][static_cast<size_t>(i)].m_first);
+			continue;
+		}
+
+		for (int i = node.m_first; i < node.m_first + node.m_count; ++i)
+			stack.push_back(std::make_pair(level - 1, i));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     const UserMapsBounds &CUserMapsSpatialIndex::bounds() const
+///
+/// \brief  Returns box around all items as of the last build().
+////////////////////////////////////////////////////////////////////////////////
+const UserMapsBounds &CUserMapsSpatialIndex::bounds() const
+{
+	return m_bounds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsSpatialIndex::size() const
+///
+/// \brief  Returns number of items.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsSpatialIndex::size() const
+{
+	return m_levels.empty() ? 0 : static_cast<int>(m_levels[0].size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsSpatialIndex::pack(std::vector<Node> &nodes, std::vector<Node> &parents)
+///
+/// \brief  Sort-Tile-Recursive packing of one level: nodes are sorted into
+///         vertical slices by x, each slice by y, and every NODE_CAPACITY
+///         consecutive nodes get a parent.
+///
+/// \param  nodes - Nodes of a level, reordered.
+///         parents - Receives the parent level.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsSpatialIndex::pack(std::vector<Node> &nodes, std::vector<Node> &parents)
+{
+	size_t count = nodes.size();
+	size_t parentCount = (count + NODE_CAPACITY - 1) / NODE_CAPACITY;
+	size_t sliceCount = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(parentCount))));
+	size_t sliceSize = sliceCount * NODE_CAPACITY;
+
+	std::sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b)
+	{
+		return a.m_bounds.m_minX + a.m_bounds.m_maxX < b.m_bounds.m_minX + b.m_bounds.m_maxX;
+	});
+
+	for (size_t first = 0; first < count; first += sliceSize)
+	{
+		size_t end = std::min(first + sliceSize, count);
+		std::sort(nodes.begin() + static_cast<long>(first), nodes.begin() + static_cast<long>(end), [](const Node &a, const Node &b)
+		{
+			return a.m_bounds.m_minY + a.m_bounds.m_maxY < b.m_bounds.m_minY + b.m_bounds.m_maxY;
+		});
+	}
+
+	parents.clear();
+	parents.reserve(parentCount);
+	for (size_t first = 0; first < count; first += NODE_CAPACITY)
+	{
+		Node parent;
+		parent.m_first = static_cast<int>(first);
+		parent.m_count = static_cast<int>(std::min<size_t>(NODE_CAPACITY, count - first));
+		for (int i = 0; i < parent.m_count; ++i)
+			parent.m_bounds.unite(nodes[first + static_cast<size_t>(i)].m_bounds);
+		parents.push_back(parent);
+	}
+}
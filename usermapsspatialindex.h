@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsspatialindex.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsSpatialIndex class, a packed R-tree
+///			over the world space bounding boxes of user map objects.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSSPATIALINDEX_H
+#define USERMAPSSPATIALINDEX_H
+
+#include <QRectF>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsBounds - axis aligned box in world space. Unlike QRectF a box
+///        of zero size (a point) is valid and intersects what contains it.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsBounds
+{
+	UserMapsBounds();
+	UserMapsBounds(double minX, double minY, double maxX, double maxY);
+	explicit UserMapsBounds(const QRectF &rect);
+
+	bool operator==(const UserMapsBounds &other) const;
+	bool isEmpty() const;
+	bool intersects(const UserMapsBounds &other) const;
+	bool contains(const UserMapsBounds &other) const;
+	void unite(double x, double y);
+	void unite(const UserMapsBounds &other);
+	UserMapsBounds adjusted(double margin) const;
+	double area() const;
+
+	double m_minX;	///< Left edge.
+	double m_minY;	///< Bottom edge.
+	double m_maxX;	///< Right edge.
+	double m_maxY;	///< Top edge.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsSpatialIndex - finds the objects inside a region in time
+///        proportional to the number found rather than the number indexed.
+///
+/// Boxes are inserted with an integer value (e.g. position in the draw order)
+/// and packed bottom up with the Sort-Tile-Recursive method, NODE_CAPACITY
+/// children per node. The tree is static: it is built again when the scene
+/// changes, which costs O(n log n), and answers queries until then.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsSpatialIndex
+{
+public:
+	static const int NODE_CAPACITY = 16;	///< Children per node.
+
+	CUserMapsSpatialIndex();
+
+	void clear();
+	void insert(const UserMapsBounds &bounds, int value);
+	void build();
+
+	void query(const UserMapsBounds &region, std::vector<int> &values) const;
+	const UserMapsBounds &bounds() const;
+	int size() const;
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief Node - box of an item or of a range of nodes one level below.
+	////////////////////////////////////////////////////////////////////////////
+	struct Node
+	{
+		UserMapsBounds m_bounds;	///< Box around the item or the children.
+		int m_first;				///< Value of an item, first child of a node.
+		int m_count;				///< Number of children, 0 for items.
+	};
+
+	static void pack(std::vector<Node> &nodes, std::vector<Node> &parents);
+
+	std::vector<std::vector<Node> > m_levels;	///< Items (level 0) up to the root level.
+	UserMapsBounds m_bounds;					///< Box around all items.
+};
+
+#endif // USERMAPSSPATIALINDEX_H
@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsstyletable.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsStyleTable class, a float texture
+///			holding the drawing style of every user map object.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsstyletable.h"
+#include <QOpenGLContext>
+#include <QDebug>
+#include <algorithm>
+
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814 ///<taken from opengl specifications
+#endif
+
+const int CUserMapsStyleTable::TABLE_WIDTH;
+const int CUserMapsStyleTable::TEXELS_PER_SLOT;
+const int CUserMapsStyleTable::LINE_STYLE_TEXEL;
+const int CUserMapsStyleTable::COLOUR_TEXEL;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsStyleTable::CUserMapsStyleTable()
+///
+/// \brief  Constructor. The texture is created on first bind.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsStyleTable::CUserMapsStyleTable()
+	: m_texture(0),
+	  m_slotCount(0),
+	  m_textureRows(0),
+	  m_dirtyFirstRow(-1),
+	  m_dirtyLastRow(-1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsStyleTable::~CUserMapsStyleTable()
+///
+/// \brief  Destructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsStyleTable::~CUserMapsStyleTable()
+{
+	QOpenGLContext *pContext = QOpenGLContext::currentContext();
+	if ( m_texture != 0 && pContext != nullptr )
+		pContext->functions()->glDeleteTextures(1, &m_texture);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsStyleTable::allocate()
+///
+/// \brief  Allocates a slot for an object.
+///
+/// \return Slot number.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsStyleTable::allocate()
+{
+	if ( !m_freeSlots.empty() )
+	{
+		int slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		return slot;
+	}
+
+	int slot = m_slotCount++;
+	size_t texelCount = static_cast<size_t>(m_slotCount) * TEXELS_PER_SLOT;
+	if ( texelCount > m_texels.size() )
+	{
+		// Grow by whole rows, doubling the table
+		size_t rows = std::max<size_t>(1, m_texels.size() / TABLE_WIDTH);
+		while ( rows * TABLE_WIDTH < texelCount )
+			rows *= 2;
+		m_texels.resize(rows * TABLE_WIDTH, QVector4D());
+	}
+	return slot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsStyleTable::deallocate(int &slot)
+///
+/// \brief  Releases a slot.
+///
+/// \param  slot - Slot to be released, set to -1.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsStyleTable::deallocate(int &slot)
+{
+	if ( slot < 0 )
+		return;
+
+	m_freeSlots.push_back(slot);
+	slot = -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsStyleTable::setTexel(int slot, int texel, const QVector4D &value)
+///
+/// \brief  Sets one texel of a slot.
+///
+/// \param  slot - Slot of the object.
+///         texel - Texel within the slot (e.g. LINE_STYLE_TEXEL).
+///         value - Texel value.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsStyleTable::setTexel(int slot, int texel, const QVector4D &value)
+{
+	if ( slot < 0 )
+		return;
+
+	int index = slot * TEXELS_PER_SLOT + texel;
+	if ( m_texels[static_cast<size_t>(index)] == value )
+		return;
+
+	m_texels[static_cast<size_t>(index)] = value;
+	markDirty(index / TABLE_WIDTH);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsStyleTable::takeChanges(UserMapsStyleChanges &changes)
+///
+/// \brief  Copies the rows changed since the last call, instead of uploading them.
+///
+/// \param  changes - Receives the size of the table and the changed rows.
+///
+/// \return True if anything has changed.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsStyleTable::takeChanges(UserMapsStyleChanges &changes)
+{
+	int rows = static_cast<int>(m_texels.size() / TABLE_WIDTH);
+	bool hasGrown = ( rows != m_textureRows );
+
+	changes.m_rowCount = rows;
+	changes.m_firstRow = m_dirtyFirstRow;
+	changes.m_texels.clear();
+	if ( m_dirtyFirstRow >= 0 )
+	{
+		changes.m_texels.assign(m_texels.begin() + static_cast<long>(m_dirtyFirstRow) * TABLE_WIDTH,
+								m_texels.begin() + static_cast<long>(m_dirtyLastRow + 1) * TABLE_WIDTH);
+	}
+
+	m_textureRows = rows;
+	m_dirtyFirstRow = -1;
+	return hasGrown || changes.m_firstRow >= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsStyleTable::applyChanges(const UserMapsStyleChanges &changes)
+///
+/// \brief  Writes the rows taken from another table. They are uploaded on next bind().
+///
+/// \param  changes - Changes from takeChanges().
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsStyleTable::applyChanges(const UserMapsStyleChanges &changes)
+{
+	size_t texelCount = static_cast<size_t>(changes.m_rowCount) * TABLE_WIDTH;
+	if ( texelCount > m_texels.size() )
+		m_texels.resize(texelCount, QVector4D());
+
+	if ( changes.m_firstRow < 0 || changes.m_texels.empty() )
+		return;
+
+	std::copy(changes.m_texels.begin(), changes.m_texels.end(),
+			  m_texels.begin() + static_cast<long>(changes.m_firstRow) * TABLE_WIDTH);
+	markDirty(changes.m_firstRow);
+	markDirty(changes.m_firstRow + static_cast<int>(changes.m_texels.size() / TABLE_WIDTH) - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsStyleTable::bind(uint unit)
+///
+/// \brief  Uploads changed rows and binds the table. Requires current OpenGL context.
+///
+/// \param  unit - Texture unit.
+///
+/// \return True if the table is bound.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsStyleTable::bind(uint unit)
+{
+	if ( m_texels.empty() )
+		return false;
+
+	QOpenGLFunctions *func = QOpenGLContext::currentContext()->functions();
+	func->glActiveTexture(GL_TEXTURE0 + unit);
+
+	int rows = static_cast<int>(m_texels.size() / TABLE_WIDTH);
+	if ( m_texture == 0 || rows != m_textureRows )
+	{
+		// (Re)create the texture with the whole table
+		if ( m_texture == 0 )
+			func->glGenTextures(1, &m_texture);
+
+		func->glBindTexture(GL_TEXTURE_2D, m_texture);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		func->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		func->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, TABLE_WIDTH, rows, 0, GL_RGBA, GL_FLOAT, m_texels.data());
+
+		m_textureRows = rows;
+		m_dirtyFirstRow = -1;
+	}
+	else
+	{
+		func->glBindTexture(GL_TEXTURE_2D, m_texture);
+		if ( m_dirtyFirstRow >= 0 )
+		{
+			func->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, m_dirtyFirstRow, TABLE_WIDTH, m_dirtyLastRow - m_dirtyFirstRow + 1,
+								  GL_RGBA, GL_FLOAT, &m_texels[static_cast<size_t>(m_dirtyFirstRow) * TABLE_WIDTH]);
+			m_dirtyFirstRow = -1;
+		}
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsStyleTable::release(uint unit)
+///
+/// \brief  Unbinds the table.
+///
+/// \param  unit - Texture unit the table was bound to.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsStyleTable::release(uint unit)
+{
+	QOpenGLFunctions *func = QOpenGLContext::currentContext()->functions();
+	func->glActiveTexture(GL_TEXTURE0 + unit);
+	func->glBindTexture(GL_TEXTURE_2D, 0);
+	func->glActiveTexture(GL_TEXTURE0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsStyleTable::markDirty(int row)
+///
+/// \brief  Remembers a changed row.
+///
+/// \param  row - Changed row.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsStyleTable::markDirty(int row)
+{
+	if ( m_dirtyFirstRow < 0 )
+	{
+		m_dirtyFirstRow = row;
+		m_dirtyLastRow = row;
+		return;
+	}
+
+	m_dirtyFirstRow = std::min(m_dirtyFirstRow, row);
+	m_dirtyLastRow = std::max(m_dirtyLastRow, row);
+}
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsstyletable.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsStyleTable class, a float texture
+///			holding the drawing style of every user map object.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSSTYLETABLE_H
+#define USERMAPSSTYLETABLE_H
+
+#include <QOpenGLFunctions>
+#include <QVector4D>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsStyleChanges - rows changed in a style table, passed from the
+///        table of the geometry worker to the table of the renderer.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsStyleChanges
+{
+	int m_rowCount;					///< Number of rows of the source table.
+	int m_firstRow;					///< First changed row, -1 if none.
+	std::vector<QVector4D> m_texels;	///< Content of the changed rows.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsStyleTable - per object style parameters read by the shaders.
+///
+/// Every object gets a slot of TEXELS_PER_SLOT RGBA32F texels. Vertices carry
+/// only the slot number and the vertex shader fetches the style with
+/// texelFetch, so objects of different styles can share one draw call.
+/// Only rows changed since the last bind are uploaded. A table filled on
+/// another thread hands its changed rows over with takeChanges() instead.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsStyleTable
+{
+public:
+	static const int TABLE_WIDTH = 256;		///< Width of the texture in texels.
+	static const int TEXELS_PER_SLOT = 2;	///< Texels per object, must match the map vertex shader.
+
+	// Texels of a slot
+	static const int LINE_STYLE_TEXEL = 0;	///< Dash size, gap size, dot size, pick id.
+	static const int COLOUR_TEXEL = 1;		///< Palette index and opacity of the fill, then of the outline.
+
+	CUserMapsStyleTable();
+	~CUserMapsStyleTable();
+
+	int allocate();
+	void deallocate(int &slot);
+	void setTexel(int slot, int texel, const QVector4D &value);
+
+	bool takeChanges(UserMapsStyleChanges &changes);
+	void applyChanges(const UserMapsStyleChanges &changes);
+
+	bool bind(uint unit);
+	void release(uint unit);
+
+private:
+	void markDirty(int row);
+
+	GLuint m_texture;					///< OpenGL texture, 0 until first bind.
+	std::vector<QVector4D> m_texels;	///< CPU copy of the table.
+	std::vector<int> m_freeSlots;		///< Released slots.
+	int m_slotCount;					///< Number of slots handed out so far.
+	int m_textureRows;					///< Number of rows allocated in the texture (or taken by takeChanges()).
+	int m_dirtyFirstRow;				///< First row changed since the last upload, -1 if none.
+	int m_dirtyLastRow;					///< Last row changed since the last upload.
+};
+
+#endif // USERMAPSSTYLETABLE_H
@@ -0,0 +1,231 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapstaskpool.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsTaskPool class, a work-stealing thread
+///			pool running the geometry tasks of a synchronisation in parallel.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapstaskpool.h"
+#include <QThread>
+#include <algorithm>
+
+static thread_local int s_currentThread = 0; ///< Number of the pool thread running on this thread.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsTaskPool::CUserMapsTaskPool(int workerCount)
+///
+/// \brief  Constructor. Starts the worker threads.
+///
+/// \param  workerCount - Number of worker threads besides the caller of run(),
+///                       negative for one less than the number of cores.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsTaskPool::CUserMapsTaskPool(int workerCount)
+	: m_pTask(nullptr),
+	  m_generation(0),
+	  m_busyWorkers(0),
+	  m_isStopping(false)
+{
+	if ( workerCount < 0 )
+		workerCount = std::max(QThread::idealThreadCount() - 1, 0);
+
+	for (int i = 0; i <= workerCount; ++i)
+		m_blocks.push_back(std::unique_ptr<TaskBlock>(new TaskBlock()));
+
+	for (int i = 1; i <= workerCount; ++i)
+		m_workers.push_back(std::thread(&CUserMapsTaskPool::workerLoop, this, i));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsTaskPool::~CUserMapsTaskPool()
+///
+/// \brief  Destructor. Stops and joins the worker threads.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsTaskPool::~CUserMapsTaskPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_wakeUp.notify_all();
+
+	for (std::thread &worker : m_workers)
+		worker.join();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsTaskPool::run(int taskCount, const std::function<void(int)> &task)
+///
+/// \brief  Runs task(0) ... task(taskCount - 1) and waits until all are done.
+///         Tasks run in any order and on any thread; results which depend on
+///         the order have to be merged by the caller afterwards.
+///
+/// \param  taskCount - Number of tasks.
+///         task - Function called with the task number.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsTaskPool::run(int taskCount, const std::function<void(int)> &task)
+{
+	if ( taskCount <= 0 )
+		return;
+
+	// Not worth waking anybody up
+	if ( m_workers.empty() || taskCount == 1 )
+	{
+		for (int i = 0; i < taskCount; ++i)
+			task(i);
+		return;
+	}
+
+	// One contiguous block per thread
+	int threads = threadCount();
+	int blockSize = (taskCount + threads - 1) / threads;
+	for (int i = 0; i < threads; ++i)
+	{
+		std::lock_guard<std::mutex> lock(m_blocks[static_cast<size_t>(i)]->m_mutex);
+		m_blocks[static_cast<size_t>(i)]->m_next = std::min(i * blockSize, taskCount);
+		m_blocks[static_cast<size_t>(i)]->m_end = std::min((i + 1) * blockSize, taskCount);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pTask = &task;
+		m_busyWorkers = static_cast<int>(m_workers.size());
+		++m_generation;
+	}
+	m_wakeUp.notify_all();
+
+	execute(0);
+
+	// A task may still be running on a worker
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finished.wait(lock, [this] { return m_busyWorkers == 0; });
+	m_pTask = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsTaskPool::threadCount() const
+///
+/// \brief  Returns number of threads running tasks, including the caller of run().
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsTaskPool::threadCount() const
+{
+	return static_cast<int>(m_blocks.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsTaskPool::currentThread()
+///
+/// \brief  Returns number of the thread running the calling task, 0 for the
+///         caller of run(), below threadCount().
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsTaskPool::currentThread()
+{
+	return s_currentThread;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsTaskPool::workerLoop(int thread)
+///
+/// \brief  Body of a worker thread: waits for a run, takes part in it and
+///         reports back.
+///
+/// \param  thread - Number of the worker thread.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsTaskPool::workerLoop(int thread)
+{
+	unsigned int generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeUp.wait(lock, [&] { return m_isStopping || m_generation != generation; });
+			if ( m_isStopping )
+				return;
+			generation = m_generation;
+		}
+
+		execute(thread);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if ( --m_busyWorkers == 0 )
+			m_finished.notify_one();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsTaskPool::execute(int thread)
+///
+/// \brief  Runs tasks of the own block, then stolen ones, until none are left.
+///
+/// \param  thread - Number of the thread.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsTaskPool::execute(int thread)
+{
+	int task = 0;
+	s_currentThread = thread;
+	while ( takeOwn(thread, task) || steal(thread, task) )
+		(*m_pTask)(task);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsTaskPool::takeOwn(int thread, int &task)
+///
+/// \brief  Takes the next task of the own block.
+///
+/// \param  thread - Number of the thread.
+///         task - Task taken.
+///
+/// \return False if the own block is empty.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsTaskPool::takeOwn(int thread, int &task)
+{
+	TaskBlock &block = *m_blocks[static_cast<size_t>(thread)];
+	std::lock_guard<std::mutex> lock(block.m_mutex);
+	if ( block.m_next >= block.m_end )
+		return false;
+
+	task = block.m_next++;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsTaskPool::steal(int thread, int &task)
+///
+/// \brief  Moves the upper half of another thread's block into the own (empty)
+///         block and takes its first task. Only one block is locked at a time.
+///
+/// \param  thread - Number of the stealing thread.
+///         task - Task taken.
+///
+/// \return False if all blocks are empty.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsTaskPool::steal(int thread, int &task)
+{
+	int threads = threadCount();
+	for (int offset = 1; offset < threads; ++offset)
+	{
+		TaskBlock &victim = *m_blocks[static_cast<size_t>((thread + offset) % threads)];
+		int first = 0;
+		int end = 0;
+		{
+			std::lock_guard<std::mutex> lock(victim.m_mutex);
+			int remaining = victim.m_end - victim.m_next;
+			if ( remaining <= 0 )
+				continue;
+
+			first = victim.m_end - (remaining + 1) / 2;
+			end = victim.m_end;
+			victim.m_end = first;
+		}
+
+		TaskBlock &own = *m_blocks[static_cast<size_t>(thread)];
+		std::lock_guard<std::mutex> lock(own.m_mutex);
+		own.m_next = first + 1;
+		own.m_end = end;
+		task = first;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapstaskpool.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsTaskPool class, a work-stealing thread
+///			pool running the geometry tasks of a synchronisation in parallel.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSTASKPOOL_H
+#define USERMAPSTASKPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsTaskPool - runs numbered tasks on a fixed set of threads.
+///
+/// run() deals the tasks out in contiguous blocks, one block per thread; the
+/// calling thread works on a block as well. A thread that has finished its
+/// own block steals the upper half of what is left in the block of another
+/// thread, so a few expensive tasks (large areas) do not leave threads idle.
+/// run() returns when all tasks are done. Tasks must not call run().
+/// currentThread() tells a task which thread it runs on, e.g. to pick
+/// working memory of its own.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsTaskPool
+{
+public:
+	explicit CUserMapsTaskPool(int workerCount = -1);
+	~CUserMapsTaskPool();
+
+	void run(int taskCount, const std::function<void(int)> &task);
+	int threadCount() const;
+	static int currentThread();
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	/// \brief TaskBlock - tasks not started yet of one thread.
+	////////////////////////////////////////////////////////////////////////////
+	struct TaskBlock
+	{
+		std::mutex m_mutex;		///< Guards the block, also taken by thieves.
+		int m_next;				///< Next task to run.
+		int m_end;				///< One past the last task.
+	};
+
+	void workerLoop(int thread);
+	void execute(int thread);
+	bool takeOwn(int thread, int &task);
+	bool steal(int thread, int &task);
+
+	std::vector<std::thread> m_workers;				///< Worker threads, thread 0 is the caller of run().
+	std::vector<std::unique_ptr<TaskBlock> > m_blocks;	///< Task block of every thread.
+	const std::function<void(int)> *m_pTask;		///< Task function of the current run.
+	std::mutex m_mutex;								///< Guards the run state below.
+	std::condition_variable m_wakeUp;				///< Signals workers a new run or shutdown.
+	std::condition_variable m_finished;				///< Signals the caller the last worker is done.
+	unsigned int m_generation;						///< Incremented for every run.
+	int m_busyWorkers;								///< Workers still working on the current run.
+	bool m_isStopping;								///< True when the workers should exit.
+};
+
+#endif // USERMAPSTASKPOOL_H
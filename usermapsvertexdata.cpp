@@ -1,56 +1,98 @@
-////////////////////////////////////////////////////////////////////////////////
-///	\file	usermapsvertexdata.cpp
-///
-///	\author	ELREG
-///
-///	\brief	definition of the class that holds generic vertex data and linestyle
-///			.
-///
-///	(C) Kelvin Hughes, 2020.
-////////////////////////////////////////////////////////////////////////////////
-#include "usermapsvertexdata.h"
-
-CUserMapsVertexData::CUserMapsVertexData()
-{
-
-}
-
-float CUserMapsVertexData::getDashSize()const {
-	return m_DashSize;
-}
-
-void CUserMapsVertexData::setDashSize(float dashSize) {
-	 m_DashSize = dashSize;
-}
-
-float CUserMapsVertexData::getDotSize()const {
-	return m_DotSize;
-}
-
-void CUserMapsVertexData::setDotSize(float dotSize) {
-	 m_DotSize = dotSize;
-}
-
-float CUserMapsVertexData::getGapSize()const {
-	return m_GapSize;
-}
-
-void CUserMapsVertexData::setGapSize(float gapSize) {
-	 m_GapSize = gapSize;
-}
-
-float CUserMapsVertexData::GetLineWidth() const {
-	return m_LineWidth;
-}
-
-void CUserMapsVertexData::setLineWidth(float lineWidth) {
-	 m_LineWidth = lineWidth;
-}
-
-std::vector<GenericVertexData> CUserMapsVertexData::getVertexData() const {
-	return m_pVertexData;
-}
-
-void CUserMapsVertexData::setVertexData(std::vector<GenericVertexData> vertexData) {
-	m_pVertexData = vertexData;
-}
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsvertexdata.cpp
+///
+///	\author	ELREG
+///
+///	\brief	definition of the class that holds generic vertex data and linestyle
+///			.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsvertexdata.h"
+
+CUserMapsVertexData::CUserMapsVertexData()
+{
+
+}
+
+float CUserMapsVertexData::getDashSize()const {
+	return m_DashSize;
+}
+
+void CUserMapsVertexData::setDashSize(float dashSize) {
+	 m_DashSize = dashSize;
+}
+
+float CUserMapsVertexData::getDotSize()const {
+	return m_DotSize;
+}
+
+void CUserMapsVertexData::setDotSize(float dotSize) {
+	 m_DotSize = dotSize;
+}
+
+float CUserMapsVertexData::getGapSize()const {
+	return m_GapSize;
+}
+
+void CUserMapsVertexData::setGapSize(float gapSize) {
+	 m_GapSize = gapSize;
+}
+
+float CUserMapsVertexData::GetLineWidth() const {
+	return m_LineWidth;
+}
+
+void CUserMapsVertexData::setLineWidth(float lineWidth) {
+	 m_LineWidth = lineWidth;
+}
+
+const std::vector<GenericVertexData> &CUserMapsVertexData::getVertexData() const {
+	return m_pVertexData;
+}
+
+const GenericVertexData &CUserMapsVertexData::vertexAt(size_t index) const {
+	return m_pVertexData[index];
+}
+
+size_t CUserMapsVertexData::vertexCount() const {
+	return m_pVertexData.size();
+}
+
+void CUserMapsVertexData::setVertexData(const std::vector<GenericVertexData> &vertexData) {
+	m_pVertexData = vertexData;
+}
+
+void CUserMapsVertexData::setVertexData(std::vector<GenericVertexData> &&vertexData) {
+	m_pVertexData = std::move(vertexData);
+}
+
+// Keeps the capacity, so an edited object is rebuilt without allocating
+void CUserMapsVertexData::clearVertexData() {
+	m_pVertexData.clear();
+}
+
+void CUserMapsVertexData::reserveVertexData(size_t count) {
+	m_pVertexData.reserve(count);
+}
+
+void CUserMapsVertexData::addVertexData(const GenericVertexData &vertexData) {
+	m_pVertexData.push_back(vertexData);
+}
+
+MapVertexData::MapVertexData(float x, float y, quint32 slot)
+	: m_x(x),
+	  m_y(y),
+	  m_slot(slot)
+{
+
+}
+
+MapPoint::MapPoint()
+	: m_vertexData(QVector4D( 0.0f, 0.0f, 0.0f, 0.0f ), QVector4D(0.0f , 0.0f, 0.0f, 0.0f)),
+	  m_iconSize(0.0f),
+	  m_icon(0),
+	  m_atlasIndex(-1)
+{
+
+}
@@ -1,45 +1,87 @@
-////////////////////////////////////////////////////////////////////////////////
-///	\file	usermapsvertexdata.h
-///
-///	\author	ELREG
-///
-///	\brief	definition of the class that holds generic vertex data and linestyle.
-///
-///
-///	(C) Kelvin Hughes, 2020.
-////////////////////////////////////////////////////////////////////////////////
-#ifndef USERMAPSVERTEXDATA_H
-#define USERMAPSVERTEXDATA_H
-
-#include <vector>
-#include "baserenderer.h"
-#include <QOpenGLBuffer>
-#include <QOpenGLDebugLogger>
-#include "../OpenGLBaseLib/imagetexture.h"
-#include "../OpenGLBaseLib/vertexbuffer.h"
-class CUserMapsVertexData
-{
-public:
-	CUserMapsVertexData();
-	float getDashSize() const;
-	void setDashSize(float dashSize);
-	float getDotSize() const;
-	void setDotSize(float dotSize);
-	float getGapSize() const;
-	void setGapSize(float gapSize);
-	float GetLineWidth() const;
-	void setLineWidth(float lineWidth);
-
-	std::vector<GenericVertexData> getVertexData() const;
-	void setVertexData(std::vector<GenericVertexData> vertexData);
-	void addVertexData(GenericVertexData vertexData);
-
-private:
-	std::vector<GenericVertexData> m_pVertexData; //colour and position data
-	float m_DashSize;///< dash size of the line
-	float m_DotSize; ///<dot size of the line(1 if it is present and 0 if it is not
-	float m_GapSize;///<gap between elements
-	float m_LineWidth;///<gap between elements
-};
-
-#endif // USERMAPSVERTEXDATA_H
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsvertexdata.h
+///
+///	\author	ELREG
+///
+///	\brief	definition of the class that holds generic vertex data and linestyle.
+///
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSVERTEXDATA_H
+#define USERMAPSVERTEXDATA_H
+
+#include <utility>
+#include <vector>
+#include "baserenderer.h"
+#include <QOpenGLBuffer>
+#include <QOpenGLDebugLogger>
+#include "../OpenGLBaseLib/imagetexture.h"
+#include "../OpenGLBaseLib/vertexbuffer.h"
+#include "usermapspalette.h"
+class CUserMapsVertexData
+{
+public:
+	CUserMapsVertexData();
+	float getDashSize() const;
+	void setDashSize(float dashSize);
+	float getDotSize() const;
+	void setDotSize(float dotSize);
+	float getGapSize() const;
+	void setGapSize(float gapSize);
+	float GetLineWidth() const;
+	void setLineWidth(float lineWidth);
+
+	// Vertices are read in place and moved or built in, never copied out
+	const std::vector<GenericVertexData> &getVertexData() const;
+	const GenericVertexData &vertexAt(size_t index) const;
+	size_t vertexCount() const;
+	void setVertexData(const std::vector<GenericVertexData> &vertexData);
+	void setVertexData(std::vector<GenericVertexData> &&vertexData);
+	void clearVertexData();
+	void reserveVertexData(size_t count);
+	void addVertexData(const GenericVertexData &vertexData);
+	template <typename... Args>
+	void emplaceVertexData(Args &&... args) {
+		m_pVertexData.emplace_back(std::forward<Args>(args)...);
+	}
+
+private:
+	std::vector<GenericVertexData> m_pVertexData; //colour and position data
+	float m_DashSize;///< dash size of the line
+	float m_DotSize; ///<dot size of the line(1 if it is present and 0 if it is not
+	float m_GapSize;///<gap between elements
+	float m_LineWidth;///<gap between elements
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///  \brief	Vertex of lines and area outlines as stored in the vertex buffers,
+///			12 bytes. Colour and line style are the same for every vertex of
+///			an object, so they are read from the style table by the slot.
+///
+////////////////////////////////////////////////////////////////////////////////
+struct MapVertexData
+{
+	MapVertexData(float x = 0.0f, float y = 0.0f, quint32 slot = 0);
+	float m_x;			///< X in world space.
+	float m_y;			///< Y in world space.
+	quint32 m_slot;		///< Style table slot of the object.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+///
+///  \brief	This class is used for saving received texture data
+///
+////////////////////////////////////////////////////////////////////////////////
+struct MapPoint
+{
+	MapPoint();
+	GenericVertexData m_vertexData;		///< Position of the point
+	UserMapsColour m_colour;			///< Tint colour of the icon.
+	float m_iconSize;			    ///< Size of an icon.
+	int m_icon;
+	int m_atlasIndex;					///< Index of the icon in the icon atlas, -1 if not loaded.
+};
+
+#endif // USERMAPSVERTEXDATA_H
@@ -0,0 +1,358 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsvertexpool.cpp
+///
+///	\author	ELREG
+///
+///	\brief	Implementation of the CUserMapsVertexPool class, a long-lived OpenGL
+///			vertex buffer which is sub-allocated per user map object.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#include "usermapsvertexpool.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+static const int DIRTY_MERGE_GAP = 256;	///< Dirty ranges closer than this (in vertices) are taken and uploaded together.
+static const int MIN_CAPACITY = 64;		///< Smallest capacity of the CPU copy.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsVertexRange::UserMapsVertexRange(int first, int count)
+///
+/// \brief  Constructor.
+///
+/// \param  first - Index of the first vertex.
+///         count - Number of vertices.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsVertexRange::UserMapsVertexRange(int first, int count)
+	: m_first(first),
+	  m_count(count)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool UserMapsVertexRange::isEmpty() const
+///
+/// \brief  Returns true if the range holds no vertices.
+////////////////////////////////////////////////////////////////////////////////
+bool UserMapsVertexRange::isEmpty() const
+{
+	return m_count <= 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsVertexPool::CUserMapsVertexPool(int vertexSize, int initialCapacity)
+///
+/// \brief  Constructor. The CPU copy is allocated by the first allocate(), the
+///         OpenGL buffer by the first applyChanges().
+///
+/// \param  vertexSize - Size of one vertex in bytes.
+///         initialCapacity - Number of vertices reserved by the first allocation.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsVertexPool::CUserMapsVertexPool(int vertexSize, int initialCapacity)
+	: m_buffer(QOpenGLBuffer::VertexBuffer),
+	  m_vertexSize(vertexSize),
+	  m_initialCapacity(std::max(initialCapacity, MIN_CAPACITY)),
+	  m_capacity(0),
+	  m_bufferCapacity(0),
+	  m_end(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     CUserMapsVertexPool::~CUserMapsVertexPool()
+///
+/// \brief  Destructor.
+////////////////////////////////////////////////////////////////////////////////
+CUserMapsVertexPool::~CUserMapsVertexPool()
+{
+	if ( m_buffer.isCreated() )
+		m_buffer.destroy();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     UserMapsVertexRange CUserMapsVertexPool::allocate(int count)
+///
+/// \brief  Allocates a range of vertices. Unused ranges are reused first (first fit),
+///         otherwise the pool is extended, doubling its capacity if needed.
+///
+/// \param  count - Number of vertices.
+///
+/// \return Allocated range, empty if count is not positive.
+////////////////////////////////////////////////////////////////////////////////
+UserMapsVertexRange CUserMapsVertexPool::allocate(int count)
+{
+	if ( count <= 0 )
+		return UserMapsVertexRange();
+
+	for (std::vector<UserMapsVertexRange>::iterator it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+	{
+		if ( it->m_count < count )
+			continue;
+
+		UserMapsVertexRange range(it->m_first, count);
+		it->m_first += count;
+		it->m_count -= count;
+		if ( it->m_count == 0 )
+			m_freeRanges.erase(it);
+		return range;
+	}
+
+	if ( m_end + count > m_capacity )
+		grow(m_end + count);
+
+	UserMapsVertexRange range(m_end, count);
+	m_end += count;
+	return range;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsVertexPool::deallocate(UserMapsVertexRange &range)
+///
+/// \brief  Returns a range to the pool. The vertices are zeroed so the range
+///         draws as degenerate primitives until it is reused.
+///
+/// \param  range - Range to be released, reset to an empty range.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsVertexPool::deallocate(UserMapsVertexRange &range)
+{
+	if ( range.isEmpty() )
+		return;
+
+	std::memset(m_vertices.data() + static_cast<size_t>(range.m_first) * m_vertexSize, 0,
+				static_cast<size_t>(range.m_count) * m_vertexSize);
+	markDirty(range);
+
+	// Insert keeping the list sorted and merge with neighbours
+	std::vector<UserMapsVertexRange>::iterator it = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), range,
+			[](const UserMapsVertexRange &a, const UserMapsVertexRange &b) { return a.m_first < b.m_first; });
+	it = m_freeRanges.insert(it, range);
+
+	std::vector<UserMapsVertexRange>::iterator next = it + 1;
+	if ( next != m_freeRanges.end() && it->m_first + it->m_count == next->m_first )
+	{
+		it->m_count += next->m_count;
+		m_freeRanges.erase(next);
+	}
+	if ( it != m_freeRanges.begin() )
+	{
+		std::vector<UserMapsVertexRange>::iterator previous = it - 1;
+		if ( previous->m_first + previous->m_count == it->m_first )
+		{
+			previous->m_count += it->m_count;
+			it = m_freeRanges.erase(it) - 1;
+		}
+	}
+
+	// A free range at the end of the pool shrinks the pool
+	if ( it->m_first + it->m_count == m_end )
+	{
+		m_end = it->m_first;
+		m_freeRanges.erase(it);
+	}
+
+	range = UserMapsVertexRange();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsVertexPool::write(const UserMapsVertexRange &range, const void *pData)
+///
+/// \brief  Writes vertices into an allocated range. Data is passed on by the
+///         next takeChanges().
+///
+/// \param  range - Allocated range.
+///         pData - range.m_count vertices.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsVertexPool::write(const UserMapsVertexRange &range, const void *pData)
+{
+	if ( range.isEmpty() )
+		return;
+
+	std::memcpy(m_vertices.data() + static_cast<size_t>(range.m_first) * m_vertexSize, pData,
+				static_cast<size_t>(range.m_count) * m_vertexSize);
+	markDirty(range);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsVertexPool::takeChanges(UserMapsVertexChanges &changes)
+///
+/// \brief  Copies the ranges changed since the last call. Nearby ranges are
+///         merged, the vertices in between copied along, to keep the number of
+///         glBufferSubData calls of applyChanges() low. After the pool has grown
+///         all allocated vertices are copied.
+///
+/// \param  changes - Receives the changed ranges and their content.
+///
+/// \return True if anything has changed.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsVertexPool::takeChanges(UserMapsVertexChanges &changes)
+{
+	changes.m_capacity = m_capacity;
+	changes.m_end = m_end;
+	changes.m_ranges.clear();
+	changes.m_vertices.clear();
+
+	bool hasGrown = ( m_bufferCapacity != m_capacity );
+	if ( hasGrown )
+	{
+		if ( m_end > 0 )
+			changes.m_ranges.push_back(UserMapsVertexRange(0, m_end));
+		m_bufferCapacity = m_capacity;
+	}
+	else
+	{
+		std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end(),
+				  [](const UserMapsVertexRange &a, const UserMapsVertexRange &b) { return a.m_first < b.m_first; });
+
+		for (const UserMapsVertexRange &range : m_dirtyRanges)
+		{
+			if ( !changes.m_ranges.empty() )
+			{
+				UserMapsVertexRange &pending = changes.m_ranges.back();
+				if ( range.m_first <= pending.m_first + pending.m_count + DIRTY_MERGE_GAP )
+				{
+					int end = std::max(pending.m_first + pending.m_count, range.m_first + range.m_count);
+					pending.m_count = end - pending.m_first;
+					continue;
+				}
+			}
+			changes.m_ranges.push_back(range);
+		}
+	}
+	m_dirtyRanges.clear();
+
+	for (const UserMapsVertexRange &range : changes.m_ranges)
+	{
+		const char *pFirst = m_vertices.data() + static_cast<size_t>(range.m_first) * m_vertexSize;
+		changes.m_vertices.insert(changes.m_vertices.end(), pFirst, pFirst + static_cast<size_t>(range.m_count) * m_vertexSize);
+	}
+
+	return hasGrown || !changes.m_ranges.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsVertexPool::applyChanges(const UserMapsVertexChanges &changes)
+///
+/// \brief  Writes the changes taken from another pool straight into the OpenGL
+///         buffer. Requires current OpenGL context.
+///
+/// \param  changes - Changes from takeChanges(), applied in the order taken.
+///
+/// \return True if the changes have been written.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsVertexPool::applyChanges(const UserMapsVertexChanges &changes)
+{
+	if ( !m_buffer.isCreated() )
+	{
+		if ( !m_buffer.create() )
+		{
+			qDebug() << "CUserMapsVertexPool::applyChanges() failed! Buffer could not be created";
+			return false;
+		}
+		m_buffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	}
+
+	m_end = changes.m_end;
+	if ( changes.m_capacity == m_bufferCapacity && changes.m_ranges.empty() )
+		return true;
+
+	m_buffer.bind();
+	if ( changes.m_capacity != m_bufferCapacity )
+	{
+		// Source has grown and passes all its vertices: orphan the old storage
+		m_buffer.allocate(changes.m_capacity * m_vertexSize);
+		m_bufferCapacity = changes.m_capacity;
+		m_capacity = changes.m_capacity;
+	}
+
+	const char *pData = changes.m_vertices.data();
+	for (const UserMapsVertexRange &range : changes.m_ranges)
+	{
+		m_buffer.write(range.m_first * m_vertexSize, pData, range.m_count * m_vertexSize);
+		pData += static_cast<size_t>(range.m_count) * m_vertexSize;
+	}
+	m_buffer.release();
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     bool CUserMapsVertexPool::bind()
+///
+/// \brief  Binds the OpenGL buffer.
+///
+/// \return True if the buffer is bound, false if no changes have been applied yet.
+////////////////////////////////////////////////////////////////////////////////
+bool CUserMapsVertexPool::bind()
+{
+	if ( !m_buffer.isCreated() )
+		return false;
+
+	return m_buffer.bind();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsVertexPool::release()
+///
+/// \brief  Releases the OpenGL buffer.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsVertexPool::release()
+{
+	m_buffer.release();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsVertexPool::vertexCount() const
+///
+/// \brief  Returns number of vertices up to the end of the last allocated range.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsVertexPool::vertexCount() const
+{
+	return m_end;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     int CUserMapsVertexPool::capacity() const
+///
+/// \brief  Returns number of vertices the pool can hold without growing.
+////////////////////////////////////////////////////////////////////////////////
+int CUserMapsVertexPool::capacity() const
+{
+	return m_capacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsVertexPool::grow(int requiredCapacity)
+///
+/// \brief  Doubles the capacity until the required number of vertices fits.
+///
+/// \param  requiredCapacity - Number of vertices that must fit.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsVertexPool::grow(int requiredCapacity)
+{
+	int capacity = std::max(m_capacity, m_initialCapacity);
+	while ( capacity < requiredCapacity )
+		capacity *= 2;
+
+	if ( capacity == m_capacity )
+		return;
+
+	m_vertices.resize(static_cast<size_t>(capacity) * m_vertexSize, 0);
+	m_capacity = capacity;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \fn     void CUserMapsVertexPool::markDirty(const UserMapsVertexRange &range)
+///
+/// \brief  Remembers a range to be passed on by takeChanges().
+///
+/// \param  range - Changed range.
+////////////////////////////////////////////////////////////////////////////////
+void CUserMapsVertexPool::markDirty(const UserMapsVertexRange &range)
+{
+	// Everything is passed on anyway after the pool has grown
+	if ( m_bufferCapacity != m_capacity )
+		return;
+
+	m_dirtyRanges.push_back(range);
+}
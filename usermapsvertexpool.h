@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+///	\file	usermapsvertexpool.h
+///
+///	\author	ELREG
+///
+///	\brief	Declaration of the CUserMapsVertexPool class, a long-lived OpenGL
+///			vertex buffer which is sub-allocated per user map object.
+///
+///	(C) Kelvin Hughes, 2020.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef USERMAPSVERTEXPOOL_H
+#define USERMAPSVERTEXPOOL_H
+
+#include <QOpenGLBuffer>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsVertexRange - range of vertices allocated in a vertex pool.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsVertexRange
+{
+	UserMapsVertexRange(int first = 0, int count = 0);
+	bool isEmpty() const;
+
+	int m_first;	///< Index of the first vertex.
+	int m_count;	///< Number of vertices.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief UserMapsVertexChanges - vertices changed in a pool, passed from the
+///        pool of the geometry worker to the pool of the renderer.
+////////////////////////////////////////////////////////////////////////////////
+struct UserMapsVertexChanges
+{
+	int m_capacity;								///< Capacity of the source pool.
+	int m_end;									///< One past the last allocated vertex of the source pool.
+	std::vector<UserMapsVertexRange> m_ranges;	///< Changed ranges.
+	std::vector<char> m_vertices;				///< Content of the ranges, one after another.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief CUserMapsVertexPool - vertex buffer which lives as long as the renderer.
+///
+/// A pool is used in one of two roles. The pool of the geometry worker keeps
+/// the vertices in a CPU copy, written into ranges allocated per object, and
+/// never creates an OpenGL buffer; takeChanges() copies the ranges changed
+/// since the last call, nearby ranges merged into one. When the pool runs out
+/// of space its capacity is doubled and all allocated vertices are taken once.
+///
+/// The pool of the renderer keeps no CPU copy: applyChanges() writes the
+/// taken ranges straight into its OpenGL buffer (glBufferSubData), and
+/// allocates the buffer again when the capacity of the source has grown,
+/// which then passes all its vertices anyway. The CPU copy of the worker is
+/// the only one, needed there to pass everything on after growing.
+////////////////////////////////////////////////////////////////////////////////
+class CUserMapsVertexPool
+{
+public:
+	CUserMapsVertexPool(int vertexSize, int initialCapacity = 1024);
+	~CUserMapsVertexPool();
+
+	UserMapsVertexRange allocate(int count);
+	void deallocate(UserMapsVertexRange &range);
+	void write(const UserMapsVertexRange &range, const void *pData);
+
+	bool takeChanges(UserMapsVertexChanges &changes);
+	bool applyChanges(const UserMapsVertexChanges &changes);
+
+	bool bind();
+	void release();
+
+	int vertexCount() const;
+	int capacity() const;
+
+private:
+	void grow(int requiredCapacity);
+	void markDirty(const UserMapsVertexRange &range);
+
+	QOpenGLBuffer m_buffer;							///< OpenGL vertex buffer, created by applyChanges() only.
+	std::vector<char> m_vertices;					///< CPU copy of the allocated vertices, empty in the pool of the renderer.
+	std::vector<UserMapsVertexRange> m_freeRanges;	///< Unused ranges below the end of the pool, sorted by position.
+	std::vector<UserMapsVertexRange> m_dirtyRanges;	///< Ranges changed since the last takeChanges().
+	int m_vertexSize;		///< Size of one vertex in bytes.
+	int m_initialCapacity;	///< Number of vertices the CPU copy holds after the first allocation.
+	int m_capacity;			///< Number of vertices the CPU copy can hold.
+	int m_bufferCapacity;	///< Number of vertices allocated in the OpenGL buffer (or taken by takeChanges()).
+	int m_end;				///< One past the last allocated vertex.
+};
+
+#endif // USERMAPSVERTEXPOOL_H